@@ -1,5 +1,6 @@
 #include <algorithm>
 #include <chrono>
+#include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <numeric>
@@ -10,6 +11,10 @@
 #include "fo/core/registry.hpp"
 #include "fo/core/provider_registration.hpp"
 
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
 using steady_clock_t = std::chrono::steady_clock;
 
 static std::vector<std::string> split_csv(const std::string& s) {
@@ -23,6 +28,21 @@ static std::vector<std::string> split_csv(const std::string& s) {
     return out;
 }
 
+// Flushes dirty pages and evicts the page, dentry and inode caches so the next
+// scan has to go to the disk. Needs root on Linux; unavailable elsewhere.
+static bool drop_caches() {
+#ifdef __linux__
+    sync();
+    std::ofstream f("/proc/sys/vm/drop_caches");
+    if (!f) return false;
+    f << "3\n";
+    f.flush();
+    return static_cast<bool>(f);
+#else
+    return false;
+#endif
+}
+
 static double percentile(const std::vector<double>& v, double p) {
     if (v.empty()) return 0.0;
     std::vector<double> c = v;
@@ -36,21 +56,28 @@ static double percentile(const std::vector<double>& v, double p) {
 
 int main(int argc, char** argv) {
     fo::core::register_all_providers();
-    std::string scanner_name = "std";
+    std::vector<std::string> scanner_names = {"std"};
     std::vector<std::filesystem::path> roots;
     std::vector<std::string> exts;
     int iters = 5;
+    unsigned threads = 0;
+    bool cold = false;
 
     for (int i = 1; i < argc; ++i) {
         std::string a = argv[i];
         if (a.rfind("--scanner=", 0) == 0) {
-            scanner_name = a.substr(10);
+            scanner_names = split_csv(a.substr(10));
         } else if (a.rfind("--ext=", 0) == 0) {
             exts = split_csv(a.substr(6));
         } else if (a.rfind("--iters=", 0) == 0) {
             iters = std::max(1, std::stoi(a.substr(8)));
+        } else if (a.rfind("--threads=", 0) == 0) {
+            threads = static_cast<unsigned>(std::stoul(a.substr(10)));
+        } else if (a == "--cold") {
+            cold = true;
         } else if (a == "--help" || a == "-h") {
-            std::cout << "Usage: fo_bench_scanner [--scanner=name] [--ext=.jpg,.png] [--iters=N] DIR...\n";
+            std::cout << "Usage: fo_bench_scanner [--scanner=std,dirent,uring] [--ext=.jpg,.png] [--iters=N] [--threads=N] [--cold] DIR...\n"
+                      << "  --cold  Also measure with caches dropped before every run (Linux, needs root)\n";
             return 0;
         } else {
             roots.emplace_back(a);
@@ -63,38 +90,61 @@ int main(int argc, char** argv) {
     }
 
     auto& reg = fo::core::Registry<fo::core::IFileScanner>::instance();
-    std::unique_ptr<fo::core::IFileScanner> scanner = reg.create(scanner_name);
-    if (!scanner) {
-        std::cerr << "Unknown scanner: " << scanner_name << "\nAvailable:";
-        for (auto& n : reg.names()) std::cerr << " " << n;
-        std::cerr << "\n";
-        return 2;
+    std::vector<std::unique_ptr<fo::core::IFileScanner>> scanners;
+    for (auto& name : scanner_names) {
+        std::unique_ptr<fo::core::IFileScanner> scanner = reg.create(name);
+        if (!scanner) {
+            std::cerr << "Unknown scanner: " << name << "\nAvailable:";
+            for (auto& n : reg.names()) std::cerr << " " << n;
+            std::cerr << "\n";
+            return 2;
+        }
+        scanner->set_threads(threads);
+        scanners.push_back(std::move(scanner));
+    }
+
+    if (cold && !drop_caches()) {
+        std::cerr << "Warning: cannot drop caches (needs root on Linux); skipping cold runs.\n";
+        cold = false;
     }
 
-    std::cout << "Scanner: " << scanner->name() << "\n";
     std::cout << "Iters: " << iters << "\n";
 
-    std::vector<double> files_per_sec;
-    std::uint64_t total_files_last = 0;
-
-    for (int k = 0; k < iters; ++k) {
-        auto t0 = steady_clock_t::now();
-        auto files = scanner->scan(roots, exts, false);
-        auto t1 = steady_clock_t::now();
-        std::chrono::duration<double> dt = t1 - t0;
-        double secs = dt.count();
-        double fps = files.empty() ? 0.0 : (files.size() / secs);
-        files_per_sec.push_back(fps);
-        total_files_last = static_cast<std::uint64_t>(files.size());
-        std::cout << "Run " << (k+1) << ": files=" << files.size() << ", time=" << std::fixed << std::setprecision(3) << secs << "s, throughput=" << std::setprecision(1) << fps << " files/s\n";
-    }
+    auto bench = [&](fo::core::IFileScanner& scanner, bool cold_run) {
+        const char* mode = cold_run ? "cold" : "warm";
+        std::cout << "Scanner: " << scanner.name() << " (" << mode << ")\n";
 
-    double med = percentile(files_per_sec, 50.0);
-    double p90 = percentile(files_per_sec, 90.0);
+        // Warm runs start from a populated cache
+        if (!cold_run) scanner.scan(roots, exts, false);
 
-    std::cout << "Summary: files_last=" << total_files_last
-              << ", median_throughput=" << std::fixed << std::setprecision(1) << med
-              << " files/s, p90=" << p90 << " files/s\n";
+        std::vector<double> files_per_sec;
+        std::uint64_t total_files_last = 0;
+
+        for (int k = 0; k < iters; ++k) {
+            if (cold_run) drop_caches();
+            auto t0 = steady_clock_t::now();
+            auto files = scanner.scan(roots, exts, false);
+            auto t1 = steady_clock_t::now();
+            std::chrono::duration<double> dt = t1 - t0;
+            double secs = dt.count();
+            double fps = files.empty() ? 0.0 : (files.size() / secs);
+            files_per_sec.push_back(fps);
+            total_files_last = static_cast<std::uint64_t>(files.size());
+            std::cout << "Run " << (k+1) << ": files=" << files.size() << ", time=" << std::fixed << std::setprecision(3) << secs << "s, throughput=" << std::setprecision(1) << fps << " files/s\n";
+        }
+
+        double med = percentile(files_per_sec, 50.0);
+        double p90 = percentile(files_per_sec, 90.0);
+
+        std::cout << "Summary[" << scanner.name() << "," << mode << "]: files_last=" << total_files_last
+                  << ", median_throughput=" << std::fixed << std::setprecision(1) << med
+                  << " files/s, p90=" << p90 << " files/s\n";
+    };
+
+    for (auto& scanner : scanners) {
+        if (cold) bench(*scanner, true);
+        bench(*scanner, false);
+    }
 
     return 0;
 }
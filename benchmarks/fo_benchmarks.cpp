@@ -2,9 +2,19 @@
 #include "fo/core/registry.hpp"
 #include "fo/core/interfaces.hpp"
 #include "fo/core/provider_registration.hpp"
+#include "fo/core/database.hpp"
+#include "fo/core/duplicate_repository.hpp"
+#include "fo/core/file_reader.hpp"
+#include "fo/core/hash_executor.hpp"
+#include "fo/core/file_repository.hpp"
+#include <sqlite3.h>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <algorithm>
+#include <random>
+#include <array>
+#include <span>
 
 namespace fs = std::filesystem;
 
@@ -53,6 +63,21 @@ BENCHMARK_DEFINE_F(ScannerFixture, ScanStd)(benchmark::State& state) {
 }
 BENCHMARK_REGISTER_F(ScannerFixture, ScanStd);
 
+BENCHMARK_DEFINE_F(ScannerFixture, ScanParallel)(benchmark::State& state) {
+    auto scanner = fo::core::Registry<fo::core::IFileScanner>::instance().create("parallel");
+    if (!scanner) { state.SkipWithError("parallel scanner not found"); return; }
+    scanner->set_threads(static_cast<unsigned>(state.range(0)));
+
+    std::vector<fs::path> roots = {test_dir};
+    std::vector<std::string> exts; // all
+
+    for (auto _ : state) {
+        auto files = scanner->scan(roots, exts, false);
+        benchmark::DoNotOptimize(files);
+    }
+}
+BENCHMARK_REGISTER_F(ScannerFixture, ScanParallel)->Arg(1)->Arg(4)->Arg(16);
+
 #ifdef _WIN32
 BENCHMARK_DEFINE_F(ScannerFixture, ScanWin32)(benchmark::State& state) {
     auto scanner = fo::core::Registry<fo::core::IFileScanner>::instance().create("win32");
@@ -69,52 +94,332 @@ BENCHMARK_DEFINE_F(ScannerFixture, ScanWin32)(benchmark::State& state) {
 BENCHMARK_REGISTER_F(ScannerFixture, ScanWin32);
 #endif
 
-static void BM_Hasher_Fast64(benchmark::State& state) {
-    fs::path path = fs::temp_directory_path() / "fo_bench_hash.tmp";
-    {
-        std::ofstream ofs(path, std::ios::binary);
-        std::vector<char> data(1024 * 1024, 'a'); // 1MB
-        ofs.write(data.data(), data.size());
+// Hasher throughput per file size, with the file in the page cache.
+// bytes_per_second counts the whole file even for sampling fast64 hashers,
+// so it reads as "files of this size per second" in bytes.
+static fs::path write_bench_file(std::int64_t size) {
+    fs::path path = fs::temp_directory_path() / ("fo_bench_hash_" + std::to_string(size) + ".tmp");
+    std::vector<char> block(1024 * 1024);
+    std::mt19937_64 rng(42);
+    for (auto& c : block) c = static_cast<char>(rng());
+    std::ofstream ofs(path, std::ios::binary);
+    for (std::int64_t left = size; left > 0; left -= static_cast<std::int64_t>(block.size())) {
+        ofs.write(block.data(), std::min<std::int64_t>(left, static_cast<std::int64_t>(block.size())));
     }
-    
-    auto hasher = fo::core::Registry<fo::core::IHasher>::instance().create("fast64");
+    return path;
+}
+
+static void BM_Hasher(benchmark::State& state, const char* name, bool strong) {
+    auto hasher = fo::core::Registry<fo::core::IHasher>::instance().create(name);
     if (!hasher) {
-        state.SkipWithError("fast64 hasher not found");
-        fs::remove(path);
+        state.SkipWithError("hasher not found");
         return;
     }
+    const fs::path path = write_bench_file(state.range(0));
 
     for (auto _ : state) {
-        std::string h = hasher->fast64(path);
-        benchmark::DoNotOptimize(h);
+        if (strong) {
+            auto h = hasher->strong(path);
+            benchmark::DoNotOptimize(h);
+        } else {
+            std::string h = hasher->fast64(path);
+            benchmark::DoNotOptimize(h);
+        }
     }
-    state.SetBytesProcessed(state.iterations() * 1024 * 1024);
+    state.SetBytesProcessed(state.iterations() * state.range(0));
     fs::remove(path);
 }
-BENCHMARK(BM_Hasher_Fast64);
+BENCHMARK_CAPTURE(BM_Hasher, fast64, "fast64", false)->Arg(4 << 10)->Arg(1 << 20)->Arg(1 << 30)->ArgNames({"bytes"});
+BENCHMARK_CAPTURE(BM_Hasher, xxhash, "xxhash", false)->Arg(4 << 10)->Arg(1 << 20)->Arg(1 << 30)->ArgNames({"bytes"});
+BENCHMARK_CAPTURE(BM_Hasher, sha256, "sha256", true)->Arg(4 << 10)->Arg(1 << 20)->Arg(1 << 30)->ArgNames({"bytes"});
+BENCHMARK_CAPTURE(BM_Hasher, blake3, "blake3", true)->Arg(4 << 10)->Arg(1 << 20)->Arg(1 << 30)->ArgNames({"bytes"});
 
-static void BM_Hasher_Blake3(benchmark::State& state) {
-    fs::path path = fs::temp_directory_path() / "fo_bench_hash_b3.tmp";
-    {
-        std::ofstream ofs(path, std::ios::binary);
-        std::vector<char> data(1024 * 1024, 'a'); // 1MB
-        ofs.write(data.data(), data.size());
+// The read path alone: a whole file through std::ifstream into a 64 KB
+// buffer, as the hashers used to read, or through fo::core::FileReader with
+// preads (reader:1) or mapping files from 1 MB (reader:2). Summing the bytes
+// stands in for a hash that keeps up with memory.
+static void BM_FileRead(benchmark::State& state) {
+    const fs::path path = write_bench_file(state.range(0));
+    const bool use_reader = state.range(1) != 0;
+    fo::core::FileReader reader(state.range(1) == 2 ? 1 << 20 : fo::core::FileReader::kNeverMap);
+    std::array<char, 64 * 1024> buf{};
+
+    auto sum = [](const unsigned char* p, std::size_t n) {
+        std::uint64_t s = 0;
+        for (std::size_t i = 0; i < n; ++i) s += p[i];
+        return s;
+    };
+    for (auto _ : state) {
+        std::uint64_t total = 0;
+        if (use_reader) {
+            reader.open(path, fo::core::FileReader::Access::Sequential);
+            reader.for_each_block([&](std::span<const std::uint8_t> block) { total += sum(block.data(), block.size()); });
+            reader.close();
+        } else {
+            std::ifstream f(path, std::ios::binary);
+            while (f) {
+                f.read(buf.data(), buf.size());
+                total += sum(reinterpret_cast<const unsigned char*>(buf.data()), static_cast<std::size_t>(f.gcount()));
+            }
+        }
+        benchmark::DoNotOptimize(total);
     }
-    
-    auto hasher = fo::core::Registry<fo::core::IHasher>::instance().create("blake3");
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+    fs::remove(path);
+}
+BENCHMARK(BM_FileRead)->ArgsProduct({{4 << 10, 1 << 20, 1 << 30}, {0, 1, 2}})->ArgNames({"bytes", "reader"});
+
+// Hashing 256 cached 1 MB files of one size with xxhash (which reads the whole
+// file) on a HashExecutor with 1, 4 or 16 workers.
+static void BM_HashExecutor(benchmark::State& state) {
+    auto hasher = fo::core::Registry<fo::core::IHasher>::instance().create("xxhash");
     if (!hasher) {
-        state.SkipWithError("blake3 hasher not found");
-        fs::remove(path);
+        state.SkipWithError("hasher not found");
         return;
     }
+    const fs::path dir = fs::temp_directory_path() / "fo_bench_executor";
+    fs::create_directories(dir);
+    std::vector<fo::core::FileInfo> files(256);
+    std::mt19937_64 rng(7);
+    std::vector<char> data(1 << 20);
+    for (size_t i = 0; i < files.size(); ++i) {
+        for (auto& c : data) c = static_cast<char>(rng());
+        files[i].path = dir / ("f" + std::to_string(i) + ".bin");
+        files[i].size = data.size();
+        std::ofstream(files[i].path, std::ios::binary).write(data.data(), static_cast<std::streamsize>(data.size()));
+    }
+    std::vector<fo::core::HashBucket> buckets(1);
+    for (auto& f : files) buckets[0].files.push_back(&f);
 
+    fo::core::HashExecutor executor(static_cast<unsigned>(state.range(0)));
     for (auto _ : state) {
-        auto h = hasher->strong(path);
-        benchmark::DoNotOptimize(h);
+        executor.run(buckets, *hasher, [&](fo::core::IHasher& h, const fo::core::FileInfo& f) {
+            return executor.read([&] { return h.fast64(f.path); });
+        });
+        benchmark::DoNotOptimize(buckets[0].hashes.data());
     }
-    state.SetBytesProcessed(state.iterations() * 1024 * 1024);
-    fs::remove(path);
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(files.size() * data.size()));
+    fs::remove_all(dir);
+}
+BENCHMARK(BM_HashExecutor)->Arg(1)->Arg(4)->Arg(16)->ArgNames({"jobs"})->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// Duplicate finders over 128 cached 1 MB files of one size: 16 identical
+// pairs and 96 files that differ from the first byte on. Runs single-threaded.
+static void BM_DuplicateFinder(benchmark::State& state, const char* name) {
+    auto finder = fo::core::Registry<fo::core::IDuplicateFinder>::instance().create(name);
+    auto hasher = fo::core::Registry<fo::core::IHasher>::instance().create("fast64");
+    if (!finder || !hasher) {
+        state.SkipWithError("finder or hasher not found");
+        return;
+    }
+    const fs::path dir = fs::temp_directory_path() / "fo_bench_finder";
+    fs::create_directories(dir);
+    std::vector<fo::core::FileInfo> files(128);
+    std::mt19937_64 rng(11);
+    std::vector<char> data(1 << 20);
+    for (size_t i = 0; i < files.size(); ++i) {
+        const bool copy_of_previous = i < 32 && i % 2 == 1;
+        if (!copy_of_previous) {
+            for (auto& c : data) c = static_cast<char>(rng());
+        }
+        files[i].path = dir / ("f" + std::to_string(i) + ".bin");
+        files[i].size = data.size();
+        std::ofstream(files[i].path, std::ios::binary).write(data.data(), static_cast<std::streamsize>(data.size()));
+    }
+
+    for (auto _ : state) {
+        auto groups = finder->group(files, *hasher);
+        if (groups.size() != 16) state.SkipWithError("wrong number of groups");
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(files.size() * data.size()));
+    fs::remove_all(dir);
+}
+BENCHMARK_CAPTURE(BM_DuplicateFinder, size_hash, "size_hash")->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_DuplicateFinder, size_hash_byte, "size_hash_byte")->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_DuplicateFinder, multistage, "multistage")->Unit(benchmark::kMillisecond);
+
+// Catalog write throughput. items_per_second is rows/sec; the PreparePerRow
+// variant is how repositories worked before DatabaseManager cached statements.
+static constexpr int kDbRows = 10000;
+static const char* kDbInsertSql = "INSERT INTO files (path, size, mtime, is_dir) VALUES (?, ?, ?, 0);";
+
+static void BM_Db_InsertPreparePerRow(benchmark::State& state) {
+    for (auto _ : state) {
+        fo::core::DatabaseManager db;
+        db.open(":memory:");
+        db.migrate();
+        db.execute("BEGIN;");
+        for (int i = 0; i < kDbRows; ++i) {
+            sqlite3_stmt* stmt;
+            sqlite3_prepare_v2(db.get_db(), kDbInsertSql, -1, &stmt, nullptr);
+            std::string path = "/bench/file_" + std::to_string(i);
+            sqlite3_bind_text(stmt, 1, path.c_str(), -1, SQLITE_STATIC);
+            sqlite3_bind_int64(stmt, 2, i);
+            sqlite3_bind_int64(stmt, 3, i);
+            sqlite3_step(stmt);
+            sqlite3_finalize(stmt);
+        }
+        db.execute("COMMIT;");
+    }
+    state.SetItemsProcessed(state.iterations() * kDbRows);
+}
+BENCHMARK(BM_Db_InsertPreparePerRow)->Unit(benchmark::kMillisecond);
+
+static void BM_Db_InsertCachedStatement(benchmark::State& state) {
+    for (auto _ : state) {
+        fo::core::DatabaseManager db;
+        db.open(":memory:");
+        db.migrate();
+        db.execute("BEGIN;");
+        for (int i = 0; i < kDbRows; ++i) {
+            auto stmt = db.prepare(kDbInsertSql);
+            std::string path = "/bench/file_" + std::to_string(i);
+            sqlite3_bind_text(stmt, 1, path.c_str(), -1, SQLITE_STATIC);
+            sqlite3_bind_int64(stmt, 2, i);
+            sqlite3_bind_int64(stmt, 3, i);
+            sqlite3_step(stmt);
+        }
+        db.execute("COMMIT;");
+    }
+    state.SetItemsProcessed(state.iterations() * kDbRows);
+}
+BENCHMARK(BM_Db_InsertCachedStatement)->Unit(benchmark::kMillisecond);
+
+// FileRepository::upsert of new files, then again unchanged (lookup only)
+static void BM_Db_RepositoryUpsert(benchmark::State& state) {
+    const bool rescan = state.range(0) != 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        fo::core::DatabaseManager db;
+        db.open(":memory:");
+        db.migrate();
+        fo::core::FileRepository repo(db);
+        std::vector<fo::core::FileInfo> files(kDbRows);
+        for (int i = 0; i < kDbRows; ++i) {
+            files[i].path = "/bench/file_" + std::to_string(i);
+            files[i].size = static_cast<std::uintmax_t>(i);
+        }
+        if (rescan) {
+            db.execute("BEGIN;");
+            for (auto& f : files) repo.upsert(f);
+            db.execute("COMMIT;");
+        }
+        state.ResumeTiming();
+
+        db.execute("BEGIN;");
+        for (auto& f : files) repo.upsert(f);
+        db.execute("COMMIT;");
+    }
+    state.SetItemsProcessed(state.iterations() * kDbRows);
+}
+BENCHMARK(BM_Db_RepositoryUpsert)->Arg(0)->Arg(1)->ArgNames({"rescan"})->Unit(benchmark::kMillisecond);
+
+// Same rows through FileRepository::upsert_batch in scanner-sized batches of
+// 4096, into :memory: (on_disk:0) or a database file in the temp directory.
+static void BM_Db_BulkUpsert(benchmark::State& state) {
+    const bool rescan = state.range(0) != 0;
+    const bool on_disk = state.range(1) != 0;
+    const fs::path db_file = fs::temp_directory_path() / "fo_bench_bulk.db";
+    constexpr std::size_t kBatch = 4096;
+    for (auto _ : state) {
+        state.PauseTiming();
+        fs::remove(db_file);
+        fo::core::DatabaseManager db;
+        db.open(on_disk ? db_file : fs::path(":memory:"));
+        db.migrate();
+        fo::core::FileRepository repo(db);
+        std::vector<fo::core::FileInfo> files(kDbRows);
+        for (int i = 0; i < kDbRows; ++i) {
+            files[i].path = "/bench/file_" + std::to_string(i);
+            files[i].size = static_cast<std::uintmax_t>(i);
+        }
+        auto write_all = [&]() {
+            db.execute("BEGIN;");
+            for (std::size_t at = 0; at < files.size(); at += kBatch) {
+                std::vector<fo::core::FileInfo> batch(files.begin() + at, files.begin() + std::min(files.size(), at + kBatch));
+                repo.upsert_batch(batch, {});
+            }
+            db.execute("COMMIT;");
+        };
+        if (rescan) write_all();
+        state.ResumeTiming();
+
+        write_all();
+    }
+    fs::remove(db_file);
+    state.SetItemsProcessed(state.iterations() * kDbRows);
+}
+BENCHMARK(BM_Db_BulkUpsert)->ArgsProduct({{0, 1}, {0, 1}})->ArgNames({"rescan", "on_disk"})->Unit(benchmark::kMillisecond);
+
+// find_similar over 100k random dhash values. Thresholds up to 15 probe the
+// phash_bands multi-index; 16 falls back to scanning every hash.
+static void BM_Db_SimilarSearch(benchmark::State& state) {
+    const int threshold = static_cast<int>(state.range(0));
+    constexpr int kHashes = 100000;
+    fo::core::DatabaseManager db;
+    db.open(":memory:");
+    db.migrate();
+    fo::core::FileRepository repo(db);
+    std::mt19937_64 rng(7);
+    db.execute("BEGIN;");
+    for (int i = 0; i < kHashes; ++i) {
+        fo::core::FileInfo f;
+        f.path = "/bench/img_" + std::to_string(i) + ".jpg";
+        repo.upsert(f);
+        repo.add_hash(f.id, "dhash", fo::core::HashDigest::from_u64(rng()));
+    }
+    db.execute("COMMIT;");
+
+    std::size_t found = 0;
+    for (auto _ : state) {
+        auto matches = repo.find_similar(rng(), threshold);
+        found += matches.size();
+        benchmark::DoNotOptimize(matches);
+    }
+    state.counters["matches"] = benchmark::Counter(static_cast<double>(found), benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_Db_SimilarSearch)->Arg(4)->Arg(10)->Arg(16)->ArgNames({"threshold"})->Unit(benchmark::kMillisecond);
+
+// Reading 20k duplicate groups of three with their file rows: get_all_groups
+// plus get_by_id per member (streamed:0), as delete-duplicates used to, versus
+// one DuplicateRepository::for_each_group query (streamed:1).
+static void BM_Db_DuplicateGroups(benchmark::State& state) {
+    const bool streamed = state.range(0) != 0;
+    constexpr int kGroups = 20000;
+    fo::core::DatabaseManager db;
+    db.open(":memory:");
+    db.migrate();
+    fo::core::FileRepository files(db);
+    fo::core::DuplicateRepository dups(db);
+    std::vector<std::vector<int64_t>> groups(kGroups);
+    db.execute("BEGIN;");
+    for (int g = 0; g < kGroups; ++g) {
+        for (int i = 0; i < 3; ++i) {
+            fo::core::FileInfo f;
+            f.path = "/bench/dup_" + std::to_string(g) + "_" + std::to_string(i);
+            files.upsert(f);
+            groups[g].push_back(f.id);
+        }
+    }
+    dups.create_groups(groups);
+    db.execute("COMMIT;");
+
+    for (auto _ : state) {
+        std::size_t rows = 0;
+        if (streamed) {
+            dups.for_each_group([&](fo::core::DuplicateGroupFiles& g) {
+                rows += g.files.size();
+                return true;
+            });
+        } else {
+            for (const auto& g : dups.get_all_groups()) {
+                for (auto id : g.member_ids) rows += files.get_by_id(id).has_value();
+            }
+        }
+        benchmark::DoNotOptimize(rows);
+    }
+    state.SetItemsProcessed(state.iterations() * kGroups);
 }
-BENCHMARK(BM_Hasher_Blake3);
+BENCHMARK(BM_Db_DuplicateGroups)->Arg(0)->Arg(1)->ArgNames({"streamed"})->Unit(benchmark::kMillisecond);
 
 BENCHMARK_MAIN();
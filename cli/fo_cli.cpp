@@ -8,6 +8,12 @@
 #include "fo/core/export.hpp"
 #include "fo/core/version.hpp"
 #include "fo/core/operation_repository.hpp"
+#include "fo/core/catalog_writer.hpp"
+#ifdef __linux__
+#include "fo/core/file_watcher.hpp"
+#endif
+#include <algorithm>
+#include <csignal>
 #include <iostream>
 #include <string>
 #include <vector>
@@ -18,6 +24,9 @@
 
 using namespace std::chrono;
 
+static volatile std::sig_atomic_t g_stop = 0;
+static void on_stop_signal(int) { g_stop = 1; }
+
 static void print_usage() {
     std::cout << "FileOrganizer v" << fo::core::FO_VERSION << "\n";
     std::cout << "Usage: fo_cli <command> [options] [paths...]\n"
@@ -35,9 +44,14 @@ static void print_usage() {
               << "  export       Export scan results to JSON/CSV/HTML\n"
               << "  undo         Undo the last file operation\n"
               << "  history      Show operation history\n"
+              << "  watch        Scan, then keep the database in sync with file changes (Linux)\n"
               << "\nOptions:\n"
-              << "  --scanner=<name>    Select scanner (e.g., std, win32, dirent)\n"
+              << "  --scanner=<name>    Select scanner (e.g., std, win32, dirent, parallel, linux, uring)\n"
+              << "  --threads=<N>       Worker threads for the parallel scanner (default: all cores)\n"
               << "  --hasher=<name>     Select hasher (e.g., fast64, blake3)\n"
+              << "  --finder=<name>     Duplicate finder, e.g. multistage (default: incremental size+fast64)\n"
+              << "  --jobs=<N>          Hashing threads for duplicates (default: all cores)\n"
+              << "  --io-jobs=<N>       Files read at once while hashing, e.g. 1 for spinning disks (default: no cap)\n"
               << "  --db=<path>         Database path (default: fo.db)\n"
               << "  --rule=<template>   Organization rule (e.g., '/Photos/{year}/{month}')\n"
               << "  --rules=<file.yaml> Load organization rules from YAML file\n"
@@ -47,13 +61,20 @@ static void print_usage() {
               << "  --dry-run           Simulate organization without moving files\n"
               << "  --ext=<.jpg,.png>   Comma-separated list of extensions\n"
               << "  --follow-symlinks   Follow symbolic links\n"
+              << "  --prune             Remove deleted files from the database during scan\n"
+              << "  --incremental       Skip folders unchanged since the last scan (implies --prune)\n"
+              << "  --resume            Continue an interrupted scan of the same paths and options\n"
+              << "  --snapshot-index    On rescans, compare files against an in-memory index of the catalog\n"
+              << "  --watch-backend=<b> File change backend for watch: auto, fanotify, inotify (default: auto)\n"
               << "  --format=<fmt>      Output format (json, csv, html)\n"
               << "  --threshold=<N>     Similarity threshold (default: 10)\n"
               << "  --phash=<algo>      Perceptual hash algorithm (dhash, phash, ahash)\n"
-              << "  --use-ads-cache     Use Windows NTFS Alternate Data Streams for hash caching\n"
+              << "  --sidecar-cache=<c> Keep hashes with the files: ads (NTFS streams), xattr (Linux user.fo_cache)\n"
+              << "  --use-ads-cache     Same as --sidecar-cache=ads\n"
               << "  --thumbnails        Include thumbnails in HTML export (images only)\n"
               << "  --list-scanners     List available scanners\n"
               << "  --list-hashers      List available hashers\n"
+              << "  --list-finders      List available duplicate finders\n"
               << "  --list-metadata     List available metadata providers\n"
               << "  --list-ocr          List available OCR providers\n"
               << "  --list-classifiers  List available classifiers\n"
@@ -123,6 +144,16 @@ int main(int argc, char** argv) {
         for (const auto& n : phash.names()) std::cout << n << " ";
         std::cout << "\n";
 
+        auto& sidecars = fo::core::Registry<fo::core::ISidecarHashCache>::instance();
+        std::cout << "  Sidecar Caches: ";
+        for (const auto& n : sidecars.names()) std::cout << n << " ";
+        std::cout << "\n";
+
+        auto& finders = fo::core::Registry<fo::core::IDuplicateFinder>::instance();
+        std::cout << "  Duplicate Finders: ";
+        for (const auto& n : finders.names()) std::cout << n << " ";
+        std::cout << "\n";
+
         return 0;
     }
     if (command == "--list-scanners") {
@@ -139,6 +170,13 @@ int main(int argc, char** argv) {
         std::cout << "\n";
         return 0;
     }
+    if (command == "--list-finders") {
+        auto& reg = fo::core::Registry<fo::core::IDuplicateFinder>::instance();
+        std::cout << "Available duplicate finders:";
+        for (auto& n : reg.names()) std::cout << " " << n;
+        std::cout << "\n";
+        return 0;
+    }
     if (command == "--list-metadata") {
         auto& reg = fo::core::Registry<fo::core::IMetadataProvider>::instance();
         std::cout << "Available metadata providers:";
@@ -179,6 +217,7 @@ int main(int argc, char** argv) {
     std::string keep_strategy = "oldest";
     std::string output_path;
     std::string phash_algo = "dhash";
+    std::string watch_backend = "auto";
     bool dry_run = false;
     bool prune = false;
     bool include_thumbnails = false;
@@ -202,6 +241,13 @@ int main(int argc, char** argv) {
             std::cout << "\n";
             return 0;
         }
+        else if (a == "--list-finders") {
+            auto& reg = fo::core::Registry<fo::core::IDuplicateFinder>::instance();
+            std::cout << "Available duplicate finders:";
+            for (auto& n : reg.names()) std::cout << " " << n;
+            std::cout << "\n";
+            return 0;
+        }
         else if (a == "--list-metadata") {
             auto& reg = fo::core::Registry<fo::core::IMetadataProvider>::instance();
             std::cout << "Available metadata providers:";
@@ -231,8 +277,13 @@ int main(int argc, char** argv) {
             return 0;
         }
         else if (a.rfind("--phash=", 0) == 0) phash_algo = a.substr(8);
+        else if (a.rfind("--watch-backend=", 0) == 0) watch_backend = a.substr(16);
         else if (a.rfind("--scanner=", 0) == 0) cfg.scanner = a.substr(10);
+        else if (a.rfind("--threads=", 0) == 0) cfg.scan_threads = static_cast<unsigned>(std::stoul(a.substr(10)));
         else if (a.rfind("--hasher=", 0) == 0) cfg.hasher = a.substr(9);
+        else if (a.rfind("--finder=", 0) == 0) cfg.finder = a.substr(9);
+        else if (a.rfind("--jobs=", 0) == 0) cfg.hash_jobs = static_cast<unsigned>(std::stoul(a.substr(7)));
+        else if (a.rfind("--io-jobs=", 0) == 0) cfg.hash_io_jobs = static_cast<unsigned>(std::stoul(a.substr(10)));
         else if (a.rfind("--db=", 0) == 0) cfg.db_path = a.substr(5);
         else if (a.rfind("--rule=", 0) == 0) rule_template = a.substr(7);
         else if (a.rfind("--rules=", 0) == 0) rules_file = a.substr(8);
@@ -240,8 +291,12 @@ int main(int argc, char** argv) {
         else if (a.rfind("--keep=", 0) == 0) keep_strategy = a.substr(7);
         else if (a.rfind("--output=", 0) == 0) output_path = a.substr(9);
         else if (a == "--dry-run") dry_run = true;
-        else if (a == "--prune" || a == "--incremental") prune = true;
-        else if (a == "--use-ads-cache") cfg.use_ads_cache = true;
+        else if (a == "--prune") prune = true;
+        else if (a == "--incremental") { prune = true; cfg.incremental_dirs = true; }
+        else if (a == "--resume") cfg.resume_scans = true;
+        else if (a == "--snapshot-index") cfg.snapshot_index = true;
+        else if (a.rfind("--sidecar-cache=", 0) == 0) cfg.sidecar_cache = a.substr(16);
+        else if (a == "--use-ads-cache") cfg.sidecar_cache = "ads";
         else if (a == "--thumbnails") include_thumbnails = true;
         else if (a.rfind("--lang=", 0) == 0) lang = a.substr(7);
         else if (a.rfind("--threshold=", 0) == 0) threshold = std::stoi(a.substr(12));
@@ -270,24 +325,34 @@ int main(int argc, char** argv) {
         fo::core::Engine engine(cfg);
 
         if (command == "scan") {
-            auto files = engine.scan(roots, exts, follow_symlinks, prune);
-            if (format == "json") {
-                std::cout << "[\n";
-                for (size_t i = 0; i < files.size(); ++i) {
-                    std::cout << "  {\"path\": \"" << fo::core::Exporter::json_escape(files[i].path.string())
-                              << "\", \"size\": " << files[i].size << "}";
-                    if (i + 1 < files.size()) std::cout << ",";
-                    std::cout << "\n";
-                }
-                std::cout << "]\n";
-            } else {
-                for (const auto& f : files) {
-                    std::cout << f.path.string() << "\n";
+            // Print batches as the engine commits them instead of holding the whole tree
+            const bool json = format == "json";
+            bool first = true;
+            if (json) std::cout << "[";
+            engine.scan(roots, exts, follow_symlinks, prune, [&](std::vector<fo::core::FileInfo>& batch) {
+                for (const auto& f : batch) {
+                    if (json) {
+                        std::cout << (first ? "\n" : ",\n");
+                        std::cout << "  {\"path\": \"" << fo::core::Exporter::json_escape(f.path.string())
+                                  << "\", \"size\": " << f.size << "}";
+                    } else {
+                        std::cout << f.path.string() << "\n";
+                    }
+                    first = false;
                 }
-            }
+            });
+            if (json) std::cout << "\n]\n";
         } else if (command == "duplicates") {
             auto files = engine.scan(roots, exts, follow_symlinks, prune);
             auto groups = engine.find_duplicates(files);
+            if (auto* finder = engine.finder()) {
+                // Stage report on stderr, so JSON output stays parseable
+                for (const auto& s : finder->stage_stats()) {
+                    std::cerr << finder->name() << " " << s.stage << ": " << s.candidates << " files, "
+                              << (s.candidates - s.remaining) << " eliminated, "
+                              << s.bytes_read << " bytes read\n";
+                }
+            }
             if (format == "json") {
                 std::cout << "[\n";
                 for (size_t i = 0; i < groups.size(); ++i) {
@@ -298,7 +363,12 @@ int main(int argc, char** argv) {
                         if (j + 1 < g.files.size()) std::cout << ",";
                         std::cout << "\n";
                     }
-                    std::cout << "  ]}";
+                    std::cout << "  ], \"links\": [";
+                    for (size_t j = 0; j < g.links.size(); ++j) {
+                        if (j > 0) std::cout << ", ";
+                        std::cout << "\"" << fo::core::Exporter::json_escape(g.links[j].path.string()) << "\"";
+                    }
+                    std::cout << "]}";
                     if (i + 1 < groups.size()) std::cout << ",";
                     std::cout << "\n";
                 }
@@ -309,31 +379,45 @@ int main(int argc, char** argv) {
                     for (const auto& f : g.files) {
                         std::cout << "  " << f.path.string() << "\n";
                     }
+                    for (const auto& f : g.links) {
+                        std::cout << "  " << f.path.string() << " (hardlink)\n";
+                    }
                 }
             }
         } else if (command == "hash") {
             auto files = engine.scan(roots, exts, follow_symlinks, prune);
             auto& hasher = engine.hasher();
+            fo::core::CatalogWriter writer(engine.database());
+            auto* sidecar = engine.sidecar_cache();
+            // Files are only read if neither the catalog nor the sidecar cache has a current hash
+            auto hash_of = [&](const fo::core::FileInfo& f) {
+                const auto token = fo::core::ChangeToken::of(f);
+                if (f.id != 0) {
+                    if (auto cached = engine.file_repository().get_cached_hash(f.id, hasher.name(), token)) return *cached;
+                }
+                std::optional<std::string> cached = sidecar ? sidecar->get_hash(f.path, hasher.name()) : std::nullopt;
+                std::string h = cached ? *cached : hasher.fast64(f.path);
+                if (sidecar && !cached) sidecar->set_hash(f.path, hasher.name(), h);
+                if (f.id != 0) {
+                    std::optional<fo::core::ChangeToken> stored;
+                    if (token.identified()) stored = token;
+                    writer.add_hash(f.id, hasher.name(), h, stored);
+                }
+                return h;
+            };
             if (format == "json") {
                 std::cout << "[\n";
                 for (size_t i = 0; i < files.size(); ++i) {
-                    std::string h = hasher.fast64(files[i].path);
+                    std::string h = hash_of(files[i]);
                     std::cout << "  {\"path\": \"" << fo::core::Exporter::json_escape(files[i].path.string())
                               << "\", \"hash\": \"" << h << "\"}";
                     if (i + 1 < files.size()) std::cout << ",";
                     std::cout << "\n";
-                    if (files[i].id != 0) {
-                        engine.file_repository().add_hash(files[i].id, hasher.name(), h);
-                    }
                 }
                 std::cout << "]\n";
             } else {
                 for (const auto& f : files) {
-                    std::string h = hasher.fast64(f.path);
-                    std::cout << h << "  " << f.path.string() << "\n";
-                    if (f.id != 0) {
-                        engine.file_repository().add_hash(f.id, hasher.name(), h);
-                    }
+                    std::cout << hash_of(f) << "  " << f.path.string() << "\n";
                 }
             }
         } else if (command == "metadata") {
@@ -418,7 +502,7 @@ int main(int argc, char** argv) {
                 return 1;
             }
 
-            auto matches = engine.file_repository().find_similar_images(res->value, threshold);
+            auto matches = engine.file_repository().find_similar(res->value, threshold, phash_algo);
 
             if (format == "json") {
                 std::cout << "{\"query\": \"" << fo::core::Exporter::json_escape(roots[0].string()) << "\""
@@ -427,24 +511,20 @@ int main(int argc, char** argv) {
                           << ", \"threshold\": " << threshold
                           << ", \"matches\": [\n";
                 for (size_t i = 0; i < matches.size(); ++i) {
-                    auto fi = engine.file_repository().get_by_id(matches[i]);
-                    if (fi) {
-                        std::cout << "    {\"id\": " << fi->id
-                                  << ", \"path\": \"" << fo::core::Exporter::json_escape(fi->path.string()) << "\""
-                                  << ", \"size\": " << fi->size
-                                  << "}" << (i + 1 < matches.size() ? "," : "") << "\n";
-                    }
+                    const auto& fi = matches[i].file;
+                    std::cout << "    {\"id\": " << fi.id
+                              << ", \"path\": \"" << fo::core::Exporter::json_escape(fi.path.string()) << "\""
+                              << ", \"size\": " << fi.size
+                              << ", \"distance\": " << matches[i].distance
+                              << "}" << (i + 1 < matches.size() ? "," : "") << "\n";
                 }
                 std::cout << "  ]\n}\n";
             } else {
                 std::cout << "Target hash: " << res->value << " (" << res->method << ")\n";
                 std::cout << "Algorithm: " << phash_algo << ", Threshold: " << threshold << "\n";
                 std::cout << "Found " << matches.size() << " similar images:\n";
-                for (auto id : matches) {
-                    auto fi = engine.file_repository().get_by_id(id);
-                    if (fi) {
-                        std::cout << "  " << fi->path.string() << "\n";
-                    }
+                for (const auto& m : matches) {
+                    std::cout << "  " << m.file.path.string() << " (distance " << m.distance << ")\n";
                 }
             }
         } else if (command == "classify") {
@@ -454,6 +534,7 @@ int main(int argc, char** argv) {
                 std::cerr << "Classifier 'onnx' not found.\n";
                 return 1;
             }
+            fo::core::CatalogWriter writer(engine.database());
 
             if (format == "json") {
                 std::cout << "[\n";
@@ -471,7 +552,7 @@ int main(int argc, char** argv) {
                                       << ", \"confidence\": " << r.confidence << "}";
                             if (i + 1 < results.size()) std::cout << ", ";
                             if (f.id != 0) {
-                                engine.file_repository().add_tag(f.id, r.label, r.confidence, "ai");
+                                writer.add_tag(f.id, r.label, r.confidence, "ai");
                             }
                         }
                         std::cout << "]}";
@@ -486,7 +567,7 @@ int main(int argc, char** argv) {
                         for (const auto& r : results) {
                             std::cout << "  " << r.label << " (" << r.confidence << ")\n";
                             if (f.id != 0) {
-                                engine.file_repository().add_tag(f.id, r.label, r.confidence, "ai");
+                                writer.add_tag(f.id, r.label, r.confidence, "ai");
                             }
                         }
                     }
@@ -500,6 +581,7 @@ int main(int argc, char** argv) {
 
             auto files = engine.scan(roots, exts, follow_symlinks, prune);
             fo::core::RuleEngine rule_engine;
+            fo::core::CatalogWriter writer(engine.database());
 
             if (!rule_template.empty()) {
                 rule_engine.add_rule({"cli_rule", "", rule_template});
@@ -530,14 +612,13 @@ int main(int argc, char** argv) {
                             std::filesystem::create_directories(new_path.parent_path());
                             std::filesystem::rename(f.path, new_path);
 
-                            fo::core::OperationRepository op_repo(engine.database());
                             fo::core::OperationRecord rec;
                             rec.timestamp = std::chrono::system_clock::now();
                             rec.type = fo::core::OperationType::Move;
                             rec.source_path = f.path.string();
                             rec.dest_path = new_path.string();
                             rec.file_size = f.size;
-                            op_repo.log_operation(rec);
+                            writer.log_operation(std::move(rec));
                         } catch (const std::exception& e) {
                             std::cerr << "Failed to move " << f.path.string() << ": " << e.what() << "\n";
                         }
@@ -563,23 +644,15 @@ int main(int argc, char** argv) {
                 }
             }
         } else if (command == "delete-duplicates") {
-            auto groups = engine.duplicate_repository().get_all_groups();
+            fo::core::CatalogWriter writer(engine.database());
 
             int deleted_count = 0;
             int kept_count = 0;
             std::vector<std::pair<std::string, std::vector<std::string>>> results; // kept, deleted[]
 
-            for (const auto& g : groups) {
-                std::vector<fo::core::FileInfo> members;
-                auto p = engine.file_repository().get_by_id(g.primary_file_id);
-                if (p) members.push_back(*p);
-                for (auto mid : g.member_ids) {
-                    if (mid == g.primary_file_id) continue;
-                    auto m = engine.file_repository().get_by_id(mid);
-                    if (m) members.push_back(*m);
-                }
-
-                if (members.size() < 2) continue;
+            auto group_count = engine.duplicate_repository().for_each_group([&](fo::core::DuplicateGroupFiles& g) {
+                auto& members = g.files;
+                if (members.size() < 2) return true;
 
                 std::sort(members.begin(), members.end(), [&](const fo::core::FileInfo& a, const fo::core::FileInfo& b) {
                     if (keep_strategy == "newest") return a.mtime > b.mtime;
@@ -599,25 +672,25 @@ int main(int argc, char** argv) {
                         try {
                             std::filesystem::remove(del.path);
                             deleted_count++;
-                            fo::core::OperationRepository op_repo(engine.database());
                             fo::core::OperationRecord rec;
                             rec.timestamp = std::chrono::system_clock::now();
                             rec.type = fo::core::OperationType::Delete;
                             rec.source_path = del.path.string();
                             rec.file_size = del.size;
-                            op_repo.log_operation(rec);
+                            writer.log_operation(std::move(rec));
                         } catch (const std::exception& e) {
                             std::cerr << "Failed to delete: " << e.what() << "\n";
                         }
                     }
                 }
                 results.push_back({keep.path.string(), deleted_paths});
-            }
+                return true;
+            });
 
             if (format == "json") {
                 std::cout << "{\"dry_run\": " << (dry_run ? "true" : "false")
                           << ", \"strategy\": \"" << keep_strategy << "\""
-                          << ", \"groups\": " << groups.size()
+                          << ", \"groups\": " << group_count
                           << ", \"kept\": " << kept_count
                           << ", \"deleted\": " << deleted_count
                           << ", \"results\": [\n";
@@ -633,7 +706,7 @@ int main(int argc, char** argv) {
                 }
                 std::cout << "  ]\n}\n";
             } else {
-                std::cout << "Found " << groups.size() << " duplicate groups.\n";
+                std::cout << "Found " << group_count << " duplicate groups.\n";
                 if (dry_run) std::cout << "(Dry run - no files will be deleted)\n";
                 for (const auto& [kept_path, deleted_paths] : results) {
                     std::cout << "Keeping: " << kept_path << "\n";
@@ -658,6 +731,7 @@ int main(int argc, char** argv) {
 
             auto files = engine.scan(roots, exts, follow_symlinks, prune);
             fo::core::RuleEngine rule_engine;
+            fo::core::CatalogWriter writer(engine.database());
             rule_engine.add_rule({"rename_rule", "", rename_pattern});
 
             std::vector<std::pair<std::string, std::string>> renames;
@@ -676,14 +750,13 @@ int main(int argc, char** argv) {
                     if (!dry_run) {
                         try {
                             std::filesystem::rename(f.path, new_path);
-                            fo::core::OperationRepository op_repo(engine.database());
                             fo::core::OperationRecord rec;
                             rec.timestamp = std::chrono::system_clock::now();
                             rec.type = fo::core::OperationType::Rename;
                             rec.source_path = f.path.string();
                             rec.dest_path = new_path.string();
                             rec.file_size = f.size;
-                            op_repo.log_operation(rec);
+                            writer.log_operation(std::move(rec));
                         } catch (const std::exception& e) {
                             std::cerr << "Failed to rename " << f.path.string() << ": " << e.what() << "\n";
                         }
@@ -834,6 +907,60 @@ int main(int argc, char** argv) {
                 }
             }
 
+        } else if (command == "watch") {
+#ifdef __linux__
+            fo::core::FileWatcher::Backend backend = fo::core::FileWatcher::Backend::Auto;
+            if (watch_backend == "fanotify") backend = fo::core::FileWatcher::Backend::Fanotify;
+            else if (watch_backend == "inotify") backend = fo::core::FileWatcher::Backend::Inotify;
+            else if (watch_backend != "auto") {
+                std::cerr << "Unknown watch backend: " << watch_backend << "\n";
+                return 2;
+            }
+
+            std::vector<std::filesystem::path> watch_roots;
+            for (const auto& r : roots) watch_roots.push_back(std::filesystem::weakly_canonical(r));
+            if (watch_roots.empty()) watch_roots.push_back(std::filesystem::current_path());
+
+            auto files = engine.scan(watch_roots, exts, follow_symlinks, true);
+            fo::core::FileWatcher watcher(watch_roots, backend);
+            std::cout << "Watching " << watch_roots.size() << " path(s) with " << watcher.backend_name()
+                      << " (" << files.size() << " files catalogued). Press Ctrl+C to stop.\n";
+            files.clear();
+            files.shrink_to_fit();
+
+            std::signal(SIGINT, on_stop_signal);
+            std::signal(SIGTERM, on_stop_signal);
+
+            // The database and its journal live next to each other; their own writes are not news
+            const std::string db_file = std::filesystem::weakly_canonical(cfg.db_path).string();
+            std::vector<fo::core::FileChange> pending;
+            while (!g_stop) {
+                const auto n = watcher.poll(pending, 200);
+                // Collect until the burst settles, but keep transactions small
+                if (n > 0 && pending.size() < 1024) continue;
+                pending.erase(std::remove_if(pending.begin(), pending.end(), [&](const fo::core::FileChange& c) {
+                    return c.kind != fo::core::FileChange::Kind::Overflow && c.path.string().rfind(db_file, 0) == 0;
+                }), pending.end());
+                if (pending.empty()) continue;
+
+                const bool overflow = std::any_of(pending.begin(), pending.end(), [](const fo::core::FileChange& c) {
+                    return c.kind == fo::core::FileChange::Kind::Overflow;
+                });
+                if (overflow) {
+                    std::cout << "Change events were lost; rescanning\n";
+                    engine.scan(watch_roots, exts, follow_symlinks, true);
+                } else {
+                    auto st = engine.apply_changes(pending, exts);
+                    std::cout << "Applied " << pending.size() << " change(s): " << st.updated << " updated, "
+                              << st.renamed << " renamed, " << st.removed << " removed\n";
+                }
+                pending.clear();
+            }
+            std::cout << "Stopped watching\n";
+#else
+            std::cerr << "The watch command is only available on Linux\n";
+            return 1;
+#endif
         } else {
             std::cerr << "Unknown command: " << command << "\n";
             return 1;
@@ -0,0 +1,122 @@
+#pragma once
+
+#include "fo/core/database.hpp"
+#include "fo/core/file_repository.hpp"
+#include "fo/core/operation_repository.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <variant>
+
+namespace fo::core {
+
+struct HashWrite {
+    int64_t file_id = 0;
+    std::string algo;
+    std::string value;   // hasher output, as for FileRepository::add_hash
+    std::optional<ChangeToken> token;
+};
+
+struct TagWrite {
+    int64_t file_id = 0;
+    std::string tag;
+    double confidence = 1.0;
+    std::string source = "user";
+};
+
+using CatalogWrite = std::variant<HashWrite, TagWrite, OperationRecord>;
+
+struct CatalogWriterOptions {
+    std::size_t batch_rows = 10000;                       // commit once a transaction holds this many writes
+    std::chrono::milliseconds commit_interval{200};       // ...or has been open this long
+    std::size_t queue_capacity = 65536;                   // producers wait while this many writes are queued
+};
+
+/**
+ * @brief Write-behind queue that applies catalog writes on a background thread.
+ *
+ * Producers (hashing, classification, file operations) hand over hashes, tags
+ * and operation log records and continue at once; they only wait when
+ * queue_capacity writes are queued and not yet picked up by the writer. The
+ * writer thread applies them through the usual repositories in transactions
+ * of up to batch_rows writes or commit_interval, holding
+ * DatabaseManager::lock_writes() while a transaction is open, so many writes
+ * share one commit.
+ *
+ * The queue is a lock-free multi-producer, single-consumer list; mutexes are
+ * only taken to wake an idle writer and to wake producers or flush() callers
+ * that are waiting. A write that fails (e.g. the file row was deleted
+ * meanwhile) is skipped and counted in failed().
+ * The destructor applies everything still queued.
+ */
+class CatalogWriter {
+public:
+    explicit CatalogWriter(DatabaseManager& db, CatalogWriterOptions options = {});
+    ~CatalogWriter();
+
+    CatalogWriter(const CatalogWriter&) = delete;
+    CatalogWriter& operator=(const CatalogWriter&) = delete;
+
+    void submit(CatalogWrite write);
+
+    void add_hash(int64_t file_id, std::string algo, std::string value,
+                  std::optional<ChangeToken> token = std::nullopt) {
+        submit(HashWrite{file_id, std::move(algo), std::move(value), token});
+    }
+    void add_tag(int64_t file_id, std::string tag, double confidence = 1.0, std::string source = "user") {
+        submit(TagWrite{file_id, std::move(tag), confidence, std::move(source)});
+    }
+    void log_operation(OperationRecord record) { submit(std::move(record)); }
+
+    /// Blocks until every write submitted before the call is committed.
+    void flush();
+
+    std::uint64_t committed() const { return committed_.load(); }
+    std::uint64_t failed() const { return failed_.load(); }
+    /// Message of the most recent failed write.
+    std::string last_error() const;
+
+private:
+    struct Node {
+        CatalogWrite write;
+        std::atomic<Node*> next{nullptr};
+    };
+
+    Node* pop();
+    void run();
+    void wake();
+    void notify_progress();
+
+    DatabaseManager& db_;
+    CatalogWriterOptions options_;
+
+    // Vyukov MPSC queue: producers exchange head_, the writer pops at tail_
+    std::atomic<Node*> head_;
+    Node* tail_;
+    Node stub_;
+
+    std::atomic<std::size_t> queued_{0};   // submitted, not yet popped by the writer
+    std::atomic<std::uint64_t> submitted_{0};
+    std::atomic<std::uint64_t> committed_{0};
+    std::atomic<std::uint64_t> failed_{0};
+    std::atomic<std::uint64_t> done_{0};   // committed or failed
+    std::atomic<std::uint64_t> flush_target_{0};
+    std::atomic<bool> idle_{false};
+    std::atomic<bool> stop_{false};
+
+    std::mutex wake_mutex_;
+    std::condition_variable wake_cv_;
+    std::mutex progress_mutex_;            // producers waiting for room, flush() waiting for commits
+    std::condition_variable progress_cv_;
+    mutable std::mutex error_mutex_;
+    std::string last_error_;
+    std::thread thread_;
+};
+
+} // namespace fo::core
@@ -2,14 +2,48 @@
 
 #include <string>
 #include <memory>
+#include <mutex>
+#include <unordered_map>
 #include <vector>
 #include <filesystem>
 
-// Forward declaration to avoid exposing sqlite3.h in the header
+// Forward declarations to avoid exposing sqlite3.h in the header
 struct sqlite3;
+struct sqlite3_stmt;
 
 namespace fo::core {
 
+class DatabaseManager;
+
+// A prepared statement borrowed from DatabaseManager's cache. Converts to
+// sqlite3_stmt* for the sqlite3_bind/step/column calls. When it goes out of
+// scope the statement is reset and its bindings cleared, so bound buffers
+// only have to outlive the handle. Never sqlite3_finalize() it.
+class Statement {
+public:
+    Statement() = default;
+    Statement(Statement&& other) noexcept;
+    Statement& operator=(Statement&& other) noexcept;
+    ~Statement();
+
+    Statement(const Statement&) = delete;
+    Statement& operator=(const Statement&) = delete;
+
+    sqlite3_stmt* get() const { return stmt_; }
+    operator sqlite3_stmt*() const { return stmt_; }
+
+private:
+    friend class DatabaseManager;
+    // in_use is the cache slot's flag, or nullptr for a one-off statement
+    Statement(DatabaseManager* owner, sqlite3_stmt* stmt, bool* in_use)
+        : owner_(owner), stmt_(stmt), in_use_(in_use) {}
+    void release();
+
+    DatabaseManager* owner_ = nullptr;
+    sqlite3_stmt* stmt_ = nullptr;
+    bool* in_use_ = nullptr;
+};
+
 class DatabaseManager {
 public:
     DatabaseManager();
@@ -19,9 +53,20 @@ public:
     DatabaseManager(const DatabaseManager&) = delete;
     DatabaseManager& operator=(const DatabaseManager&) = delete;
 
+    enum class Access {
+        ReadWrite,  // creates the file, switches it to WAL
+        ReadOnly    // for ReaderPool connections; the file must exist
+    };
+
+    // How long a connection waits for a lock held by another connection.
+    static constexpr int kBusyTimeoutMs = 5000;
+
     // Open the database at the specified path.
     // If path is ":memory:", opens an in-memory database.
-    void open(const std::filesystem::path& db_path);
+    void open(const std::filesystem::path& db_path, Access access = Access::ReadWrite);
+
+    const std::filesystem::path& path() const { return db_path_; }
+    Access access() const { return access_; }
 
     // Close the database connection.
     void close();
@@ -38,9 +83,39 @@ public:
     // Helper to execute a scalar query (returns int).
     int query_int(const std::string& sql);
 
+    // Get a prepared statement for sql, compiling it only the first time the
+    // text is seen. A statement that is still borrowed (e.g. a nested query
+    // with the same text) is compiled again for the new borrower and finalized
+    // afterwards. Returns an empty handle (nullptr) if sql does not compile;
+    // sqlite3_errmsg(get_db()) has the reason.
+    Statement prepare(const std::string& sql);
+
+    // Number of statements currently held in the cache.
+    std::size_t cached_statement_count() const;
+
+    // Serializes writers that share this connection. Calls are thread-safe on
+    // their own, but a transaction spans many calls: hold the lock from BEGIN
+    // to COMMIT so another thread's writes do not land inside it. Readers on
+    // other threads should use a ReaderPool connection instead.
+    std::unique_lock<std::recursive_mutex> lock_writes();
+
 private:
+    friend class Statement;
+
+    struct CachedStatement {
+        sqlite3_stmt* stmt = nullptr;
+        bool in_use = false;
+    };
+
     sqlite3* db_ = nullptr;
     std::filesystem::path db_path_;
+    Access access_ = Access::ReadWrite;
+    std::recursive_mutex write_mutex_;
+    std::unordered_map<std::string, CachedStatement> statements_;
+    mutable std::mutex statements_mutex_;
+
+    void give_back(bool* in_use);
+    void clear_statements();
 
     void apply_migration(int version, const std::string& sql);
     int get_current_version();
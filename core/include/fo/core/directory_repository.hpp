@@ -0,0 +1,48 @@
+#pragma once
+#include "fo/core/database.hpp"
+#include "fo/core/types.hpp"
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace fo::core {
+
+// Directory state recorded by the last scan that read it. mtime_ns = 0 means
+// "unknown", so the directory is always read again.
+struct DirectoryRecord {
+    int64_t id = 0;
+    std::filesystem::path path;
+    int64_t mtime_ns = 0;
+    int64_t child_count = 0;
+    std::string filter;  // scan options the directory was read with
+};
+
+class DirectoryRepository {
+public:
+    explicit DirectoryRepository(DatabaseManager& db);
+
+    // Get the id of a directory, inserting an empty record if needed.
+    int64_t ensure(const std::filesystem::path& path);
+
+    // Record the state a directory was read in.
+    void update_state(int64_t id, int64_t mtime_ns, int64_t child_count, const std::string& filter);
+
+    // Get all directories at or below the given roots.
+    std::vector<DirectoryRecord> get_under(const std::vector<std::filesystem::path>& roots);
+
+    std::optional<DirectoryRecord> get_by_path(const std::filesystem::path& path);
+
+    // Get the files catalogued directly in a directory.
+    std::vector<FileInfo> get_files(int64_t dir_id);
+
+    // Delete a directory and everything recorded below it.
+    void remove_tree(const std::filesystem::path& dir);
+
+    // Delete directories under the given roots that are not in present_ids.
+    void prune_missing(const std::vector<int64_t>& present_ids, const std::vector<std::filesystem::path>& roots);
+
+private:
+    DatabaseManager& db_;
+};
+
+} // namespace fo::core
@@ -16,4 +16,28 @@ public:
     std::vector<DuplicateGroup> group(const std::vector<FileInfo>& files, IHasher& hasher) override;
 };
 
+// Narrows candidates stage by stage, as jdupes and rmlint do:
+//   size    files of a size no other file has are dropped
+//   head    XXH3 of the first kHeadBytes
+//   sample  XXH3 of kSampleBytes from the middle and from the end
+//   full    the hasher's strong() hash if it has one, else XXH3 of the file
+// Every stage only reads files whose bucket still has two or more members.
+// Files short enough for the windows read so far to cover them skip the
+// remaining stages. Files that cannot be read are dropped. Hardlinks are
+// hashed once, as in the other finders.
+class MultiStageDuplicateFinder : public IDuplicateFinder {
+public:
+    static constexpr std::size_t kHeadBytes = 4096;
+    static constexpr std::size_t kSampleBytes = 4096;
+
+    std::string name() const override { return "multistage"; }
+    std::vector<DuplicateGroup> group(const std::vector<FileInfo>& files, IHasher& hasher) override;
+    void set_executor(HashExecutor* executor) override { executor_ = executor; }
+    std::vector<FinderStageStats> stage_stats() const override { return stats_; }
+
+private:
+    HashExecutor* executor_ = nullptr;
+    std::vector<FinderStageStats> stats_;
+};
+
 }
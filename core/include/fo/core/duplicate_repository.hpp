@@ -1,5 +1,7 @@
 #pragma once
 #include "fo/core/database.hpp"
+#include "fo/core/types.hpp"
+#include <functional>
 #include <vector>
 
 namespace fo::core {
@@ -10,16 +12,49 @@ struct DuplicateGroupDB {
     std::vector<int64_t> member_ids;
 };
 
+// A stored group with the catalog rows of its members, primary first.
+struct DuplicateGroupFiles {
+    int64_t id = 0;
+    int64_t primary_file_id = 0;
+    std::vector<FileInfo> files;
+};
+
+// Receives groups one at a time; the group is reused once the call returns.
+// Return false to stop.
+using DuplicateGroupSink = std::function<bool(DuplicateGroupFiles& group)>;
+
 class DuplicateRepository {
 public:
     explicit DuplicateRepository(DatabaseManager& db);
 
     int64_t create_group(int64_t primary_file_id);
     void add_member(int64_t group_id, int64_t file_id);
+
+    // Bulk form of create_group/add_member: one group per entry, its first
+    // id being the primary. Each statement is prepared once for the whole
+    // batch; run it inside a transaction. Returns the new group ids.
+    std::vector<int64_t> create_groups(const std::vector<std::vector<int64_t>>& groups);
     void clear_all(); // Clear all groups (e.g. before a new scan)
 
+    // Makes the stored groups equal to groups (member ids, primary first),
+    // writing only what differs. A stored group that shares a member with a
+    // new one keeps its id and primary and only gains or loses members;
+    // stored groups matching none are deleted. Run it inside a transaction.
+    // Returns the group ids, parallel to groups.
+    std::vector<int64_t> sync_groups(const std::vector<std::vector<int64_t>>& groups);
+
+    // Drop files from their groups (they changed or disappeared). Groups left
+    // with fewer than two members are deleted; a removed primary is replaced.
+    void remove_files(const std::vector<int64_t>& file_ids);
+
+    // All groups with their member ids, read with one joined query.
     std::vector<DuplicateGroupDB> get_all_groups();
 
+    // Streams every group with its file rows from one query ordered by
+    // group, holding a single group in memory at a time. Returns the
+    // number of groups passed to the sink.
+    std::size_t for_each_group(const DuplicateGroupSink& sink);
+
 private:
     DatabaseManager& db_;
 };
@@ -7,15 +7,35 @@
 #include "duplicate_repository.hpp"
 #include "ignore_repository.hpp"
 #include "scan_session_repository.hpp"
+#include "directory_repository.hpp"
+#include "reader_pool.hpp"
+#include "hash_executor.hpp"
 #include <memory>
+#include <unordered_map>
 
 namespace fo::core {
 
 struct EngineConfig {
     std::string scanner = "std";
     std::string hasher = "fast64";
+    std::string finder;          // Registered IDuplicateFinder for find_duplicates, e.g. "multistage" (empty = the incremental size+fast64 finder)
     std::string db_path = "fo.db";
-    bool use_ads_cache = false;  // Use Windows NTFS Alternate Data Streams for hash caching
+    unsigned scan_threads = 0;   // Worker threads for parallel scanners (0 = hardware concurrency)
+    unsigned hash_jobs = 0;      // Threads hashing duplicate candidates (0 = hardware concurrency)
+    unsigned hash_io_jobs = 0;   // Files read at once by those threads, e.g. 1 for spinning disks (0 = no cap)
+    std::string sidecar_cache;   // Hash cache stored with the files: "ads" (NTFS), "xattr" (Linux), empty for none
+    bool incremental_dirs = false; // Skip reading directories whose mtime is unchanged since the last scan
+    std::size_t checkpoint_files = 100000; // Commit a scan every N files so it can be resumed (0 = one transaction)
+    bool resume_scans = false;   // Continue an interrupted scan of the same roots instead of starting over
+    bool snapshot_index = false; // On rescans, check files against an in-memory PathIndex and write only changes
+    std::size_t reader_connections = 4; // Read-only connections in the pool behind Engine::reader()
+};
+
+// Outcome of Engine::apply_changes.
+struct ChangeStats {
+    std::size_t updated = 0;   // files added or whose size/mtime changed
+    std::size_t removed = 0;
+    std::size_t renamed = 0;
 };
 
 class Engine {
@@ -24,11 +44,16 @@ public:
         : cfg_(std::move(cfg))
         , scanner_(Registry<IFileScanner>::instance().create(cfg_.scanner))
         , hasher_(Registry<IHasher>::instance().create(cfg_.hasher))
+        , sidecar_(Registry<ISidecarHashCache>::instance().create(cfg_.sidecar_cache))
+        , finder_(Registry<IDuplicateFinder>::instance().create(cfg_.finder))
         , file_repo_(db_manager_)
         , duplicate_repo_(db_manager_)
         , ignore_repo_(db_manager_)
         , session_repo_(db_manager_)
+        , directory_repo_(db_manager_)
+        , readers_(db_manager_, cfg_.reader_connections)
     {
+        if (scanner_) scanner_->set_threads(cfg_.scan_threads);
         db_manager_.open(cfg_.db_path);
         db_manager_.migrate();
     }
@@ -38,6 +63,45 @@ public:
                                bool follow_symlinks,
                                bool prune = false);
 
+    // Streaming variant: every scanner batch is filtered against the ignore
+    // list, reconciled with the catalog and then passed to on_batch with ids
+    // set. Returns the number of files reported.
+    //
+    // Every directory walked is recorded with its mtime. With
+    // EngineConfig::incremental_dirs set, directories whose mtime is unchanged
+    // are not read again; their catalogued files are reported instead, after
+    // the scanned ones. Edits that keep a file's name do not touch the
+    // directory mtime, so those need a full scan to be picked up.
+    //
+    // Files found modified lose their stored hashes and duplicate group
+    // membership, as with apply_changes.
+    //
+    // The catalog is committed every EngineConfig::checkpoint_files files,
+    // together with the directories completed so far. If the scan fails,
+    // what was committed stays; with EngineConfig::resume_scans the next scan
+    // of the same roots and options continues that session.
+    std::size_t scan(const std::vector<std::filesystem::path>& roots,
+                     const std::vector<std::string>& include_exts,
+                     bool follow_symlinks,
+                     bool prune,
+                     const ScanBatchSink& on_batch);
+
+    // Applies watcher events to the catalog in one transaction. Changed files
+    // lose their stored hashes and duplicate group membership. Overflow events
+    // are ignored here; the caller is expected to rescan.
+    ChangeStats apply_changes(const std::vector<FileChange>& changes,
+                              const std::vector<std::string>& include_exts);
+
+    // Groups the files by size and fast64 hash and stores the result. Hashes
+    // in the catalog are reused while the file's ChangeToken still matches,
+    // so only files that are new or changed since they were last hashed, and
+    // only those sharing a size with another file, are read; their hashes
+    // are stored with their tokens. Files are hashed on a HashExecutor with
+    // EngineConfig::hash_jobs workers. Stored groups
+    // are updated in place (DuplicateRepository::sync_groups).
+    //
+    // With EngineConfig::finder set, that finder groups the files instead; it
+    // reads every candidate and its hashes are not stored.
     std::vector<DuplicateGroup> find_duplicates(const std::vector<FileInfo>& files);
 
     IHasher& hasher() { return *hasher_; }
@@ -45,29 +109,53 @@ public:
     DuplicateRepository& duplicate_repository() { return duplicate_repo_; }
     IgnoreRepository& ignore_repository() { return ignore_repo_; }
     ScanSessionRepository& session_repository() { return session_repo_; }
+    DirectoryRepository& directory_repository() { return directory_repo_; }
     DatabaseManager& database() { return db_manager_; }
 
-    bool use_ads_cache() const { return cfg_.use_ads_cache; }
+    // A read-only connection for use on another thread, e.g. to browse or
+    // export the catalog while a scan is writing it. Build repositories on
+    // lease.db(); they see the last committed state.
+    ReaderPool::Lease reader() { return readers_.acquire(); }
+
+    // The configured sidecar hash cache, or nullptr if none (or not available here).
+    ISidecarHashCache* sidecar_cache() { return sidecar_.get(); }
+
+    // The finder named by EngineConfig::finder, or nullptr for the built-in
+    // one. Its stage_stats() describe the last find_duplicates call.
+    IDuplicateFinder* finder() { return finder_.get(); }
 
 private:
     // local implementation of duplicate finder from dupe_size_fast.cpp
     class SizeHashDuplicateFinder : public IDuplicateFinder {
     public:
-        explicit SizeHashDuplicateFinder(bool use_ads = false) : use_ads_(use_ads) {}
+        // Hashes on executor, or on the calling thread without one
+        explicit SizeHashDuplicateFinder(ISidecarHashCache* sidecar = nullptr, HashExecutor* executor = nullptr)
+            : sidecar_(sidecar), executor_(executor) {}
         std::string name() const override { return "size+fast64"; }
         std::vector<DuplicateGroup> group(const std::vector<FileInfo>& files, IHasher& hasher) override;
+
+        // Stored hashes by file id; used instead of reading the file while
+        // its token matches the file's ChangeToken
+        std::unordered_map<int64_t, StoredHash> known;
+        // Hashes group() had to compute for catalogued files, with their tokens
+        std::vector<StoredHash> computed;
     private:
-        bool use_ads_ = false;
+        ISidecarHashCache* sidecar_ = nullptr;
+        HashExecutor* executor_ = nullptr;
     };
 
     EngineConfig cfg_{};
     std::unique_ptr<IFileScanner> scanner_{};
     std::unique_ptr<IHasher> hasher_{};
+    std::unique_ptr<ISidecarHashCache> sidecar_{};
+    std::unique_ptr<IDuplicateFinder> finder_{};
     DatabaseManager db_manager_;
     FileRepository file_repo_;
     DuplicateRepository duplicate_repo_;
     IgnoreRepository ignore_repo_;
     ScanSessionRepository session_repo_;
+    DirectoryRepository directory_repo_;
+    ReaderPool readers_;
 };
 
 } // namespace fo::core
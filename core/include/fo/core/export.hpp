@@ -42,6 +42,13 @@ public:
     // Export duplicate groups to CSV
     static void duplicates_to_csv(std::ostream& out, 
                                   const std::vector<DuplicateGroup>& duplicates);
+
+    // Catalog variants of the CSV exports; same columns, paths rebuilt per row
+    static void to_csv(std::ostream& out,
+                       const FileCatalog& catalog);
+    static void duplicates_to_csv(std::ostream& out,
+                                  const FileCatalog& catalog,
+                                  const std::vector<CatalogGroup>& duplicates);
     
     // Export scan results to HTML
     static void to_html(std::ostream& out,
@@ -61,6 +68,8 @@ public:
     // Compute statistics from scan results
     static ScanStats compute_stats(const std::vector<FileInfo>& files,
                                    const std::vector<DuplicateGroup>& duplicates);
+    static ScanStats compute_stats(const FileCatalog& catalog,
+                                   const std::vector<CatalogGroup>& duplicates);
     
     // Format file size for human readability
     static std::string format_size(std::uintmax_t bytes);
@@ -0,0 +1,144 @@
+#pragma once
+
+#include "types.hpp"
+#include "interfaces.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace fo::core {
+
+/**
+ * @brief Append-only string pool.
+ *
+ * Strings are copied into large chunks that are never reallocated, so the
+ * returned views stay valid for the lifetime of the arena.
+ */
+class StringArena {
+public:
+    explicit StringArena(std::size_t chunk_size = 1 << 20) : chunk_size_(chunk_size) {}
+
+    std::string_view store(std::string_view s);
+
+    /// Bytes held by all chunks, including unused tail space.
+    std::size_t bytes_reserved() const { return reserved_; }
+
+private:
+    std::size_t chunk_size_;
+    std::vector<std::unique_ptr<char[]>> chunks_;
+    char* cur_ = nullptr;
+    std::size_t left_ = 0;
+    std::size_t reserved_ = 0;
+};
+
+/**
+ * @brief Compact in-memory file catalog for very large scans.
+ *
+ * Paths are stored as (parent directory id, interned name). Directory and
+ * file names are deduplicated into a StringArena, so "IMG_0001.JPG" repeated
+ * across thousands of folders is stored once. Per-file data lives in
+ * struct-of-arrays columns (directory, name, size, mtime, database id) that
+ * are addressed by a 32-bit Handle. That is 32 bytes per file plus the
+ * amortised unique names, instead of a FileInfo with its own path allocation.
+ *
+ * Full paths are rebuilt on demand with path()/path_string(). Const member
+ * functions are safe to call concurrently; adding entries is not.
+ */
+class FileCatalog {
+public:
+    using Handle = std::uint32_t;
+    using DirId = std::uint32_t;
+    using NameId = std::uint32_t;
+    static constexpr DirId kNoDir = UINT32_MAX;
+
+    FileCatalog() = default;
+    FileCatalog(const FileCatalog&) = delete;
+    FileCatalog& operator=(const FileCatalog&) = delete;
+    FileCatalog(FileCatalog&&) = default;
+    FileCatalog& operator=(FileCatalog&&) = default;
+
+    /// Returns the id of the directory `name` under `parent`, creating it if needed.
+    /// Top-level entries use parent = kNoDir and carry the root component (e.g. "/" or "C:").
+    DirId add_dir(DirId parent, std::string_view name);
+
+    /// Returns the id of a directory given as a full path, creating missing components.
+    DirId dir_for(const std::filesystem::path& dir);
+
+    Handle add(DirId dir, std::string_view name, std::uintmax_t size,
+               std::chrono::file_clock::time_point mtime, int64_t id = 0);
+    Handle add(const FileInfo& file);
+
+    /// Appends a scanner batch; usable directly as an IFileScanner sink via sink().
+    void append(const std::vector<FileInfo>& batch);
+    ScanBatchSink sink();
+
+    std::size_t size() const { return size_.size(); }
+    bool empty() const { return size_.empty(); }
+    std::size_t dir_count() const { return dir_parent_.size(); }
+
+    std::uintmax_t file_size(Handle h) const { return size_[h]; }
+    std::chrono::file_clock::time_point mtime(Handle h) const {
+        return std::chrono::file_clock::time_point(std::chrono::file_clock::duration(mtime_[h]));
+    }
+    int64_t id(Handle h) const { return id_[h]; }
+    void set_id(Handle h, int64_t id) { id_[h] = id; }
+    DirId dir(Handle h) const { return dir_[h]; }
+    std::string_view name(Handle h) const { return names_[name_[h]]; }
+
+    std::string dir_path_string(DirId d) const;
+    std::string path_string(Handle h) const;
+    std::filesystem::path path(Handle h) const;
+    FileInfo to_file_info(Handle h) const;
+
+    /// Column views for cache-friendly passes over every file.
+    std::span<const std::uintmax_t> sizes() const { return size_; }
+    std::span<const int64_t> ids() const { return id_; }
+
+    /// All handles ordered by size (ties keep insertion order).
+    std::vector<Handle> handles_by_size() const;
+
+    /// Releases spare column capacity once the catalog is complete.
+    void shrink_to_fit();
+
+    /// Approximate heap bytes held by the catalog.
+    std::size_t memory_usage() const;
+
+private:
+    NameId intern(std::string_view s);
+    void grow_name_table();
+
+    StringArena arena_;
+    std::vector<std::string_view> names_;
+    std::vector<NameId> name_slots_;    // open addressing into names_, UINT32_MAX = empty
+
+    std::vector<DirId> dir_parent_;
+    std::vector<NameId> dir_name_;
+    std::unordered_map<std::uint64_t, DirId> dir_index_;   // (parent << 32 | name) -> dir
+
+    // Last directory resolved by dir_for(); scanners emit files grouped by directory
+    std::filesystem::path::string_type last_dir_;
+    DirId last_dir_id_ = kNoDir;
+
+    std::vector<DirId> dir_;
+    std::vector<NameId> name_;
+    std::vector<std::uintmax_t> size_;
+    std::vector<std::chrono::file_clock::rep> mtime_;
+    std::vector<int64_t> id_;
+};
+
+/// Duplicate group that refers to catalog entries by handle instead of copying them.
+struct CatalogGroup {
+    std::uintmax_t size = 0;
+    std::string fast64;
+    std::vector<FileCatalog::Handle> files;   // one entry per physical file
+    std::vector<FileCatalog::Handle> links;   // further hardlinks to those files, as in DuplicateGroup
+};
+
+} // namespace fo::core
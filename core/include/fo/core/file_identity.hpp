@@ -0,0 +1,26 @@
+#pragma once
+
+#include "fo/core/types.hpp"
+
+#include <vector>
+
+namespace fo::core {
+
+struct FileIdentity {
+    std::uint64_t dev = 0;
+    std::uint64_t ino = 0;     // 0 if unknown
+    std::uint64_t nlink = 0;   // 0 if unknown
+};
+
+// The (dev, ino, nlink) the scanner recorded, or read from the filesystem if
+// it did not. POSIX: st_dev/st_ino; Windows: volume serial and file index.
+FileIdentity file_identity(const FileInfo& file);
+
+// Splits files into physical files. Each inner vector holds the paths of one
+// file in input order; the first stands for it, the rest are hardlinks.
+// Files whose identity cannot be read are kept on their own. If identities is
+// given it receives the identity of each physical file, in the same order.
+std::vector<std::vector<const FileInfo*>> group_by_inode(const std::vector<const FileInfo*>& files,
+                                                         std::vector<FileIdentity>* identities = nullptr);
+
+} // namespace fo::core
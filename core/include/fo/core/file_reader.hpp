@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+
+#ifdef _WIN32
+#include <fstream>
+#endif
+
+namespace fo::core {
+
+/**
+ * @brief Read path shared by the hashers: pread()s or memory-maps a file.
+ *
+ * Hashers get spans of the file instead of copying it through std::ifstream
+ * into stack buffers:
+ *
+ * - By default the file is read with pread() into a page-aligned buffer the
+ *   reader keeps between files, in kBlockSize pieces that stay in L2 while
+ *   they are hashed. A hasher that owns a FileReader reads without
+ *   allocating or going through a streambuf.
+ * - Sequential opens of files of at least map_threshold bytes are mapped
+ *   read-only with MADV_SEQUENTIAL instead, and for_each_block() hands out
+ *   the mapping itself. Mapping is opt-in: on the benchmark machine (a VM)
+ *   faulting in a cached 1 GB mapping ran at 2.0 GB/s against 3.0 GB/s for
+ *   preads (BM_FileRead). A mapped file that another process truncates
+ *   while it is being hashed raises SIGBUS.
+ *
+ * posix_fadvise() announces the pattern: sequential read-ahead for whole
+ * files read in blocks, no read-ahead for the windows sampled from a large
+ * file.
+ *
+ * On Windows the reader falls back to std::ifstream into the same buffer.
+ * Not thread-safe: use one reader per thread.
+ */
+class FileReader {
+public:
+    static constexpr std::uint64_t kNeverMap = UINT64_MAX;
+    static constexpr std::size_t kBlockSize = 128 * 1024;   // pread size for whole-file reads
+    static constexpr std::uint64_t kSampledReadAhead = 1024 * 1024;   // larger sampled files get FADV_RANDOM
+
+    enum class Access {
+        Sequential,  // the whole file, front to back
+        Sampled      // a few windows at arbitrary offsets
+    };
+
+    explicit FileReader(std::uint64_t map_threshold = kNeverMap) : map_threshold_(map_threshold) {}
+    ~FileReader();
+
+    FileReader(const FileReader&) = delete;
+    FileReader& operator=(const FileReader&) = delete;
+
+    /// Opens p, closing the previous file. False if it cannot be opened.
+    bool open(const std::filesystem::path& p, Access access);
+    void close();
+
+    std::uint64_t size() const { return size_; }
+    bool mapped() const { return map_ != nullptr; }
+
+    /// Up to len bytes at offset, fewer at the end of the file. Valid until the
+    /// next read() or close(). Empty past the end or on a read error.
+    std::span<const std::uint8_t> read(std::uint64_t offset, std::size_t len);
+
+    /// Calls fn(span) on consecutive pieces covering the file: the whole
+    /// mapping at once, or kBlockSize reads. False if a read failed.
+    template <typename Fn>
+    bool for_each_block(Fn&& fn) {
+        if (map_) {
+            if (size_ > 0) fn(std::span<const std::uint8_t>(map_, static_cast<std::size_t>(size_)));
+            return true;
+        }
+        std::uint64_t offset = 0;
+        while (offset < size_) {
+            auto block = read(offset, kBlockSize);
+            if (block.empty()) return !failed_;   // shrunk since open(): hash what was there
+            fn(block);
+            offset += block.size();
+        }
+        return true;
+    }
+
+private:
+    std::uint8_t* reserve(std::size_t n);
+
+    std::uint64_t map_threshold_;
+    std::uint64_t size_ = 0;
+    bool failed_ = false;
+
+    const std::uint8_t* map_ = nullptr;
+#ifdef _WIN32
+    std::ifstream file_;
+#else
+    int fd_ = -1;
+#endif
+
+    std::uint8_t* buffer_ = nullptr;   // page-aligned, reused across files
+    std::size_t capacity_ = 0;
+};
+
+} // namespace fo::core
@@ -1,5 +1,8 @@
 #pragma once
 #include "fo/core/database.hpp"
+#include "fo/core/file_identity.hpp"
+#include "fo/core/hash_digest.hpp"
+#include "fo/core/path_index.hpp"
 #include "fo/core/types.hpp"
 #include <optional>
 #include <vector>
@@ -11,6 +14,35 @@ struct UpsertResult {
     bool is_modified = false;
 };
 
+// What a stored hash was computed from. A cached hash is only reused while
+// the file still has the same device, inode, size and mtime (to the
+// nanosecond, unlike files.mtime). Scanners that do not record dev/ino leave
+// them to file_identity(); a token whose ino is still 0 identifies nothing and
+// is neither stored nor matched.
+struct ChangeToken {
+    std::uint64_t dev = 0;
+    std::uint64_t ino = 0;
+    std::uintmax_t size = 0;
+    int64_t mtime_ns = 0;   // unix time
+
+    static ChangeToken of(const FileInfo& file);
+    static ChangeToken of(const FileInfo& file, const FileIdentity& id);
+    bool identified() const { return ino != 0; }
+    bool operator==(const ChangeToken&) const = default;
+};
+
+// A row of file_hashes; token is empty for hashes stored without one.
+struct StoredHash {
+    int64_t file_id = 0;
+    std::string value;   // as get_hashes returns it
+    std::optional<ChangeToken> token;
+};
+
+struct SimilarImage {
+    FileInfo file;
+    int distance = 0;   // Hamming distance to the query hash
+};
+
 class FileRepository {
 public:
     explicit FileRepository(DatabaseManager& db);
@@ -18,7 +50,20 @@ public:
     // Insert or update a file. Returns status.
     // Updates size/mtime if path exists and changed.
     // Sets file.id to the new/existing ID.
-    UpsertResult upsert(FileInfo& file);
+    // A non-zero dir_id links the file to its row in the directories table.
+    UpsertResult upsert(FileInfo& file, int64_t dir_id = 0);
+
+    // Bulk form of upsert for scan results: rows go through one prepared
+    // insert into a staging table and are then merged with a few set-based
+    // statements. dir_ids[i] belongs to files[i] (0: leave unset). Sets every
+    // file's id. With insert_new = false, files not yet catalogued are left
+    // out and come back with id 0.
+    std::vector<UpsertResult> upsert_batch(std::vector<FileInfo>& files, const std::vector<int64_t>& dir_ids,
+                                           bool insert_new = true);
+
+    // Snapshot of the files catalogued under the given roots, read with one
+    // sequential range scan per root (see PathIndex).
+    PathIndex load_snapshot(const std::vector<std::filesystem::path>& roots);
 
     // Prune files that are not in the given list of IDs but are within the given roots.
     void prune_missing(const std::vector<int64_t>& present_ids, const std::vector<std::filesystem::path>& roots);
@@ -29,25 +74,62 @@ public:
     // Get files that are in the DB under the given roots but NOT in the present_ids list.
     std::vector<FileInfo> get_missing_files(const std::vector<std::filesystem::path>& roots, const std::vector<int64_t>& present_ids);
 
+    // True if the catalog holds at least one file under any of the given roots.
+    bool has_files_under(const std::vector<std::filesystem::path>& roots);
+
     // Delete files by ID.
     void delete_files(const std::vector<int64_t>& ids);
 
+    // IDs of all files strictly below a directory.
+    std::vector<int64_t> get_ids_under(const std::filesystem::path& dir);
+
+    // Rewrite the paths of all files below old_dir to live below new_dir (directory rename).
+    void move_tree(const std::filesystem::path& old_dir, const std::filesystem::path& new_dir);
+
+    // Forget all stored hashes of a file (its content changed).
+    void clear_hashes(int64_t file_id);
+
     // Get file by path.
     std::optional<FileInfo> get_by_path(const std::filesystem::path& path);
 
-    // Add a hash for a file.
-    void add_hash(int64_t file_id, const std::string& algo, const std::string& value);
+    // Add a hash for a file. 64-bit digests are stored as INTEGER, longer
+    // ones as BLOB. With a token the hash also serves as a cache entry for
+    // get_cached_hash.
+    void add_hash(int64_t file_id, const std::string& algo, const HashDigest& value,
+                  const std::optional<ChangeToken>& token = std::nullopt);
+
+    // Add a hash given as hasher output: hex is stored in binary like the
+    // overload above, any other text as it is.
+    void add_hash(int64_t file_id, const std::string& algo, const std::string& value,
+                  const std::optional<ChangeToken>& token = std::nullopt);
+
+    // The stored hash (as get_hashes returns it) if it was computed from a
+    // file matching token. Check this before reading a file to hash it.
+    std::optional<std::string> get_cached_hash(int64_t file_id, const std::string& algo, const ChangeToken& token);
 
     // Get all hashes for a file.
-    // Returns vector of pair<algo, value>
+    // Returns vector of pair<algo, value>, binary values as lowercase hex
     std::vector<std::pair<std::string, std::string>> get_hashes(int64_t file_id);
 
+    // Every stored hash of one algorithm, with its token.
+    std::vector<StoredHash> get_hashes_by_algo(const std::string& algo);
+
+    // Stored binary hash of one algorithm, if any.
+    std::optional<HashDigest> get_hash(int64_t file_id, const std::string& algo);
+
+    // IDs of the files whose hash for algo equals value (answered from idx_hashes_algo_value).
+    std::vector<int64_t> find_by_hash(const std::string& algo, const HashDigest& value);
+
     // Get file by ID.
     std::optional<FileInfo> get_by_id(int64_t id);
 
-    // Find files with similar perceptual hash.
-    // Assumes 'dhash' algorithm stored as decimal or hex string.
-    // Returns list of file IDs.
+    // Files whose 64-bit perceptual hash (algo 'dhash', 'phash' or 'ahash')
+    // lies within threshold bits of target_hash, closest first, with their
+    // rows read in the same query. Probes the phash_bands multi-index up to a
+    // threshold of 15 and scans all hashes of the algorithm beyond that.
+    std::vector<SimilarImage> find_similar(uint64_t target_hash, int threshold, const std::string& algo = "dhash");
+
+    // IDs of the find_similar() matches for 'dhash'.
     std::vector<int64_t> find_similar_images(uint64_t target_hash, int threshold);
 
     // Add a tag to a file.
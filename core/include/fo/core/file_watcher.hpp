@@ -0,0 +1,55 @@
+#pragma once
+
+#ifdef __linux__
+
+#include "fo/core/types.hpp"
+
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace fo::core {
+
+/**
+ * @brief Reports filesystem changes below a set of roots (Linux only).
+ *
+ * Prefers fanotify with directory-entry events (FAN_REPORT_DFID_NAME, Linux
+ * 5.9+), which marks whole filesystems without a per-directory watch and
+ * needs CAP_SYS_ADMIN. Without it, falls back to recursive inotify, adding a
+ * watch per directory as directories appear.
+ *
+ * Events are only hints: consumers should re-check the path on disk (see
+ * Engine::apply_changes). A Kind::Overflow change means events were lost and
+ * the roots must be rescanned.
+ */
+class FileWatcher {
+public:
+    enum class Backend { Auto, Fanotify, Inotify };
+
+    /// @throws std::runtime_error if the requested backend (or, for Auto, neither) can be set up.
+    explicit FileWatcher(std::vector<std::filesystem::path> roots, Backend backend = Backend::Auto);
+    ~FileWatcher();
+
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+    /// "fanotify" or "inotify".
+    std::string backend_name() const;
+
+    /**
+     * @brief Waits up to timeout_ms for events and appends the resulting changes to out.
+     * @return Number of changes appended (0 on timeout).
+     */
+    std::size_t poll(std::vector<FileChange>& out, int timeout_ms);
+
+private:
+    struct Impl;
+    struct FanotifyImpl;
+    struct InotifyImpl;
+    std::unique_ptr<Impl> impl_;
+};
+
+} // namespace fo::core
+
+#endif // __linux__
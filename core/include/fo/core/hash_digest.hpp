@@ -0,0 +1,53 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace fo::core {
+
+/**
+ * @brief Fixed-capacity binary hash value (up to 256 bits).
+ *
+ * Hashers keep returning lowercase hex strings; the catalog stores the bytes
+ * instead (see FileRepository::add_hash). 64-bit digests go into an INTEGER
+ * column value, longer ones into a BLOB, which halves the size of hex text.
+ */
+class HashDigest {
+public:
+    static constexpr std::size_t kMaxBytes = 32;
+
+    HashDigest() = default;
+
+    /// Big-endian bytes of v, so to_hex() matches the usual "%016x" form.
+    static HashDigest from_u64(std::uint64_t v);
+    /// Up to kMaxBytes raw bytes; longer input is rejected.
+    static std::optional<HashDigest> from_bytes(const void* data, std::size_t size);
+    /// Even-length hex of either case; anything else is rejected.
+    static std::optional<HashDigest> from_hex(std::string_view hex);
+
+    std::string to_hex() const;
+
+    const std::uint8_t* data() const { return bytes_.data(); }
+    std::size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    /// True for 8-byte digests, which are stored as INTEGER.
+    bool is_u64() const { return size_ == 8; }
+    std::uint64_t as_u64() const;
+
+    friend bool operator==(const HashDigest& a, const HashDigest& b) {
+        return a.size_ == b.size_ && a.bytes_ == b.bytes_;
+    }
+
+private:
+    std::array<std::uint8_t, kMaxBytes> bytes_{};
+    std::uint8_t size_ = 0;
+};
+
+/// Lowercase, zero-padded 16-digit hex of v (the fast64 hash format).
+std::string to_hex64(std::uint64_t v);
+
+} // namespace fo::core
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "fo/core/interfaces.hpp"
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <semaphore>
+#include <string>
+#include <vector>
+
+namespace fo::core {
+
+// Files of one size that need hashing, and the hashes run() computed for them
+// (same order; empty where the hasher failed).
+struct HashBucket {
+    std::vector<const FileInfo*> files;
+    std::vector<std::string> hashes;
+};
+
+/**
+ * @brief Hashes size buckets on a bounded pool of worker threads.
+ *
+ * IHasher instances are not thread-safe, so every worker hashes with its own
+ * instance, created from the registry under the name of the hasher passed to
+ * run(). Buckets are handed out in order, in pieces of at most kChunkFiles
+ * files so one very common size does not end up on a single worker. Each
+ * worker writes the hashes of the files it took straight into their slots in
+ * HashBucket::hashes; nothing is merged under a lock.
+ *
+ * io_jobs caps how many workers read file contents at the same time, for
+ * spinning disks where concurrent reads turn into seeks. Jobs mark their
+ * reads with read(). 0 means no cap.
+ *
+ * With one worker, a single file to hash, or a hasher the registry cannot
+ * create, run() hashes on the calling thread with the hasher it was given.
+ */
+class HashExecutor {
+public:
+    static constexpr std::size_t kChunkFiles = 64;
+
+    // Computes the hash of one file with the worker's hasher
+    using Job = std::function<std::string(IHasher& hasher, const FileInfo& file)>;
+
+    /// jobs: worker threads (0 = hardware concurrency).
+    explicit HashExecutor(unsigned jobs = 0, unsigned io_jobs = 0);
+    ~HashExecutor();
+
+    HashExecutor(const HashExecutor&) = delete;
+    HashExecutor& operator=(const HashExecutor&) = delete;
+
+    unsigned jobs() const { return jobs_; }
+    unsigned io_jobs() const { return io_jobs_; }
+
+    /// Fills every bucket's hashes. The first exception a job throws stops
+    /// the remaining work and is rethrown here once the workers are done.
+    void run(std::vector<HashBucket>& buckets, IHasher& hasher, const Job& job);
+
+    /// Calls fn while holding one of the io_jobs read slots.
+    template <typename Fn>
+    auto read(Fn&& fn) {
+        if (!io_gate_) return fn();
+        io_gate_->acquire();
+        struct Release {
+            std::counting_semaphore<>* gate;
+            ~Release() { gate->release(); }
+        } release{io_gate_.get()};
+        return fn();
+    }
+
+private:
+    unsigned jobs_;
+    unsigned io_jobs_;
+    std::unique_ptr<std::counting_semaphore<>> io_gate_;
+};
+
+} // namespace fo::core
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <memory>
+#include <optional>
+#include <regex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace fo::core {
+
+struct IgnoreRule;
+
+/**
+ * @brief All ignore rules compiled into one matcher.
+ *
+ * Built once per scan from the ignore list. Three kinds of pattern are
+ * recognised:
+ *  - `glob:<pattern>`  gitignore-style glob. `*`, `?` and `[...]` stay within
+ *    one path component, `**` spans components, a pattern without a slash
+ *    matches a component at any depth, a leading slash anchors it to the start
+ *    of the path and a trailing slash matches directories only. All globs are
+ *    combined into a single regular expression.
+ *  - `dir:<path>`      the directory and everything below it. Kept in a
+ *    component trie, so a lookup costs one walk down the path.
+ *  - anything else     a regular expression searched anywhere in the path (the
+ *    original ignore-list behaviour). Plain strings and invalid expressions are
+ *    matched as substrings through one Aho-Corasick automaton; the remaining
+ *    expressions are combined into one alternation.
+ *
+ * Const member functions are safe to call from several threads.
+ */
+class IgnoreMatcher {
+public:
+    IgnoreMatcher();
+    explicit IgnoreMatcher(const std::vector<IgnoreRule>& rules);
+    ~IgnoreMatcher();
+    IgnoreMatcher(IgnoreMatcher&&) noexcept;
+    IgnoreMatcher& operator=(IgnoreMatcher&&) noexcept;
+
+    bool empty() const { return empty_; }
+
+    /// True if the file or directory at `path` is ignored.
+    bool matches(std::string_view path) const;
+
+    /// True if every path below `dir` is ignored, so a scanner need not descend.
+    /// Regular expressions that look past their match ($, \b, lookaheads) never prune.
+    bool prunes_directory(std::string_view dir) const;
+
+private:
+    struct Literals;   // Aho-Corasick automaton over substring patterns
+    struct DirTrie;    // component trie over dir: prefixes
+
+    bool empty_ = true;
+    std::unique_ptr<Literals> literals_;
+    std::unique_ptr<DirTrie> dirs_;
+    std::optional<std::regex> globs_;
+    std::optional<std::regex> prunable_regex_;   // safe to test on a directory prefix
+    std::optional<std::regex> other_regex_;      // anchors or lookarounds; files only
+    std::vector<std::regex> backref_regexes_;    // back-references can't be combined
+};
+
+} // namespace fo::core
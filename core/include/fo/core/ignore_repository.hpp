@@ -1,5 +1,7 @@
 #pragma once
 #include "fo/core/database.hpp"
+#include "fo/core/ignore_matcher.hpp"
+#include <optional>
 #include <vector>
 #include <string>
 
@@ -18,11 +20,16 @@ public:
     void add(const std::string& pattern, const std::string& reason = "");
     void remove(const std::string& pattern);
     std::vector<IgnoreRule> get_all();
-    bool is_ignored(const std::string& path); // Simple check against patterns
+
+    // Compile the current rules; see IgnoreMatcher for the pattern syntax.
+    IgnoreMatcher compile();
+
+    // Check a single path. The compiled rules are cached until add()/remove().
+    bool is_ignored(const std::string& path);
 
 private:
     DatabaseManager& db_;
-    // Cache could be added here for performance
+    std::optional<IgnoreMatcher> cache_;
 };
 
 } // namespace fo::core
@@ -1,20 +1,85 @@
 #pragma once
 
 #include "types.hpp"
+#include <chrono>
+#include <cstddef>
+#include <functional>
 #include <string>
 #include <vector>
+#include <iterator>
 #include <optional>
 
 namespace fo::core {
 
+class FileCatalog;
+struct CatalogGroup;
+class HashExecutor;
+
+// Receives scan results in batches. The scanner clears and reuses the vector
+// once the call returns, so consumers move out whatever they want to keep.
+using ScanBatchSink = std::function<void(std::vector<FileInfo>& batch)>;
+
+// Hook a scanner consults around every directory it walks, including the
+// roots. The engine uses it to prune ignored subtrees and, on incremental
+// scans, to skip reading directories whose mtime is unchanged since they were
+// last catalogued. Calls may come from scanner worker threads, but never
+// concurrently for the same filter.
+class IScanDirectoryFilter {
+public:
+    enum class Action {
+        Descend,  // read the directory normally
+        Reuse,    // skip reading it; the walk continues with the supplied subdirectories
+        Skip      // leave the whole subtree out of the scan
+    };
+
+    virtual ~IScanDirectoryFilter() = default;
+
+    // Called before dir is read. On Reuse the scanner emits nothing for dir
+    // itself and walks `subdirs` instead; the filter owner accounts for its files.
+    virtual Action enter_directory(const std::filesystem::path& dir,
+                                   std::chrono::file_clock::time_point mtime,
+                                   std::vector<std::filesystem::path>& subdirs) = 0;
+
+    // Called once a Descend-ed directory has been read; entry_count excludes "." and "..".
+    // file_count is the number of files emitted for dir. Some of them may
+    // still be buffered in the scanner and reach the sink after this call.
+    virtual void directory_done(const std::filesystem::path& dir,
+                                std::chrono::file_clock::time_point mtime,
+                                std::size_t entry_count,
+                                std::size_t file_count) = 0;
+};
+
 class IFileScanner {
 public:
+    // Upper bound on results a scanner buffers before handing them to the sink.
+    static constexpr std::size_t kScanBatchSize = 4096;
+
     virtual ~IFileScanner() = default;
     virtual std::string name() const = 0;
+    // Streams results to sink while walking, at most kScanBatchSize at a time.
+    // The sink is always invoked on the calling thread.
+    virtual void scan_batches(
+        const std::vector<std::filesystem::path>& roots,
+        const std::vector<std::string>& include_exts,
+        bool follow_symlinks,
+        const ScanBatchSink& sink) = 0;
+    // Collects every batch into one vector; prefer scan_batches for large trees.
     virtual std::vector<FileInfo> scan(
         const std::vector<std::filesystem::path>& roots,
         const std::vector<std::string>& include_exts,
-        bool follow_symlinks) = 0;
+        bool follow_symlinks) {
+        std::vector<FileInfo> out;
+        scan_batches(roots, include_exts, follow_symlinks, [&](std::vector<FileInfo>& batch) {
+            if (out.empty()) out.swap(batch);
+            else std::move(batch.begin(), batch.end(), std::back_inserter(out));
+        });
+        return out;
+    }
+    // Worker thread hint for scanners that walk in parallel (0 = hardware concurrency).
+    virtual void set_threads(unsigned threads) { (void)threads; }
+    // Directory hook for the next scans (nullptr = plain walk). Scanners that
+    // ignore it simply read every directory.
+    virtual void set_directory_filter(IScanDirectoryFilter* filter) { (void)filter; }
 };
 
 class IHasher {
@@ -26,6 +91,20 @@ public:
     virtual std::string strong_algo() const { return ""; }
 };
 
+// Hash cache stored with the file itself instead of in the catalog (an NTFS
+// stream, a Linux xattr), so hashes travel with the file to other machines
+// and catalogs. An entry is only returned while the file's mtime matches the
+// one it was stored with. Where a backend cannot store data (unsupported
+// filesystem, read-only mount) both calls fail quietly. Hashing workers call
+// it concurrently for different files.
+class ISidecarHashCache {
+public:
+    virtual ~ISidecarHashCache() = default;
+    virtual std::string name() const = 0;
+    virtual std::optional<std::string> get_hash(const std::filesystem::path& p, const std::string& algo) = 0;
+    virtual bool set_hash(const std::filesystem::path& p, const std::string& algo, const std::string& value) = 0;
+};
+
 class IMetadataProvider {
 public:
     virtual ~IMetadataProvider() = default;
@@ -37,7 +116,16 @@ public:
 struct DuplicateGroup {
     std::uintmax_t size = 0;
     std::string fast64;
-    std::vector<FileInfo> files;
+    std::vector<FileInfo> files;   // one path per physical file
+    std::vector<FileInfo> links;   // further hardlinks to files in `files`; not copies
+};
+
+// What one stage of a duplicate finder did in its last group() call.
+struct FinderStageStats {
+    std::string stage;
+    std::size_t candidates = 0;   // files the stage looked at
+    std::size_t remaining = 0;    // files still sharing a bucket with another file afterwards
+    std::uint64_t bytes_read = 0;
 };
 
 class IDuplicateFinder {
@@ -45,6 +133,15 @@ public:
     virtual ~IDuplicateFinder() = default;
     virtual std::string name() const = 0;
     virtual std::vector<DuplicateGroup> group(const std::vector<FileInfo>& files, IHasher& hasher) = 0;
+    // Pool for the next group() calls to hash on (nullptr = the calling
+    // thread). Finders that hash one file at a time ignore it.
+    virtual void set_executor(HashExecutor* executor) { (void)executor; }
+    // Per-stage counts of the last group() call; empty for single-stage finders.
+    virtual std::vector<FinderStageStats> stage_stats() const { return {}; }
+    // Handle-based grouping over a FileCatalog (see file_catalog.hpp). The
+    // default walks the catalog in size order and only materializes FileInfo
+    // records for sizes shared by two or more files before calling group().
+    virtual std::vector<CatalogGroup> group_catalog(const FileCatalog& catalog, IHasher& hasher);
 };
 
 } // namespace fo::core
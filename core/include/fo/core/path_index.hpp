@@ -0,0 +1,72 @@
+#pragma once
+
+#include "types.hpp"
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace fo::core {
+
+/**
+ * @brief Compact snapshot of catalogued files, keyed by path hash.
+ *
+ * Built once per scan by FileRepository::load_snapshot() so Engine::scan can
+ * recognise unchanged files without querying the database. Paths are not
+ * kept: each entry is a 64-bit path hash plus what is needed to decide
+ * "unchanged", in 24 bytes per slot of an open-addressing table (about 30
+ * bytes per file at the maximum load of 80%, so ~600 MB for 20M files).
+ *
+ * Size, mtime (unix nanoseconds, as files.mtime_ns) and directory id are folded into
+ * one 64-bit stamp; device, inode and link count into a 32-bit identity. Two
+ * catalogued paths with the same hash are detected while loading and reported
+ * as Ambiguous, so the caller falls back to the database for them.
+ */
+class PathIndex {
+public:
+    enum class State {
+        Absent,     // path is not catalogued
+        Unchanged,  // same size, mtime and directory, and identity if the scanner read one
+        Changed,    // catalogued, but something differs
+        Ambiguous   // hash shared by several catalogued paths; look it up in the database
+    };
+
+    struct Match {
+        State state = State::Absent;
+        int64_t id = 0;   // set for Unchanged and Changed
+    };
+
+    /// Records a catalogued file. ino == 0 means its identity is unknown.
+    void add(std::string_view path, int64_t id, std::uintmax_t size, int64_t mtime_ns,
+             int64_t dir_id, std::uint64_t dev, std::uint64_t ino, std::uint64_t nlink);
+
+    /// Compares a scanned file against the snapshot. dir_id is the directory row it will be linked to.
+    Match find(const FileInfo& file, int64_t dir_id) const;
+
+    std::size_t size() const { return count_; }
+    bool empty() const { return count_ == 0; }
+
+    /// Heap bytes held by the table.
+    std::size_t memory_usage() const { return slots_.capacity() * sizeof(Slot); }
+
+private:
+    struct Slot {
+        std::uint64_t hash = 0;    // 0 = empty
+        std::uint64_t stamp = 0;
+        std::uint32_t id = 0;      // 0 = ambiguous (ids start at 1)
+        std::uint32_t ident = 0;   // 0 = unknown
+    };
+    static_assert(sizeof(Slot) == 24);
+
+    static std::uint64_t hash_path(std::string_view path);
+    static std::uint64_t make_stamp(std::uintmax_t size, int64_t mtime_ns, int64_t dir_id);
+    static std::uint32_t make_ident(std::uint64_t dev, std::uint64_t ino, std::uint64_t nlink);
+
+    const Slot* lookup(std::uint64_t hash) const;
+    void grow();
+
+    std::vector<Slot> slots_;
+    std::size_t count_ = 0;
+};
+
+} // namespace fo::core
@@ -4,10 +4,17 @@ namespace fo::core {
 void register_scanner_std();
 void register_scanner_win32();
 void register_scanner_dirent();
+void register_scanner_parallel();
+void register_scanner_linux();
+void register_scanner_uring();
 void register_hasher_fast64();
 void register_hasher_sha256();
 void register_hasher_xxhash();
 void register_hasher_blake3();
+void register_sidecar_ads();
+void register_sidecar_xattr();
+void register_finder_size_hash();
+void register_finder_multistage();
 void register_metadata_tinyexif();
 void register_linter_std();
 
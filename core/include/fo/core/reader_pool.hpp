@@ -0,0 +1,73 @@
+#pragma once
+
+#include "fo/core/database.hpp"
+
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace fo::core {
+
+/**
+ * @brief Read-only connections to the database of a writer DatabaseManager.
+ *
+ * With the catalog in WAL mode, each reader sees the last committed state and
+ * is neither blocked by nor blocks the writer, so browsing, export and hashing
+ * workers can run while a scan transaction is open. A lease hands one
+ * connection to one thread; build repositories on it as on any
+ * DatabaseManager (their statement caches are per connection).
+ *
+ * Connections are opened on first use, up to the pool size, after which
+ * acquire() waits for a lease to be returned. An in-memory writer cannot be
+ * shared between connections, so for ":memory:" every lease refers to the
+ * writer itself.
+ */
+class ReaderPool {
+public:
+    class Lease {
+    public:
+        Lease(Lease&& other) noexcept : pool_(other.pool_), db_(other.db_) { other.pool_ = nullptr; }
+        Lease& operator=(Lease&&) = delete;
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+        ~Lease();
+
+        DatabaseManager& db() const { return *db_; }
+        DatabaseManager* operator->() const { return db_; }
+
+    private:
+        friend class ReaderPool;
+        Lease(ReaderPool* pool, DatabaseManager* db) : pool_(pool), db_(db) {}
+
+        ReaderPool* pool_;        // nullptr when the lease need not be returned
+        DatabaseManager* db_;
+    };
+
+    /// The writer must be open before the first acquire().
+    ReaderPool(DatabaseManager& writer, std::size_t size);
+
+    ReaderPool(const ReaderPool&) = delete;
+    ReaderPool& operator=(const ReaderPool&) = delete;
+
+    /// Borrows a connection, waiting while all size() connections are leased.
+    /// @throws std::runtime_error if a new connection cannot be opened.
+    Lease acquire();
+
+    std::size_t size() const { return size_; }
+    /// Connections opened so far.
+    std::size_t open_count() const;
+
+private:
+    void give_back(DatabaseManager* db);
+
+    DatabaseManager& writer_;
+    std::size_t size_;
+    std::vector<std::unique_ptr<DatabaseManager>> connections_;
+    std::vector<DatabaseManager*> idle_;
+    mutable std::mutex mutex_;
+    std::condition_variable returned_;
+};
+
+} // namespace fo::core
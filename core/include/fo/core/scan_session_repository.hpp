@@ -2,6 +2,10 @@
 #include "fo/core/database.hpp"
 #include <string>
 #include <chrono>
+#include <filesystem>
+#include <optional>
+#include <utility>
+#include <vector>
 
 namespace fo::core {
 
@@ -12,15 +16,33 @@ struct ScanSession {
     std::string status;
     int scanned_count = 0;
     int64_t duration_ms = 0;
+    std::string roots;          // scanned roots, one per line
+    std::string filter;         // scan options (see DirectoryRecord::filter)
+    bool detect_moves = false;  // whether new files were held back for move detection
 };
 
 class ScanSessionRepository {
 public:
     explicit ScanSessionRepository(DatabaseManager& db);
 
-    int64_t start_session();
+    int64_t start_session(const std::string& roots = "", const std::string& filter = "", bool detect_moves = false);
     void end_session(int64_t id, const std::string& status, int scanned_count);
 
+    // Latest session over the same roots and options, if it did not complete.
+    std::optional<ScanSession> find_resumable(const std::string& roots, const std::string& filter);
+
+    // Mark an interrupted session as running again.
+    void reopen_session(int64_t id);
+
+    // Record a directory whose files are all committed, with the mtime it was read at.
+    void add_progress(int64_t session_id, int64_t dir_id, int64_t mtime_ns);
+
+    // Directories completed by a session, with their recorded mtimes.
+    std::vector<std::pair<std::filesystem::path, int64_t>> get_progress(int64_t session_id);
+
+    // Forget the progress of every session over the same roots and options.
+    void clear_progress(const std::string& roots, const std::string& filter);
+
 private:
     DatabaseManager& db_;
 };
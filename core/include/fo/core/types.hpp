@@ -3,6 +3,7 @@
 #include <string>
 #include <vector>
 #include <chrono>
+#include <cstdint>
 #include <filesystem>
 
 namespace fo::core {
@@ -13,6 +14,28 @@ struct FileInfo {
     std::uintmax_t size = 0;
     std::chrono::file_clock::time_point mtime{};
     bool is_dir = false;
+    // Physical file identity, if the scanner read it (ino == 0: unknown).
+    // Paths with equal (dev, ino) are hardlinks to the same data.
+    std::uint64_t dev = 0;
+    std::uint64_t ino = 0;
+    std::uint64_t nlink = 0;
+};
+
+// A filesystem change reported by a watcher. The kind is a hint: consumers
+// re-check the path on disk, since events for one path can arrive merged or
+// out of date.
+struct FileChange {
+    enum class Kind {
+        Created,
+        Modified,
+        Removed,
+        Renamed,   // old_path -> path
+        Overflow   // events were lost; a full rescan is needed
+    };
+    Kind kind = Kind::Modified;
+    std::filesystem::path path;
+    std::filesystem::path old_path;
+    bool is_dir = false;
 };
 
 struct DateMetadata {
@@ -0,0 +1,70 @@
+#pragma once
+
+#ifdef __linux__
+
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include <memory>
+#include <vector>
+
+namespace fo::core {
+
+/**
+ * @brief Batched metadata stage backed by io_uring (Linux only).
+ *
+ * Scanners queue directory opens and statx calls, then hand the whole batch
+ * over at once. Requests go through a single io_uring with at most
+ * queue_depth operations in flight, so latency-bound filesystems (NFS/SMB,
+ * spinning disks) overlap round trips instead of paying them one by one.
+ *
+ * If the kernel lacks io_uring, the ring cannot be created (seccomp,
+ * io_uring_disabled sysctl) or IORING_OP_STATX/IORING_OP_OPENAT are not
+ * supported, every batch runs through plain openat()/statx() instead.
+ * Results are identical either way.
+ */
+class UringStatBatch {
+public:
+    struct OpenOp {
+        int dirfd = AT_FDCWD;
+        const char* path = nullptr;   ///< must stay valid until open_all() returns
+        int flags = O_RDONLY | O_DIRECTORY | O_CLOEXEC;
+        int result = 0;               ///< fd on success, -errno on failure
+    };
+
+    struct StatOp {
+        int dirfd = AT_FDCWD;
+        const char* path = nullptr;   ///< must stay valid until stat_all() returns
+        int flags = 0;                ///< AT_* flags as for statx(2)
+        unsigned mask = 0;            ///< STATX_* mask
+        struct statx* out = nullptr;  ///< must stay valid until stat_all() returns
+        int result = 0;               ///< 0 on success, -errno on failure
+    };
+
+    /**
+     * @param queue_depth Upper bound on operations in flight (rounded up to a power of two by the kernel).
+     * @param force_sync Skip io_uring entirely; used by tests and benchmarks for comparison.
+     */
+    explicit UringStatBatch(unsigned queue_depth = 256, bool force_sync = false);
+    ~UringStatBatch();
+
+    UringStatBatch(const UringStatBatch&) = delete;
+    UringStatBatch& operator=(const UringStatBatch&) = delete;
+
+    /// @return true if batches are submitted through io_uring, false if using the synchronous fallback.
+    bool uses_uring() const { return ring_ != nullptr; }
+
+    /// Opens every entry of ops; results are written back into each op.
+    void open_all(std::vector<OpenOp>& ops);
+
+    /// Runs statx for every entry of ops; results are written back into each op.
+    void stat_all(std::vector<StatOp>& ops);
+
+private:
+    struct Ring;
+    std::unique_ptr<Ring> ring_;
+};
+
+} // namespace fo::core
+
+#endif // __linux__
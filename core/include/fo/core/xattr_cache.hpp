@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace fo::core {
+
+/**
+ * @brief Extended attribute hash cache for Linux, the counterpart of ADSCache.
+ *
+ * Hashes are kept in a "user.fo_cache" xattr on the file, so they move with
+ * it to other machines and catalogs (as long as the copy keeps xattrs). The
+ * value is a list of binary records instead of the text lines ADSCache
+ * writes:
+ *
+ *     u8 version (1), then per record:
+ *     i64 mtime_ns (little-endian, unix time) | u8 algo length | algo
+ *     | u8 kind (0: digest bytes of a hex hash, 1: text) | u8 length | value
+ *
+ * A record is only returned while the file's mtime matches. Writing a hash
+ * drops records for other mtimes, so the attribute never grows past one
+ * record per algorithm. Setting an xattr changes the file's ctime, not its
+ * mtime. Filesystems without user xattrs (tmpfs on older kernels, some FUSE
+ * mounts) and read-only mounts make every call fail quietly. On other
+ * platforms all operations are no-ops.
+ */
+class XattrCache {
+public:
+    static constexpr const char* ATTR_NAME = "user.fo_cache";
+
+    /**
+     * @brief Get cached hash for a file.
+     * @param path File path.
+     * @param hash_type Type of hash (e.g., "fast64", "sha256", "blake3").
+     * @return Cached hash value if valid, nullopt if not cached, stale or unsupported.
+     */
+    static std::optional<std::string> get_hash(
+        const std::filesystem::path& path,
+        const std::string& hash_type);
+
+    /**
+     * @brief Store hash in the file's xattr, keeping the other algorithms' records.
+     * @return true if stored, false if the filesystem refused the xattr.
+     */
+    static bool set_hash(
+        const std::filesystem::path& path,
+        const std::string& hash_type,
+        const std::string& hash_value);
+
+    /**
+     * @brief Remove the xattr.
+     * @return true if removed, false if there was none or it could not be removed.
+     */
+    static bool clear(const std::filesystem::path& path);
+
+    /// Value of hash_type in an encoded attribute, if a record for mtime_ns has one.
+    static std::optional<std::string> decode(std::string_view attr, int64_t mtime_ns, const std::string& hash_type);
+
+    /// attr with hash_type's record replaced and records for other mtimes dropped.
+    static std::string encode(std::string_view attr, int64_t mtime_ns,
+                              const std::string& hash_type, const std::string& hash_value);
+};
+
+} // namespace fo::core
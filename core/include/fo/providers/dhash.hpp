@@ -1,5 +1,6 @@
 #pragma once
 
+#include "fo/core/file_reader.hpp"
 #include "fo/core/interfaces.hpp"
 
 namespace fo::providers {
@@ -11,6 +12,9 @@ namespace fo::providers {
 
         std::string name() const override;
         std::string fast64(const std::filesystem::path& file_path) override;
+
+    private:
+        fo::core::FileReader reader_;
     };
 
 } // namespace fo::providers
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "fo/core/file_reader.hpp"
 #include "fo/core/interfaces.hpp"
 
 namespace fo::providers {
@@ -13,6 +14,9 @@ public:
     std::string fast64(const std::filesystem::path& p) override;
     std::optional<std::string> strong(const std::filesystem::path& p) override;
     std::string strong_algo() const override { return "BLAKE3"; }
+
+private:
+    fo::core::FileReader reader_;
 };
 
 } // namespace fo::providers
@@ -1,4 +1,5 @@
 #include "fo/core/ads_cache.hpp"
+#include "fo/core/registry.hpp"
 #include <fstream>
 #include <sstream>
 
@@ -224,5 +225,30 @@ std::optional<std::chrono::file_clock::time_point> ADSCache::get_cached_mtime(
 #endif
 }
 
+#ifdef _WIN32
+namespace {
+
+class ADSSidecarCache : public ISidecarHashCache {
+public:
+    std::string name() const override { return "ads"; }
+    std::optional<std::string> get_hash(const std::filesystem::path& p, const std::string& algo) override {
+        return ADSCache::get_hash(p, algo);
+    }
+    bool set_hash(const std::filesystem::path& p, const std::string& algo, const std::string& value) override {
+        return ADSCache::set_hash(p, algo, value);
+    }
+};
+
+} // namespace
+
+// Static registration
+static bool reg_sidecar_ads = [](){
+    Registry<ISidecarHashCache>::instance().add("ads", [](){ return std::make_unique<ADSSidecarCache>(); });
+    return true;
+}();
+
+void register_sidecar_ads() { (void)reg_sidecar_ads; }
+#endif // _WIN32
+
 } // namespace fo::core
 
@@ -0,0 +1,188 @@
+#include "fo/core/catalog_writer.hpp"
+
+#include <type_traits>
+
+namespace fo::core {
+
+CatalogWriter::CatalogWriter(DatabaseManager& db, CatalogWriterOptions options)
+    : db_(db), options_(options), head_(&stub_), tail_(&stub_) {
+    if (options_.batch_rows == 0) options_.batch_rows = 1;
+    if (options_.queue_capacity == 0) options_.queue_capacity = 1;
+    thread_ = std::thread([this] { run(); });
+}
+
+CatalogWriter::~CatalogWriter() {
+    stop_.store(true);
+    wake();
+    thread_.join();
+}
+
+void CatalogWriter::submit(CatalogWrite write) {
+    // Back-pressure: wait for the writer to catch up
+    if (queued_.load() >= options_.queue_capacity) {
+        std::unique_lock<std::mutex> lock(progress_mutex_);
+        progress_cv_.wait(lock, [&] { return queued_.load() < options_.queue_capacity; });
+    }
+    queued_.fetch_add(1);
+
+    auto* node = new Node{std::move(write)};
+    Node* prev = head_.exchange(node, std::memory_order_acq_rel);
+    prev->next.store(node, std::memory_order_release);
+    submitted_.fetch_add(1);
+
+    if (idle_.load()) wake();
+}
+
+void CatalogWriter::flush() {
+    const std::uint64_t target = submitted_.load();
+    auto current = flush_target_.load();
+    while (current < target && !flush_target_.compare_exchange_weak(current, target)) {}
+    wake();
+
+    std::unique_lock<std::mutex> lock(progress_mutex_);
+    progress_cv_.wait(lock, [&] { return done_.load() >= target; });
+}
+
+std::string CatalogWriter::last_error() const {
+    std::lock_guard<std::mutex> lock(error_mutex_);
+    return last_error_;
+}
+
+void CatalogWriter::wake() {
+    { std::lock_guard<std::mutex> lock(wake_mutex_); }
+    wake_cv_.notify_one();
+}
+
+void CatalogWriter::notify_progress() {
+    { std::lock_guard<std::mutex> lock(progress_mutex_); }
+    progress_cv_.notify_all();
+}
+
+// Only called from the writer thread. Returns nullptr when the queue is empty
+// or a producer is between its exchange and its link.
+CatalogWriter::Node* CatalogWriter::pop() {
+    Node* tail = tail_;
+    Node* next = tail->next.load(std::memory_order_acquire);
+    if (tail == &stub_) {
+        if (!next) return nullptr;
+        tail_ = next;
+        tail = next;
+        next = next->next.load(std::memory_order_acquire);
+    }
+    if (next) {
+        tail_ = next;
+        return tail;
+    }
+    if (tail != head_.load(std::memory_order_acquire)) return nullptr;
+
+    // tail is the last node: put the stub behind it so tail can be handed out
+    stub_.next.store(nullptr, std::memory_order_relaxed);
+    Node* prev = head_.exchange(&stub_, std::memory_order_acq_rel);
+    prev->next.store(&stub_, std::memory_order_release);
+    next = tail->next.load(std::memory_order_acquire);
+    if (next) {
+        tail_ = next;
+        return tail;
+    }
+    return nullptr;
+}
+
+void CatalogWriter::run() {
+    using clock = std::chrono::steady_clock;
+    FileRepository files(db_);
+    OperationRepository operations(db_);
+
+    std::unique_lock<std::recursive_mutex> write_lock;
+    bool in_tx = false;
+    std::size_t tx_rows = 0;
+    std::size_t tx_failed = 0;
+    clock::time_point tx_start;
+
+    auto fail = [&](const std::string& message) {
+        std::lock_guard<std::mutex> lock(error_mutex_);
+        last_error_ = message;
+    };
+
+    auto commit = [&] {
+        try {
+            db_.execute("COMMIT;");
+            committed_.fetch_add(tx_rows - tx_failed);
+        } catch (const std::exception& e) {
+            try { db_.execute("ROLLBACK;"); } catch (...) {}
+            fail(e.what());
+            failed_.fetch_add(tx_rows - tx_failed);
+        }
+        write_lock.unlock();
+        in_tx = false;
+
+        done_.fetch_add(tx_rows);
+        notify_progress();
+        tx_rows = 0;
+        tx_failed = 0;
+    };
+
+    for (;;) {
+        if (Node* node = pop()) {
+            // Wake producers held back by a full queue
+            if (queued_.fetch_sub(1) >= options_.queue_capacity) notify_progress();
+            if (!in_tx) {
+                write_lock = db_.lock_writes();
+                try {
+                    db_.execute("BEGIN TRANSACTION;");
+                } catch (const std::exception& e) {
+                    // Not retried: the write is dropped like any other failed one
+                    write_lock.unlock();
+                    fail(e.what());
+                    failed_.fetch_add(1);
+                    delete node;
+                    done_.fetch_add(1);
+                    notify_progress();
+                    continue;
+                }
+                in_tx = true;
+                tx_start = clock::now();
+            }
+            try {
+                std::visit([&](const auto& w) {
+                    using T = std::decay_t<decltype(w)>;
+                    if constexpr (std::is_same_v<T, HashWrite>) {
+                        files.add_hash(w.file_id, w.algo, w.value, w.token);
+                    } else if constexpr (std::is_same_v<T, TagWrite>) {
+                        files.add_tag(w.file_id, w.tag, w.confidence, w.source);
+                    } else {
+                        operations.log_operation(w);
+                    }
+                }, node->write);
+            } catch (const std::exception& e) {
+                fail(e.what());
+                failed_.fetch_add(1);
+                ++tx_failed;
+            }
+            delete node;
+            ++tx_rows;
+            if (tx_rows >= options_.batch_rows || clock::now() - tx_start >= options_.commit_interval) commit();
+            continue;
+        }
+
+        // Nothing to pop: commit early if someone is waiting or we are stopping
+        if (in_tx && (stop_.load() || flush_target_.load() > done_.load() ||
+                      clock::now() - tx_start >= options_.commit_interval)) {
+            commit();
+            continue;
+        }
+        if (stop_.load() && queued_.load() == 0) break;
+
+        idle_.store(true);
+        {
+            std::unique_lock<std::mutex> lock(wake_mutex_);
+            auto has_work = [&] {
+                return stop_.load() || queued_.load() > 0 || flush_target_.load() > done_.load();
+            };
+            if (in_tx) wake_cv_.wait_until(lock, tx_start + options_.commit_interval, has_work);
+            else wake_cv_.wait(lock, has_work);
+        }
+        idle_.store(false);
+    }
+}
+
+} // namespace fo::core
@@ -1,5 +1,9 @@
 #include "fo/core/database.hpp"
+#include "fo/core/hash_digest.hpp"
 #include <sqlite3.h>
+#include <bit>
+#include <charconv>
+#include <cstring>
 #include <stdexcept>
 #include <iostream>
 #include <filesystem>
@@ -98,6 +102,173 @@ CREATE INDEX IF NOT EXISTS idx_operation_log_status ON operation_log(status);
 CREATE INDEX IF NOT EXISTS idx_operation_log_undone ON operation_log(undone);
 )";
 
+static const char* MIGRATION_4 = R"(
+CREATE TABLE IF NOT EXISTS directories (
+    id INTEGER PRIMARY KEY AUTOINCREMENT,
+    path TEXT NOT NULL UNIQUE,
+    mtime_ns INTEGER NOT NULL DEFAULT 0,
+    child_count INTEGER NOT NULL DEFAULT 0,
+    filter TEXT
+);
+
+ALTER TABLE files ADD COLUMN dir_id INTEGER REFERENCES directories(id) ON DELETE SET NULL;
+
+CREATE INDEX IF NOT EXISTS idx_files_dir_id ON files(dir_id);
+)";
+
+static const char* MIGRATION_5 = R"(
+ALTER TABLE scan_sessions ADD COLUMN roots TEXT;
+ALTER TABLE scan_sessions ADD COLUMN filter TEXT;
+ALTER TABLE scan_sessions ADD COLUMN detect_moves INTEGER NOT NULL DEFAULT 0;
+
+CREATE TABLE IF NOT EXISTS scan_progress (
+    session_id INTEGER NOT NULL REFERENCES scan_sessions(id) ON DELETE CASCADE,
+    dir_id INTEGER NOT NULL REFERENCES directories(id) ON DELETE CASCADE,
+    mtime_ns INTEGER NOT NULL,
+    PRIMARY KEY (session_id, dir_id)
+) WITHOUT ROWID;
+)";
+
+static const char* MIGRATION_6 = R"(
+ALTER TABLE files ADD COLUMN dev INTEGER;
+ALTER TABLE files ADD COLUMN ino INTEGER;
+ALTER TABLE files ADD COLUMN nlink INTEGER;
+
+CREATE INDEX IF NOT EXISTS idx_files_dev_ino ON files(dev, ino);
+)";
+
+// path UNIQUE already has an index; a second one only slows down inserts
+static const char* MIGRATION_7 = R"(
+DROP INDEX IF EXISTS idx_files_path;
+)";
+
+// Hash values become binary: INTEGER for 64-bit digests, BLOB for longer
+// ones (TEXT only for values that are not hex). WITHOUT ROWID lets the
+// (algo, value) index carry file_id, so hash-equality lookups stay in the index.
+static const char* MIGRATION_8 = R"(
+CREATE TABLE file_hashes_v8 (
+    file_id INTEGER NOT NULL,
+    algo TEXT NOT NULL,
+    value NOT NULL,
+    PRIMARY KEY (file_id, algo),
+    FOREIGN KEY (file_id) REFERENCES files(id) ON DELETE CASCADE
+) WITHOUT ROWID;
+
+INSERT INTO file_hashes_v8 (file_id, algo, value)
+    SELECT file_id, algo, fo_hash_value(algo, value) FROM file_hashes;
+DROP TABLE file_hashes;
+ALTER TABLE file_hashes_v8 RENAME TO file_hashes;
+
+CREATE INDEX IF NOT EXISTS idx_hashes_algo_value ON file_hashes(algo, value);
+)";
+
+// Multi-index hashing for 64-bit perceptual hashes: each hash is filed under
+// its four 16-bit bands. Two hashes within Hamming distance r agree within
+// r / 4 bits on at least one band, so a radius query only probes a few keys
+// per band. Triggers keep the bands in step with file_hashes.
+static const char* MIGRATION_9 = R"(
+CREATE TABLE IF NOT EXISTS phash_bands (
+    algo TEXT NOT NULL,
+    band INTEGER NOT NULL,      -- 0..3: bits 16*band .. 16*band+15
+    key INTEGER NOT NULL,
+    file_id INTEGER NOT NULL,
+    value INTEGER NOT NULL,     -- whole hash, so candidates are checked in the index
+    PRIMARY KEY (algo, band, key, file_id)
+) WITHOUT ROWID;
+
+INSERT OR REPLACE INTO phash_bands (algo, band, key, file_id, value)
+    SELECT h.algo, b.band, (h.value >> (16 * b.band)) & 65535, h.file_id, h.value
+    FROM file_hashes h, (SELECT 0 AS band UNION ALL SELECT 1 UNION ALL SELECT 2 UNION ALL SELECT 3) b
+    WHERE h.algo IN ('dhash', 'phash', 'ahash') AND typeof(h.value) = 'integer';
+
+CREATE TRIGGER IF NOT EXISTS file_hashes_bands_insert AFTER INSERT ON file_hashes
+WHEN new.algo IN ('dhash', 'phash', 'ahash') AND typeof(new.value) = 'integer'
+BEGIN
+    INSERT OR REPLACE INTO phash_bands (algo, band, key, file_id, value)
+        SELECT new.algo, b.band, (new.value >> (16 * b.band)) & 65535, new.file_id, new.value
+        FROM (SELECT 0 AS band UNION ALL SELECT 1 UNION ALL SELECT 2 UNION ALL SELECT 3) b;
+END;
+
+CREATE TRIGGER IF NOT EXISTS file_hashes_bands_delete AFTER DELETE ON file_hashes
+WHEN old.algo IN ('dhash', 'phash', 'ahash') AND typeof(old.value) = 'integer'
+BEGIN
+    DELETE FROM phash_bands WHERE algo = old.algo AND band = 0 AND key = old.value & 65535 AND file_id = old.file_id;
+    DELETE FROM phash_bands WHERE algo = old.algo AND band = 1 AND key = (old.value >> 16) & 65535 AND file_id = old.file_id;
+    DELETE FROM phash_bands WHERE algo = old.algo AND band = 2 AND key = (old.value >> 32) & 65535 AND file_id = old.file_id;
+    DELETE FROM phash_bands WHERE algo = old.algo AND band = 3 AND key = (old.value >> 48) & 65535 AND file_id = old.file_id;
+END;
+
+-- Also fired by add_hash's ON CONFLICT DO UPDATE
+CREATE TRIGGER IF NOT EXISTS file_hashes_bands_update AFTER UPDATE OF value ON file_hashes
+WHEN old.algo IN ('dhash', 'phash', 'ahash')
+BEGIN
+    DELETE FROM phash_bands WHERE typeof(old.value) = 'integer' AND algo = old.algo AND band = 0 AND key = old.value & 65535 AND file_id = old.file_id;
+    DELETE FROM phash_bands WHERE typeof(old.value) = 'integer' AND algo = old.algo AND band = 1 AND key = (old.value >> 16) & 65535 AND file_id = old.file_id;
+    DELETE FROM phash_bands WHERE typeof(old.value) = 'integer' AND algo = old.algo AND band = 2 AND key = (old.value >> 32) & 65535 AND file_id = old.file_id;
+    DELETE FROM phash_bands WHERE typeof(old.value) = 'integer' AND algo = old.algo AND band = 3 AND key = (old.value >> 48) & 65535 AND file_id = old.file_id;
+    INSERT OR REPLACE INTO phash_bands (algo, band, key, file_id, value)
+        SELECT new.algo, b.band, (new.value >> (16 * b.band)) & 65535, new.file_id, new.value
+        FROM (SELECT 0 AS band UNION ALL SELECT 1 UNION ALL SELECT 2 UNION ALL SELECT 3) b
+        WHERE typeof(new.value) = 'integer';
+END;
+)";
+
+// Duplicate groups are kept up to date per file (changed files leave their
+// group, find_duplicates rewrites only groups that differ), and deleting a
+// file cascades to its memberships: both look members up by file_id.
+static const char* MIGRATION_10 = R"(
+CREATE INDEX IF NOT EXISTS idx_duplicate_members_file_id ON duplicate_members(file_id);
+)";
+
+// Hash cache: each stored hash records the change token of the file it was
+// computed from (device, inode, size, mtime in nanoseconds) and is only
+// reused while the file still matches. files.mtime holds whole seconds, so
+// the catalog keeps the full mtime alongside it. Rows from before this
+// migration have NULL tokens and are recomputed on first use.
+static const char* MIGRATION_11 = R"(
+ALTER TABLE files ADD COLUMN mtime_ns INTEGER;
+ALTER TABLE file_hashes ADD COLUMN dev INTEGER;
+ALTER TABLE file_hashes ADD COLUMN ino INTEGER;
+ALTER TABLE file_hashes ADD COLUMN size INTEGER;
+ALTER TABLE file_hashes ADD COLUMN mtime_ns INTEGER;
+)";
+
+// fo_hash_value(algo, value): storage form of a hash stored as text by older
+// versions. Perceptual hashes were written in decimal, all others in hex.
+static void sql_hash_value(sqlite3_context* ctx, int, sqlite3_value** argv) {
+    if (sqlite3_value_type(argv[1]) != SQLITE_TEXT) {
+        sqlite3_result_value(ctx, argv[1]);
+        return;
+    }
+    const char* algo = reinterpret_cast<const char*>(sqlite3_value_text(argv[0]));
+    const char* text = reinterpret_cast<const char*>(sqlite3_value_text(argv[1]));
+    const std::size_t len = static_cast<std::size_t>(sqlite3_value_bytes(argv[1]));
+
+    if (algo && (std::strcmp(algo, "dhash") == 0 || std::strcmp(algo, "phash") == 0 || std::strcmp(algo, "ahash") == 0)) {
+        std::uint64_t v = 0;
+        auto [end, ec] = std::from_chars(text, text + len, v);
+        if (ec == std::errc() && end == text + len) {
+            sqlite3_result_int64(ctx, static_cast<sqlite3_int64>(v));
+            return;
+        }
+    }
+    auto digest = HashDigest::from_hex(std::string_view(text, len));
+    if (!digest) {
+        sqlite3_result_value(ctx, argv[1]);
+    } else if (digest->is_u64()) {
+        sqlite3_result_int64(ctx, static_cast<sqlite3_int64>(digest->as_u64()));
+    } else {
+        sqlite3_result_blob(ctx, digest->data(), static_cast<int>(digest->size()), SQLITE_TRANSIENT);
+    }
+}
+
+// fo_hamming(a, b): number of differing bits of two 64-bit integers
+static void sql_hamming(sqlite3_context* ctx, int, sqlite3_value** argv) {
+    auto a = static_cast<std::uint64_t>(sqlite3_value_int64(argv[0]));
+    auto b = static_cast<std::uint64_t>(sqlite3_value_int64(argv[1]));
+    sqlite3_result_int(ctx, std::popcount(a ^ b));
+}
+
 // ------------------
 
 DatabaseManager::DatabaseManager() : db_(nullptr) {}
@@ -106,15 +277,16 @@ DatabaseManager::~DatabaseManager() {
     close();
 }
 
-void DatabaseManager::open(const std::filesystem::path& db_path) {
+void DatabaseManager::open(const std::filesystem::path& db_path, Access access) {
     if (db_) {
         close();
     }
 
     db_path_ = db_path;
+    access_ = access;
     
     // Ensure directory exists
-    if (db_path != ":memory:" && db_path.has_parent_path()) {
+    if (access == Access::ReadWrite && db_path != ":memory:" && db_path.has_parent_path()) {
         std::filesystem::create_directories(db_path.parent_path());
     }
 
@@ -124,7 +296,8 @@ void DatabaseManager::open(const std::filesystem::path& db_path) {
     // For cross-platform simplicity with std::filesystem, generic_string() or string() is usually fine,
     // but let's use sqlite3_open_v2.
 
-    int rc = sqlite3_open(db_path.string().c_str(), &db_);
+    const int flags = access == Access::ReadOnly ? SQLITE_OPEN_READONLY : (SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE);
+    int rc = sqlite3_open_v2(db_path.string().c_str(), &db_, flags, nullptr);
     if (rc != SQLITE_OK) {
         std::string err = db_ ? sqlite3_errmsg(db_) : "Unknown error";
         if (db_) sqlite3_close(db_);
@@ -132,15 +305,28 @@ void DatabaseManager::open(const std::filesystem::path& db_path) {
         throw std::runtime_error("Failed to open database: " + err);
     }
 
+    // Wait for other connections (e.g. a WAL checkpoint) instead of failing with SQLITE_BUSY
+    sqlite3_busy_timeout(db_, kBusyTimeoutMs);
+
     // Enable foreign keys
     execute("PRAGMA foreign_keys = ON;");
-    // WAL mode for better concurrency
-    execute("PRAGMA journal_mode = WAL;");
-    // Synchronous NORMAL is usually safe enough for WAL and faster
-    execute("PRAGMA synchronous = NORMAL;");
+    if (access == Access::ReadWrite) {
+        // WAL mode for better concurrency; readers then never block the writer
+        execute("PRAGMA journal_mode = WAL;");
+        // Synchronous NORMAL is usually safe enough for WAL and faster
+        execute("PRAGMA synchronous = NORMAL;");
+    }
+    // Staging tables for bulk writes never need to reach the disk
+    execute("PRAGMA temp_store = MEMORY;");
+
+    sqlite3_create_function_v2(db_, "fo_hash_value", 2, SQLITE_UTF8 | SQLITE_DETERMINISTIC, nullptr,
+                               sql_hash_value, nullptr, nullptr, nullptr);
+    sqlite3_create_function_v2(db_, "fo_hamming", 2, SQLITE_UTF8 | SQLITE_DETERMINISTIC, nullptr,
+                               sql_hamming, nullptr, nullptr, nullptr);
 }
 
 void DatabaseManager::close() {
+    clear_statements();
     if (db_) {
         sqlite3_close(db_);
         db_ = nullptr;
@@ -151,6 +337,10 @@ sqlite3* DatabaseManager::get_db() const {
     return db_;
 }
 
+std::unique_lock<std::recursive_mutex> DatabaseManager::lock_writes() {
+    return std::unique_lock<std::recursive_mutex>(write_mutex_);
+}
+
 void DatabaseManager::execute(const std::string& sql) {
     char* errMsg = nullptr;
     int rc = sqlite3_exec(db_, sql.c_str(), nullptr, nullptr, &errMsg);
@@ -162,9 +352,8 @@ void DatabaseManager::execute(const std::string& sql) {
 }
 
 int DatabaseManager::query_int(const std::string& sql) {
-    sqlite3_stmt* stmt;
-    int rc = sqlite3_prepare_v2(db_, sql.c_str(), -1, &stmt, nullptr);
-    if (rc != SQLITE_OK) {
+    auto stmt = prepare(sql);
+    if (!stmt) {
         throw std::runtime_error("Failed to prepare statement: " + std::string(sqlite3_errmsg(db_)));
     }
 
@@ -172,10 +361,86 @@ int DatabaseManager::query_int(const std::string& sql) {
     if (sqlite3_step(stmt) == SQLITE_ROW) {
         result = sqlite3_column_int(stmt, 0);
     }
-    sqlite3_finalize(stmt);
     return result;
 }
 
+// --- Statement cache ---
+
+Statement DatabaseManager::prepare(const std::string& sql) {
+    std::lock_guard<std::mutex> lock(statements_mutex_);
+    auto it = statements_.find(sql);
+    if (it != statements_.end() && !it->second.in_use) {
+        it->second.in_use = true;
+        return Statement(this, it->second.stmt, &it->second.in_use);
+    }
+
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v3(db_, sql.c_str(), static_cast<int>(sql.size()), SQLITE_PREPARE_PERSISTENT, &stmt, nullptr) != SQLITE_OK) {
+        sqlite3_finalize(stmt);
+        return Statement();
+    }
+    if (it != statements_.end()) {
+        // Nested use of the same text: this copy is not cached
+        return Statement(this, stmt, nullptr);
+    }
+    auto& slot = statements_.emplace(sql, CachedStatement{stmt, true}).first->second;
+    return Statement(this, stmt, &slot.in_use);
+}
+
+std::size_t DatabaseManager::cached_statement_count() const {
+    std::lock_guard<std::mutex> lock(statements_mutex_);
+    return statements_.size();
+}
+
+void DatabaseManager::give_back(bool* in_use) {
+    std::lock_guard<std::mutex> lock(statements_mutex_);
+    *in_use = false;
+}
+
+void DatabaseManager::clear_statements() {
+    std::lock_guard<std::mutex> lock(statements_mutex_);
+    for (auto& [sql, cached] : statements_) {
+        sqlite3_finalize(cached.stmt);
+    }
+    statements_.clear();
+}
+
+Statement::Statement(Statement&& other) noexcept
+    : owner_(other.owner_), stmt_(other.stmt_), in_use_(other.in_use_) {
+    other.owner_ = nullptr;
+    other.stmt_ = nullptr;
+}
+
+Statement& Statement::operator=(Statement&& other) noexcept {
+    if (this != &other) {
+        release();
+        owner_ = other.owner_;
+        stmt_ = other.stmt_;
+        in_use_ = other.in_use_;
+        other.owner_ = nullptr;
+        other.stmt_ = nullptr;
+    }
+    return *this;
+}
+
+Statement::~Statement() {
+    release();
+}
+
+void Statement::release() {
+    if (!stmt_) return;
+    if (in_use_) {
+        sqlite3_reset(stmt_);
+        sqlite3_clear_bindings(stmt_);
+        owner_->give_back(in_use_);
+    } else {
+        sqlite3_finalize(stmt_);
+    }
+    stmt_ = nullptr;
+    owner_ = nullptr;
+    in_use_ = nullptr;
+}
+
 int DatabaseManager::get_current_version() {
     // Check if table exists first
     int table_exists = query_int("SELECT count(*) FROM sqlite_master WHERE type='table' AND name='schema_version';");
@@ -209,6 +474,30 @@ void DatabaseManager::migrate() {
     if (current_ver < 3) {
         apply_migration(3, MIGRATION_3);
     }
+    if (current_ver < 4) {
+        apply_migration(4, MIGRATION_4);
+    }
+    if (current_ver < 5) {
+        apply_migration(5, MIGRATION_5);
+    }
+    if (current_ver < 6) {
+        apply_migration(6, MIGRATION_6);
+    }
+    if (current_ver < 7) {
+        apply_migration(7, MIGRATION_7);
+    }
+    if (current_ver < 8) {
+        apply_migration(8, MIGRATION_8);
+    }
+    if (current_ver < 9) {
+        apply_migration(9, MIGRATION_9);
+    }
+    if (current_ver < 10) {
+        apply_migration(10, MIGRATION_10);
+    }
+    if (current_ver < 11) {
+        apply_migration(11, MIGRATION_11);
+    }
 }
 
 } // namespace fo::core
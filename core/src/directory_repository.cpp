@@ -0,0 +1,198 @@
+#include "fo/core/directory_repository.hpp"
+#include <sqlite3.h>
+#include <algorithm>
+#include <stdexcept>
+
+namespace fo::core {
+
+// Helper to convert unix time in nanoseconds (files.mtime_ns) to file_time
+static std::chrono::file_clock::time_point from_unix_ns(int64_t ns) {
+    std::chrono::system_clock::time_point sys{
+        std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds(ns))};
+    return std::chrono::clock_cast<std::chrono::file_clock>(sys);
+}
+
+// A directory and everything below it: the path itself plus the range
+// [dir + sep, dir + (sep + 1)), both answered from the unique path index.
+struct Subtree {
+    std::string base, lo, hi;
+};
+
+static Subtree subtree_of(const std::filesystem::path& dir) {
+    const char sep = static_cast<char>(std::filesystem::path::preferred_separator);
+    Subtree t;
+    t.base = dir.string();
+    while (t.base.size() > 1 && t.base.back() == sep) t.base.pop_back();
+    std::string prefix = t.base.size() == 1 && t.base[0] == sep ? std::string() : t.base;   // "/" itself
+    t.lo = prefix + sep;
+    t.hi = prefix + static_cast<char>(sep + 1);
+    return t;
+}
+
+// Sorted subtrees of the roots, leaving out roots that lie inside another
+static std::vector<Subtree> subtrees_of(const std::vector<std::filesystem::path>& roots) {
+    std::vector<Subtree> all;
+    for (const auto& root : roots) all.push_back(subtree_of(root));
+    std::sort(all.begin(), all.end(), [](const Subtree& a, const Subtree& b) { return a.base < b.base; });
+    std::vector<Subtree> out;
+    for (auto& t : all) {
+        if (!out.empty() && (t.base == out.back().base || (t.base >= out.back().lo && t.base < out.back().hi))) continue;
+        out.push_back(std::move(t));
+    }
+    return out;
+}
+
+static void bind_subtree(sqlite3_stmt* stmt, const Subtree& t) {
+    sqlite3_bind_text(stmt, 1, t.base.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 2, t.lo.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 3, t.hi.c_str(), -1, SQLITE_STATIC);
+}
+
+static DirectoryRecord read_record(sqlite3_stmt* stmt) {
+    DirectoryRecord r;
+    r.id = sqlite3_column_int64(stmt, 0);
+    const char* path_c = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+    if (path_c) r.path = std::filesystem::u8path(path_c);
+    r.mtime_ns = sqlite3_column_int64(stmt, 2);
+    r.child_count = sqlite3_column_int64(stmt, 3);
+    const char* filter_c = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 4));
+    if (filter_c) r.filter = filter_c;
+    return r;
+}
+
+DirectoryRepository::DirectoryRepository(DatabaseManager& db) : db_(db) {}
+
+int64_t DirectoryRepository::ensure(const std::filesystem::path& path) {
+    // The no-op update makes RETURNING yield the id of an existing row too
+    std::string sql = "INSERT INTO directories (path) VALUES (?) "
+                      "ON CONFLICT(path) DO UPDATE SET path=excluded.path RETURNING id;";
+    auto stmt = db_.prepare(sql);
+    if (!stmt) {
+        throw std::runtime_error("Failed to prepare directory insert: " + std::string(sqlite3_errmsg(db_.get_db())));
+    }
+
+    std::string path_str = path.string();
+    sqlite3_bind_text(stmt, 1, path_str.c_str(), -1, SQLITE_STATIC);
+
+    int64_t id = 0;
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        id = sqlite3_column_int64(stmt, 0);
+    } else {
+        throw std::runtime_error("Failed to execute directory insert: " + std::string(sqlite3_errmsg(db_.get_db())));
+    }
+    return id;
+}
+
+void DirectoryRepository::update_state(int64_t id, int64_t mtime_ns, int64_t child_count, const std::string& filter) {
+    std::string sql = "UPDATE directories SET mtime_ns=?, child_count=?, filter=? WHERE id=?;";
+    auto stmt = db_.prepare(sql);
+    if (!stmt) {
+        throw std::runtime_error("Failed to prepare directory update: " + std::string(sqlite3_errmsg(db_.get_db())));
+    }
+
+    sqlite3_bind_int64(stmt, 1, mtime_ns);
+    sqlite3_bind_int64(stmt, 2, child_count);
+    sqlite3_bind_text(stmt, 3, filter.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_int64(stmt, 4, id);
+
+    if (sqlite3_step(stmt) != SQLITE_DONE) {
+        throw std::runtime_error("Failed to execute directory update: " + std::string(sqlite3_errmsg(db_.get_db())));
+    }
+}
+
+std::vector<DirectoryRecord> DirectoryRepository::get_under(const std::vector<std::filesystem::path>& roots) {
+    std::vector<DirectoryRecord> out;
+    auto stmt = db_.prepare("SELECT id, path, mtime_ns, child_count, filter FROM directories "
+                            "WHERE path = ? OR (path >= ? AND path < ?);");
+    if (!stmt) return out;
+
+    for (const auto& t : subtrees_of(roots)) {
+        bind_subtree(stmt, t);
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            out.push_back(read_record(stmt));
+        }
+        sqlite3_reset(stmt);
+    }
+    return out;
+}
+
+std::optional<DirectoryRecord> DirectoryRepository::get_by_path(const std::filesystem::path& path) {
+    std::string sql = "SELECT id, path, mtime_ns, child_count, filter FROM directories WHERE path = ?;";
+    auto stmt = db_.prepare(sql);
+    if (!stmt) return std::nullopt;
+
+    std::string path_str = path.string();
+    sqlite3_bind_text(stmt, 1, path_str.c_str(), -1, SQLITE_STATIC);
+
+    std::optional<DirectoryRecord> result;
+    if (sqlite3_step(stmt) == SQLITE_ROW) result = read_record(stmt);
+    return result;
+}
+
+std::vector<FileInfo> DirectoryRepository::get_files(int64_t dir_id) {
+    std::vector<FileInfo> out;
+    std::string sql = "SELECT id, path, size, COALESCE(mtime_ns, mtime * 1000000000), is_dir, dev, ino, nlink "
+                      "FROM files WHERE dir_id = ?;";
+    auto stmt = db_.prepare(sql);
+    if (!stmt) return out;
+
+    sqlite3_bind_int64(stmt, 1, dir_id);
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        FileInfo fi;
+        fi.id = sqlite3_column_int64(stmt, 0);
+        const char* path_c = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+        if (path_c) fi.path = std::filesystem::u8path(path_c);
+        fi.size = static_cast<std::uintmax_t>(sqlite3_column_int64(stmt, 2));
+        fi.mtime = from_unix_ns(sqlite3_column_int64(stmt, 3));
+        fi.is_dir = sqlite3_column_int(stmt, 4) != 0;
+        if (sqlite3_column_type(stmt, 6) != SQLITE_NULL) {
+            fi.dev = static_cast<std::uint64_t>(sqlite3_column_int64(stmt, 5));
+            fi.ino = static_cast<std::uint64_t>(sqlite3_column_int64(stmt, 6));
+            fi.nlink = static_cast<std::uint64_t>(sqlite3_column_int64(stmt, 7));
+        }
+        out.push_back(std::move(fi));
+    }
+    return out;
+}
+
+void DirectoryRepository::remove_tree(const std::filesystem::path& dir) {
+    auto stmt = db_.prepare("DELETE FROM directories WHERE path = ? OR (path >= ? AND path < ?);");
+    if (!stmt) {
+        throw std::runtime_error("Failed to prepare directory delete: " + std::string(sqlite3_errmsg(db_.get_db())));
+    }
+    auto t = subtree_of(dir);
+    bind_subtree(stmt, t);
+    sqlite3_step(stmt);
+}
+
+void DirectoryRepository::prune_missing(const std::vector<int64_t>& present_ids, const std::vector<std::filesystem::path>& roots) {
+    if (roots.empty()) return;
+
+    // Take the difference in memory; the range scan only reads the path index
+    std::vector<int64_t> present(present_ids);
+    std::sort(present.begin(), present.end());
+    std::vector<int64_t> missing;
+    if (auto stmt = db_.prepare("SELECT id FROM directories WHERE path = ? OR (path >= ? AND path < ?);")) {
+        for (const auto& t : subtrees_of(roots)) {
+            bind_subtree(stmt, t);
+            while (sqlite3_step(stmt) == SQLITE_ROW) {
+                int64_t id = sqlite3_column_int64(stmt, 0);
+                if (!std::binary_search(present.begin(), present.end(), id)) missing.push_back(id);
+            }
+            sqlite3_reset(stmt);
+        }
+    }
+    if (missing.empty()) return;
+
+    auto del_stmt = db_.prepare("DELETE FROM directories WHERE id = ?;");
+    if (!del_stmt) {
+        throw std::runtime_error("Failed to prepare directory delete: " + std::string(sqlite3_errmsg(db_.get_db())));
+    }
+    for (auto id : missing) {
+        sqlite3_bind_int64(del_stmt, 1, id);
+        sqlite3_step(del_stmt);
+        sqlite3_reset(del_stmt);
+    }
+}
+
+} // namespace fo::core
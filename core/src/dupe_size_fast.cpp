@@ -1,5 +1,6 @@
 #include "fo/core/interfaces.hpp"
 #include "fo/core/registry.hpp"
+#include "fo/core/file_identity.hpp"
 #include <unordered_map>
 
 namespace fo::core {
@@ -20,17 +21,22 @@ public:
         for (auto& kv : by_size) {
             auto& vec = kv.second;
             if (vec.size() < 2) continue; // no dups possible
-            std::unordered_map<std::string, std::vector<const FileInfo*>> by_fast;
-            for (auto* fi : vec) {
-                auto h = hasher.fast64(fi->path);
-                by_fast[h].push_back(fi);
+            auto physical = group_by_inode(vec);
+            if (physical.size() < 2) continue; // hardlinks of a single file
+            std::unordered_map<std::string, std::vector<const std::vector<const FileInfo*>*>> by_fast;
+            for (const auto& paths : physical) {
+                auto h = hasher.fast64(paths.front()->path);
+                by_fast[h].push_back(&paths);
             }
             for (auto& hv : by_fast) {
                 if (hv.second.size() < 2) continue;
                 DuplicateGroup g;
                 g.size = kv.first;
                 g.fast64 = hv.first;
-                for (auto* fi : hv.second) g.files.push_back(*fi);
+                for (auto* paths : hv.second) {
+                    g.files.push_back(*paths->front());
+                    for (size_t i = 1; i < paths->size(); ++i) g.links.push_back(*(*paths)[i]);
+                }
                 groups.push_back(std::move(g));
             }
         }
@@ -0,0 +1,190 @@
+#include "fo/core/duplicate_finders.hpp"
+#include "fo/core/file_identity.hpp"
+#include "fo/core/file_reader.hpp"
+#include "fo/core/hash_digest.hpp"
+#include "fo/core/hash_executor.hpp"
+#include "fo/core/registry.hpp"
+
+// Use xxHash in header-only mode
+#define XXH_INLINE_ALL
+#include "../../libs/xxHash/xxhash.h"
+
+#include <atomic>
+#include <deque>
+#include <unordered_map>
+
+namespace fo::core {
+
+namespace {
+
+using Physical = std::vector<const FileInfo*>;   // the paths of one inode
+
+struct Bucket {
+    std::uintmax_t size = 0;
+    std::string hash;                  // of the last stage that split it
+    std::vector<const Physical*> files;
+};
+
+// One reader per hashing worker; the executor's threads end with each run
+thread_local FileReader reader;
+
+// XXH3 over the given (offset, length) windows of f, each clipped to the file.
+// Empty if the file cannot be opened or read.
+std::string hash_windows(const FileInfo& f, std::initializer_list<std::pair<std::uint64_t, std::size_t>> windows,
+                         std::atomic<std::uint64_t>& bytes_read) {
+    if (!reader.open(f.path, FileReader::Access::Sampled)) return {};
+    XXH3_state_t state;
+    XXH3_64bits_reset(&state);
+    std::uint64_t got = 0;
+    for (auto [offset, len] : windows) {
+        auto data = reader.read(offset, len);
+        if (data.empty() && offset < reader.size()) {
+            reader.close();
+            return {};
+        }
+        XXH3_64bits_update(&state, data.data(), data.size());
+        got += data.size();
+    }
+    reader.close();
+    bytes_read.fetch_add(got, std::memory_order_relaxed);
+    return to_hex64(XXH3_64bits_digest(&state));
+}
+
+std::string hash_file(const FileInfo& f, std::atomic<std::uint64_t>& bytes_read) {
+    if (!reader.open(f.path, FileReader::Access::Sequential)) return {};
+    XXH3_state_t state;
+    XXH3_64bits_reset(&state);
+    const bool ok = reader.for_each_block([&](std::span<const std::uint8_t> block) {
+        XXH3_64bits_update(&state, block.data(), block.size());
+    });
+    const std::uint64_t size = reader.size();
+    reader.close();
+    if (!ok) return {};
+    bytes_read.fetch_add(size, std::memory_order_relaxed);
+    return to_hex64(XXH3_64bits_digest(&state));
+}
+
+std::size_t count(const std::vector<Bucket>& buckets) {
+    std::size_t n = 0;
+    for (const auto& b : buckets) n += b.files.size();
+    return n;
+}
+
+// Splits each bucket by the hash job computes for its files and keeps the
+// parts of two or more files; files whose hash came back empty are dropped.
+std::vector<Bucket> refine(const std::vector<Bucket>& buckets, HashExecutor& executor, IHasher& hasher,
+                           const HashExecutor::Job& job) {
+    std::vector<HashBucket> work(buckets.size());
+    for (size_t i = 0; i < buckets.size(); ++i) {
+        for (const auto* paths : buckets[i].files) work[i].files.push_back(paths->front());
+    }
+    executor.run(work, hasher, job);
+
+    std::vector<Bucket> out;
+    for (size_t i = 0; i < buckets.size(); ++i) {
+        std::unordered_map<std::string, std::vector<const Physical*>> parts;
+        for (size_t j = 0; j < work[i].hashes.size(); ++j) {
+            if (!work[i].hashes[j].empty()) parts[work[i].hashes[j]].push_back(buckets[i].files[j]);
+        }
+        for (auto& [hash, files] : parts) {
+            if (files.size() >= 2) out.push_back({buckets[i].size, hash, std::move(files)});
+        }
+    }
+    return out;
+}
+
+} // namespace
+
+std::vector<DuplicateGroup> MultiStageDuplicateFinder::group(const std::vector<FileInfo>& files, IHasher& hasher) {
+    stats_.clear();
+    HashExecutor sequential(1);
+    HashExecutor& executor = executor_ ? *executor_ : sequential;
+
+    // Stage 1: size, with hardlinks folded into one physical file
+    auto& by_size_stats = stats_.emplace_back(FinderStageStats{"size"});
+    std::unordered_map<std::uintmax_t, std::vector<const FileInfo*>> by_size;
+    by_size.reserve(files.size());
+    for (const auto& f : files) {
+        if (f.size == static_cast<std::uintmax_t>(-1)) continue;
+        by_size[f.size].push_back(&f);
+        ++by_size_stats.candidates;
+    }
+    std::deque<Physical> physical;   // the buckets point into it
+    std::vector<Bucket> buckets;
+    for (auto& [size, vec] : by_size) {
+        if (vec.size() < 2) continue;
+        auto inodes = group_by_inode(vec);
+        if (inodes.size() < 2) continue;
+        auto& b = buckets.emplace_back();
+        b.size = size;
+        for (auto& paths : inodes) b.files.push_back(&physical.emplace_back(std::move(paths)));
+    }
+    by_size_stats.remaining = count(buckets);
+
+    std::vector<Bucket> done;   // buckets whose files were read in full
+    auto run_stage = [&](const char* name, const auto& hash) {
+        std::atomic<std::uint64_t> bytes{0};
+        FinderStageStats stage{name, count(buckets)};
+        buckets = refine(buckets, executor, hasher, [&](IHasher& h, const FileInfo& f) {
+            return executor.read([&] { return hash(h, f, bytes); });
+        });
+        stage.remaining = count(buckets);
+        stage.bytes_read = bytes.load();
+        stats_.push_back(std::move(stage));
+    };
+    // Moves the buckets of files no longer than covered bytes to done
+    auto settle = [&](std::uintmax_t covered) {
+        std::vector<Bucket> open;
+        for (auto& b : buckets) (b.size <= covered ? done : open).push_back(std::move(b));
+        buckets = std::move(open);
+    };
+
+    // Stage 2: the head of the file
+    run_stage("head", [](IHasher&, const FileInfo& f, std::atomic<std::uint64_t>& bytes) {
+        return hash_windows(f, {{0, kHeadBytes}}, bytes);
+    });
+    settle(kHeadBytes);
+
+    // Stage 3: a window from the middle and the last one. With the head they
+    // cover every file of up to kHeadBytes + 2 * kSampleBytes.
+    run_stage("sample", [](IHasher&, const FileInfo& f, std::atomic<std::uint64_t>& bytes) {
+        const std::uint64_t middle = f.size / 2 - kSampleBytes / 2;
+        return hash_windows(f, {{middle, kSampleBytes}, {f.size - kSampleBytes, kSampleBytes}}, bytes);
+    });
+    settle(kHeadBytes + 2 * kSampleBytes);
+
+    // Stage 4: the whole file
+    const bool strong = !hasher.strong_algo().empty();
+    run_stage("full", [strong](IHasher& h, const FileInfo& f, std::atomic<std::uint64_t>& bytes) {
+        if (!strong) return hash_file(f, bytes);
+        auto value = h.strong(f.path);
+        if (!value) return std::string();
+        bytes.fetch_add(f.size, std::memory_order_relaxed);
+        return *value;
+    });
+    for (auto& b : buckets) done.push_back(std::move(b));
+
+    std::vector<DuplicateGroup> groups;
+    groups.reserve(done.size());
+    for (const auto& b : done) {
+        DuplicateGroup g;
+        g.size = b.size;
+        g.fast64 = b.hash;
+        for (const auto* paths : b.files) {
+            g.files.push_back(*paths->front());
+            for (size_t i = 1; i < paths->size(); ++i) g.links.push_back(*(*paths)[i]);
+        }
+        groups.push_back(std::move(g));
+    }
+    return groups;
+}
+
+// Static registration
+static bool reg_finder_multistage = [](){
+    Registry<IDuplicateFinder>::instance().add("multistage", [](){ return std::make_unique<MultiStageDuplicateFinder>(); });
+    return true;
+}();
+
+void register_finder_multistage() { (void)reg_finder_multistage; }
+
+} // namespace fo::core
@@ -1,21 +1,32 @@
 #include "fo/core/duplicate_finders.hpp"
+#include "fo/core/file_identity.hpp"
+#include "fo/core/registry.hpp"
 #include <map>
 #include <fstream>
 
 namespace fo::core {
 
 std::vector<DuplicateGroup> SizeHashDuplicateFinder::group(const std::vector<FileInfo>& files, IHasher& hasher) {
-    std::map<std::pair<std::uintmax_t, std::string>, std::vector<FileInfo>> groups;
-
-    for (const auto& file : files) {
+    std::vector<const FileInfo*> all;
+    all.reserve(files.size());
+    for (const auto& file : files) all.push_back(&file);
+
+    // Hash each physical file once; its other hardlinks travel along
+    std::map<std::pair<std::uintmax_t, std::string>, DuplicateGroup> groups;
+    for (const auto& paths : group_by_inode(all)) {
+        const FileInfo& file = *paths.front();
         std::string fast_hash = hasher.fast64(file.path);
-        groups[{file.size, fast_hash}].push_back(file);
+        auto& g = groups[{file.size, fast_hash}];
+        g.files.push_back(file);
+        for (size_t i = 1; i < paths.size(); ++i) g.links.push_back(*paths[i]);
     }
 
     std::vector<DuplicateGroup> result;
-    for (auto const& [key, val] : groups) {
-        if (val.size() > 1) {
-            result.push_back({key.first, key.second, val});
+    for (auto& [key, val] : groups) {
+        if (val.files.size() > 1) {
+            val.size = key.first;
+            val.fast64 = key.second;
+            result.push_back(std::move(val));
         }
     }
 
@@ -62,11 +73,29 @@ std::vector<DuplicateGroup> SizeHashByteDuplicateFinder::group(const std::vector
         }
 
         if (verified_files.size() > 1) {
-            result.push_back({group.size, group.fast64, verified_files});
+            // Keep the hardlinks of the files that were confirmed
+            std::vector<FileInfo> links;
+            for (const auto& l : group.links) {
+                auto lid = file_identity(l);
+                for (const auto& v : verified_files) {
+                    auto vid = file_identity(v);
+                    if (vid.ino == lid.ino && vid.dev == lid.dev) { links.push_back(l); break; }
+                }
+            }
+            result.push_back({group.size, group.fast64, verified_files, std::move(links)});
         }
     }
 
     return result;
 }
 
+// Static registration
+static bool reg_finder_size_hash = [](){
+    Registry<IDuplicateFinder>::instance().add("size_hash", [](){ return std::make_unique<SizeHashDuplicateFinder>(); });
+    Registry<IDuplicateFinder>::instance().add("size_hash_byte", [](){ return std::make_unique<SizeHashByteDuplicateFinder>(); });
+    return true;
+}();
+
+void register_finder_size_hash() { (void)reg_finder_size_hash; }
+
 }
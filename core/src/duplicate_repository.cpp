@@ -1,15 +1,37 @@
 #include "fo/core/duplicate_repository.hpp"
 #include <sqlite3.h>
+#include <algorithm>
+#include <initializer_list>
+#include <iterator>
 #include <stdexcept>
+#include <unordered_map>
+#include <utility>
 
 namespace fo::core {
 
+// Columns 2.. of the group queries: the member's row in files, stored like
+// FileRepository does (unix nanoseconds, NULL identity while unknown)
+static void read_file(sqlite3_stmt* stmt, int first, FileInfo& fi) {
+    fi.id = sqlite3_column_int64(stmt, first);
+    const char* path_c = reinterpret_cast<const char*>(sqlite3_column_text(stmt, first + 1));
+    if (path_c) fi.path = std::filesystem::u8path(path_c);
+    fi.size = static_cast<std::uintmax_t>(sqlite3_column_int64(stmt, first + 2));
+    std::chrono::system_clock::time_point sys{std::chrono::duration_cast<std::chrono::system_clock::duration>(
+        std::chrono::nanoseconds(sqlite3_column_int64(stmt, first + 3)))};
+    fi.mtime = std::chrono::clock_cast<std::chrono::file_clock>(sys);
+    fi.is_dir = sqlite3_column_int(stmt, first + 4) != 0;
+    if (sqlite3_column_type(stmt, first + 6) == SQLITE_NULL) return;
+    fi.dev = static_cast<std::uint64_t>(sqlite3_column_int64(stmt, first + 5));
+    fi.ino = static_cast<std::uint64_t>(sqlite3_column_int64(stmt, first + 6));
+    fi.nlink = static_cast<std::uint64_t>(sqlite3_column_int64(stmt, first + 7));
+}
+
 DuplicateRepository::DuplicateRepository(DatabaseManager& db) : db_(db) {}
 
 int64_t DuplicateRepository::create_group(int64_t primary_file_id) {
     std::string sql = "INSERT INTO duplicate_groups (primary_file_id) VALUES (?) RETURNING id;";
-    sqlite3_stmt* stmt;
-    if (sqlite3_prepare_v2(db_.get_db(), sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+    auto stmt = db_.prepare(sql);
+    if (!stmt) {
         throw std::runtime_error("Prepare failed");
     }
     sqlite3_bind_int64(stmt, 1, primary_file_id);
@@ -18,54 +40,227 @@ int64_t DuplicateRepository::create_group(int64_t primary_file_id) {
     if (sqlite3_step(stmt) == SQLITE_ROW) {
         id = sqlite3_column_int64(stmt, 0);
     }
-    sqlite3_finalize(stmt);
     return id;
 }
 
 void DuplicateRepository::add_member(int64_t group_id, int64_t file_id) {
     std::string sql = "INSERT OR IGNORE INTO duplicate_members (group_id, file_id) VALUES (?, ?);";
-    sqlite3_stmt* stmt;
-    if (sqlite3_prepare_v2(db_.get_db(), sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) return;
+    auto stmt = db_.prepare(sql);
+    if (!stmt) return;
     
     sqlite3_bind_int64(stmt, 1, group_id);
     sqlite3_bind_int64(stmt, 2, file_id);
     sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
+}
+
+std::vector<int64_t> DuplicateRepository::create_groups(const std::vector<std::vector<int64_t>>& groups) {
+    std::vector<int64_t> ids;
+    ids.reserve(groups.size());
+    if (groups.empty()) return ids;
+
+    auto group_stmt = db_.prepare("INSERT INTO duplicate_groups (primary_file_id) VALUES (?) RETURNING id;");
+    auto member_stmt = db_.prepare("INSERT OR IGNORE INTO duplicate_members (group_id, file_id) VALUES (?, ?);");
+    if (!group_stmt || !member_stmt) {
+        throw std::runtime_error("Prepare failed: " + std::string(sqlite3_errmsg(db_.get_db())));
+    }
+    auto fail = [&](sqlite3_stmt* stmt) {
+        std::string err = sqlite3_errmsg(db_.get_db());
+        sqlite3_reset(stmt);
+        throw std::runtime_error("Failed to store duplicate group: " + err);
+    };
+
+    for (const auto& members : groups) {
+        if (members.empty()) {
+            ids.push_back(0);
+            continue;
+        }
+        sqlite3_bind_int64(group_stmt, 1, members.front());
+        if (sqlite3_step(group_stmt) != SQLITE_ROW) fail(group_stmt);
+        const int64_t gid = sqlite3_column_int64(group_stmt, 0);
+        sqlite3_reset(group_stmt);
+        ids.push_back(gid);
+
+        sqlite3_bind_int64(member_stmt, 1, gid);
+        for (auto file_id : members) {
+            sqlite3_bind_int64(member_stmt, 2, file_id);
+            if (sqlite3_step(member_stmt) != SQLITE_DONE) fail(member_stmt);
+            sqlite3_reset(member_stmt);
+        }
+    }
+    return ids;
+}
+
+std::vector<int64_t> DuplicateRepository::sync_groups(const std::vector<std::vector<int64_t>>& groups) {
+    std::vector<int64_t> ids(groups.size(), 0);
+    std::unordered_map<int64_t, std::size_t> target_of;   // file id -> index into groups
+    for (std::size_t i = 0; i < groups.size(); ++i) {
+        for (auto id : groups[i]) target_of.emplace(id, i);
+    }
+
+    auto insert_member = db_.prepare("INSERT OR IGNORE INTO duplicate_members (group_id, file_id) VALUES (?, ?);");
+    auto delete_member = db_.prepare("DELETE FROM duplicate_members WHERE group_id = ? AND file_id = ?;");
+    auto set_primary = db_.prepare("UPDATE duplicate_groups SET primary_file_id = ? WHERE id = ?;");
+    auto delete_group = db_.prepare("DELETE FROM duplicate_groups WHERE id = ?;");
+    if (!insert_member || !delete_member || !set_primary || !delete_group) {
+        throw std::runtime_error("Prepare failed: " + std::string(sqlite3_errmsg(db_.get_db())));
+    }
+    auto run = [&](sqlite3_stmt* stmt, std::initializer_list<int64_t> args) {
+        int index = 1;
+        for (auto v : args) sqlite3_bind_int64(stmt, index++, v);
+        int rc = sqlite3_step(stmt);
+        sqlite3_reset(stmt);
+        if (rc != SQLITE_DONE) {
+            throw std::runtime_error("Failed to update duplicate group: " + std::string(sqlite3_errmsg(db_.get_db())));
+        }
+    };
+
+    std::vector<int64_t> wanted;
+    std::vector<int64_t> diff;
+    for (auto& stored : get_all_groups()) {
+        // Claim the first new group this one shares a member with, primary first
+        std::size_t target = groups.size();
+        auto claim = [&](int64_t file_id) {
+            auto t = target_of.find(file_id);
+            if (t != target_of.end() && ids[t->second] == 0) target = t->second;
+            return target != groups.size();
+        };
+        if (!claim(stored.primary_file_id)) {
+            for (auto id : stored.member_ids) {
+                if (claim(id)) break;
+            }
+        }
+        if (target == groups.size()) {
+            run(delete_group, {stored.id});   // members cascade
+            continue;
+        }
+        ids[target] = stored.id;
+
+        wanted = groups[target];
+        std::sort(wanted.begin(), wanted.end());
+        // member_ids come sorted by file_id
+        diff.clear();
+        std::set_difference(wanted.begin(), wanted.end(), stored.member_ids.begin(), stored.member_ids.end(),
+                            std::back_inserter(diff));
+        for (auto id : diff) run(insert_member, {stored.id, id});
+        diff.clear();
+        std::set_difference(stored.member_ids.begin(), stored.member_ids.end(), wanted.begin(), wanted.end(),
+                            std::back_inserter(diff));
+        for (auto id : diff) run(delete_member, {stored.id, id});
+        if (!std::binary_search(wanted.begin(), wanted.end(), stored.primary_file_id)) {
+            run(set_primary, {groups[target].front(), stored.id});
+        }
+    }
+
+    // What is left has no stored counterpart
+    std::vector<std::vector<int64_t>> fresh;
+    std::vector<std::size_t> fresh_at;
+    for (std::size_t i = 0; i < groups.size(); ++i) {
+        if (ids[i] != 0 || groups[i].empty()) continue;
+        fresh.push_back(groups[i]);
+        fresh_at.push_back(i);
+    }
+    auto created = create_groups(fresh);
+    for (std::size_t i = 0; i < created.size(); ++i) ids[fresh_at[i]] = created[i];
+    return ids;
 }
 
 void DuplicateRepository::clear_all() {
     db_.execute("DELETE FROM duplicate_groups;"); // Cascade deletes members
 }
 
+void DuplicateRepository::remove_files(const std::vector<int64_t>& file_ids) {
+    if (file_ids.empty()) return;
+
+    auto del_stmt = db_.prepare("DELETE FROM duplicate_members WHERE file_id = ?;");
+    if (!del_stmt) {
+        throw std::runtime_error("Prepare failed");
+    }
+    std::string sql = "UPDATE duplicate_groups SET primary_file_id = "
+                      "(SELECT file_id FROM duplicate_members m WHERE m.group_id = duplicate_groups.id LIMIT 1) "
+                      "WHERE primary_file_id = ?;";
+    auto primary_stmt = db_.prepare(sql);
+    if (!primary_stmt) {
+        throw std::runtime_error("Prepare failed");
+    }
+    for (auto id : file_ids) {
+        sqlite3_bind_int64(del_stmt, 1, id);
+        sqlite3_step(del_stmt);
+        sqlite3_reset(del_stmt);
+        sqlite3_bind_int64(primary_stmt, 1, id);
+        sqlite3_step(primary_stmt);
+        sqlite3_reset(primary_stmt);
+    }
+
+    // A group of one is no longer a duplicate group (cascade deletes the member)
+    db_.execute("DELETE FROM duplicate_groups WHERE "
+                "(SELECT COUNT(*) FROM duplicate_members m WHERE m.group_id = duplicate_groups.id) < 2;");
+}
+
 std::vector<DuplicateGroupDB> DuplicateRepository::get_all_groups() {
     std::vector<DuplicateGroupDB> groups;
-    
-    // Get groups
-    std::string sql = "SELECT id, primary_file_id FROM duplicate_groups;";
-    sqlite3_stmt* stmt;
-    if (sqlite3_prepare_v2(db_.get_db(), sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) return groups;
-    
+
+    // Members come in (group_id, file_id) order straight from their primary key
+    auto stmt = db_.prepare("SELECT g.id, g.primary_file_id, m.file_id FROM duplicate_groups g "
+                            "LEFT JOIN duplicate_members m ON m.group_id = g.id ORDER BY g.id, m.file_id;");
+    if (!stmt) return groups;
+
     while (sqlite3_step(stmt) == SQLITE_ROW) {
-        DuplicateGroupDB g;
-        g.id = sqlite3_column_int64(stmt, 0);
-        g.primary_file_id = sqlite3_column_int64(stmt, 1);
-        groups.push_back(g);
-    }
-    sqlite3_finalize(stmt);
-
-    // Get members for each group
-    for (auto& g : groups) {
-        std::string msql = "SELECT file_id FROM duplicate_members WHERE group_id = ?;";
-        sqlite3_stmt* mstmt;
-        if (sqlite3_prepare_v2(db_.get_db(), msql.c_str(), -1, &mstmt, nullptr) == SQLITE_OK) {
-            sqlite3_bind_int64(mstmt, 1, g.id);
-            while (sqlite3_step(mstmt) == SQLITE_ROW) {
-                g.member_ids.push_back(sqlite3_column_int64(mstmt, 0));
-            }
-            sqlite3_finalize(mstmt);
+        const int64_t gid = sqlite3_column_int64(stmt, 0);
+        if (groups.empty() || groups.back().id != gid) {
+            DuplicateGroupDB g;
+            g.id = gid;
+            g.primary_file_id = sqlite3_column_int64(stmt, 1);
+            groups.push_back(std::move(g));
+        }
+        if (sqlite3_column_type(stmt, 2) != SQLITE_NULL) {
+            groups.back().member_ids.push_back(sqlite3_column_int64(stmt, 2));
         }
     }
     return groups;
 }
 
+std::size_t DuplicateRepository::for_each_group(const DuplicateGroupSink& sink) {
+    // Walks the members' primary key, which is already in output order: no
+    // sort, and each group and file row is a rowid lookup
+    auto stmt = db_.prepare("SELECT m.group_id, g.primary_file_id, "
+                            "f.id, f.path, f.size, COALESCE(f.mtime_ns, f.mtime * 1000000000), f.is_dir, f.dev, f.ino, f.nlink "
+                            "FROM duplicate_members m "
+                            "JOIN duplicate_groups g ON g.id = m.group_id "
+                            "JOIN files f ON f.id = m.file_id "
+                            "ORDER BY m.group_id, m.file_id;");
+    if (!stmt) {
+        throw std::runtime_error("Prepare failed: " + std::string(sqlite3_errmsg(db_.get_db())));
+    }
+
+    std::size_t visited = 0;
+    DuplicateGroupFiles group;
+    auto emit = [&] {
+        // Primary first, the others in id order
+        auto primary = std::find_if(group.files.begin(), group.files.end(),
+                                    [&](const FileInfo& f) { return f.id == group.primary_file_id; });
+        if (primary != group.files.end()) std::rotate(group.files.begin(), primary, primary + 1);
+        ++visited;
+        return sink(group);
+    };
+
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        const int64_t gid = sqlite3_column_int64(stmt, 0);
+        if (!group.files.empty() && gid != group.id) {
+            if (!emit()) return visited;
+            group.files.clear();
+        }
+        if (group.files.empty()) {
+            group.id = gid;
+            group.primary_file_id = sqlite3_column_int64(stmt, 1);
+        }
+        read_file(stmt, 2, group.files.emplace_back());
+    }
+    if (rc != SQLITE_DONE) {
+        throw std::runtime_error("Failed to read duplicate groups: " + std::string(sqlite3_errmsg(db_.get_db())));
+    }
+    if (!group.files.empty()) emit();
+    return visited;
+}
+
 } // namespace fo::core
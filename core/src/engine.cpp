@@ -1,49 +1,384 @@
 #include "fo/core/engine.hpp"
-#include "fo/core/ads_cache.hpp"
+#include "fo/core/file_identity.hpp"
+#include "fo/core/path_index.hpp"
+#include "extension_filter.hpp"
 #include <unordered_map>
+#include <unordered_set>
+#include <mutex>
 #include <algorithm>
+#include <functional>
+#include <iterator>
 #include <iostream>
+#include <optional>
 
 namespace fo::core {
 
+namespace {
+
+// Directory paths as the scanners report them, minus any trailing separator,
+// so a root given as "/photos/" matches the parent_path() of its files.
+std::string dir_key(const std::filesystem::path& p) {
+    std::string s = p.string();
+    while (s.size() > 1 && (s.back() == '/' || s.back() == static_cast<char>(std::filesystem::path::preferred_separator))) {
+        s.pop_back();
+    }
+    return s;
+}
+
+int64_t to_ns(std::chrono::file_clock::time_point tp) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(tp.time_since_epoch()).count();
+}
+
+// Everything besides the directory contents that decides which of its files
+// a scan reports. A directory read under different options is read again.
+std::string filter_signature(const std::vector<std::string>& norm_exts, bool follow_symlinks,
+                             const std::vector<IgnoreRule>& ignores) {
+    std::string sig = "exts=";
+    for (auto& e : norm_exts) sig += e + ",";
+    sig += follow_symlinks ? ";follow=1" : ";follow=0";
+    std::string patterns;
+    for (auto& r : ignores) patterns += r.pattern + '\n';
+    sig += ";ignore=" + std::to_string(std::hash<std::string>{}(patterns));
+    return sig;
+}
+
+// Subdirectories a scanner would descend into, found without reading file metadata
+void list_subdirs(const std::filesystem::path& dir, bool follow_symlinks, std::vector<std::filesystem::path>& out) {
+    std::error_code ec;
+    auto opts = std::filesystem::directory_options::skip_permission_denied;
+    for (std::filesystem::directory_iterator it(dir, opts, ec), end; !ec && it != end; it.increment(ec)) {
+        std::error_code sec;
+        if (!it->is_directory(sec)) continue;
+        if (!follow_symlinks && it->is_symlink(sec)) continue;
+        out.push_back(it->path());
+    }
+}
+
+// Prunes ignored subtrees, records every other directory the scanner walks
+// and, when reuse is enabled, tells it to skip reading directories whose
+// mtime matches the stored state. Only touches its own memory, so it is safe
+// to call from scanner worker threads (the scanners serialise calls); the
+// database work happens on the scan thread.
+class DirectoryTracker : public IScanDirectoryFilter {
+public:
+    struct Visit {
+        std::string path;
+        int64_t mtime_ns = 0;        // 0 if too recent to trust
+        int64_t seen_mtime_ns = 0;   // as read, for resuming
+        std::size_t entries = 0;
+        std::size_t files = 0;       // emitted by the scanner
+        int64_t reused_id = 0;   // stored directory whose files are carried forward
+        bool done = false;
+    };
+
+    DirectoryTracker(const std::vector<DirectoryRecord>& known, const IgnoreMatcher& ignore,
+                     std::string signature, bool reuse, std::chrono::file_clock::time_point scan_start,
+                     const std::vector<std::pair<std::filesystem::path, int64_t>>& resumed, bool follow_symlinks)
+        : ignore_(ignore), signature_(std::move(signature)), reuse_(reuse), follow_symlinks_(follow_symlinks)
+        // Coarse timestamps (down to 2 s on FAT) cannot tell a change made
+        // right after the scan read a directory; don't trust recent mtimes.
+        , racy_after_(scan_start - std::chrono::seconds(2)) {
+        for (const auto& r : known) {
+            std::string key = dir_key(r.path);
+            children_[dir_key(r.path.parent_path())].push_back(r.path);
+            known_.emplace(std::move(key), r);
+        }
+        for (const auto& [path, mtime_ns] : resumed) resumed_.emplace(dir_key(path), mtime_ns);
+    }
+
+    Action enter_directory(const std::filesystem::path& dir,
+                           std::chrono::file_clock::time_point mtime,
+                           std::vector<std::filesystem::path>& subdirs) override {
+        Visit v;
+        v.path = dir_key(dir);
+        if (ignore_.prunes_directory(v.path)) return Action::Skip;
+
+        v.seen_mtime_ns = to_ns(mtime);
+        v.mtime_ns = mtime >= racy_after_ ? 0 : v.seen_mtime_ns;
+
+        Action action = Action::Descend;
+        auto it = known_.find(v.path);
+        auto r = resumed_.find(v.path);
+        if (r != resumed_.end() && it != known_.end() && r->second == v.seen_mtime_ns) {
+            // Fully catalogued before the interruption; only its subdirectories
+            // are left, and those may not have been reached yet
+            v.reused_id = it->second.id;
+            list_subdirs(dir, follow_symlinks_, subdirs);
+            action = Action::Reuse;
+        } else if (reuse_ && it != known_.end() && v.mtime_ns != 0 &&
+            it->second.mtime_ns == v.mtime_ns && it->second.filter == signature_) {
+            v.reused_id = it->second.id;
+            auto c = children_.find(v.path);
+            if (c != children_.end()) subdirs = c->second;
+            action = Action::Reuse;
+        }
+        std::lock_guard lk(mtx_);
+        index_.emplace(v.path, visits_.size());
+        visits_.push_back(std::move(v));
+        return action;
+    }
+
+    void directory_done(const std::filesystem::path& dir,
+                        std::chrono::file_clock::time_point /*mtime*/,
+                        std::size_t entry_count,
+                        std::size_t file_count) override {
+        std::lock_guard lk(mtx_);
+        auto it = index_.find(dir_key(dir));
+        if (it == index_.end()) return;
+        visits_[it->second].entries = entry_count;
+        visits_[it->second].files = file_count;
+        visits_[it->second].done = true;
+        completed_.push_back(it->second);
+    }
+
+    // Directories read since the last call. Safe while the scanner runs.
+    void take_completed(std::vector<Visit>& out) {
+        std::lock_guard lk(mtx_);
+        for (; taken_ < completed_.size(); ++taken_) out.push_back(visits_[completed_[taken_]]);
+    }
+
+    // Only read once the scanner has returned
+    const std::vector<Visit>& visits() const { return visits_; }
+
+    std::optional<int64_t> known_id(const std::string& key) const {
+        auto it = known_.find(key);
+        if (it == known_.end()) return std::nullopt;
+        return it->second.id;
+    }
+
+private:
+    const IgnoreMatcher& ignore_;
+    std::string signature_;
+    bool reuse_;
+    bool follow_symlinks_;
+    std::chrono::file_clock::time_point racy_after_;
+    std::unordered_map<std::string, DirectoryRecord> known_;
+    std::unordered_map<std::string, std::vector<std::filesystem::path>> children_;
+    std::unordered_map<std::string, int64_t> resumed_;   // completed by the interrupted session
+    // Scanner threads append while the scan thread checkpoints
+    std::mutex mtx_;
+    std::unordered_map<std::string, std::size_t> index_;
+    std::vector<Visit> visits_;
+    std::vector<std::size_t> completed_;
+    std::size_t taken_ = 0;
+};
+
+} // namespace
+
 std::vector<FileInfo> Engine::scan(const std::vector<std::filesystem::path>& roots,
                                    const std::vector<std::string>& include_exts,
                                    bool follow_symlinks,
                                    bool prune) {
-    if (!scanner_) throw std::runtime_error("scanner not found: " + cfg_.scanner);
-    
-    int64_t session_id = session_repo_.start_session();
     std::vector<FileInfo> files;
+    scan(roots, include_exts, follow_symlinks, prune, [&](std::vector<FileInfo>& batch) {
+        std::move(batch.begin(), batch.end(), std::back_inserter(files));
+    });
+    return files;
+}
+
+std::size_t Engine::scan(const std::vector<std::filesystem::path>& roots,
+                         const std::vector<std::string>& include_exts,
+                         bool follow_symlinks,
+                         bool prune,
+                         const ScanBatchSink& on_batch) {
+    if (!scanner_) throw std::runtime_error("scanner not found: " + cfg_.scanner);
+    auto write_lock = db_manager_.lock_writes();
+
+    // Compiled once; also handed to the scanner to prune ignored subtrees
+    const auto ignores = ignore_repo_.get_all();
+    const IgnoreMatcher ignore(ignores);
+    const bool check_ignores = !ignore.empty();
+    const ExtensionFilter ext_filter(include_exts);
+    const std::string signature = filter_signature(ext_filter.extensions(), follow_symlinks, ignores);
+
+    // A session can only be resumed by a scan over the same roots and options
+    std::string roots_key;
+    for (const auto& r : roots) roots_key += dir_key(r) + '\n';
+
+    int64_t session_id = 0;
+    bool detect_moves = false;
+    std::vector<std::pair<std::filesystem::path, int64_t>> progress;
+    std::optional<ScanSession> interrupted;
+    if (cfg_.resume_scans) interrupted = session_repo_.find_resumable(roots_key, signature);
+    if (interrupted) {
+        session_id = interrupted->id;
+        session_repo_.reopen_session(session_id);
+        progress = session_repo_.get_progress(session_id);
+        detect_moves = interrupted->detect_moves;
+    } else {
+        // Moves can only be matched against rows already catalogued under the
+        // roots. On a first scan there are none, so nothing is held back and
+        // every batch is written and reported as soon as it arrives.
+        detect_moves = file_repo_.has_files_under(roots);
+        session_id = session_repo_.start_session(roots_key, signature, detect_moves);
+    }
+    std::size_t total = 0;
     
-    try {
-        files = scanner_->scan(roots, include_exts, follow_symlinks);
-        
-        // Filter ignored files
-        auto ignore_rules = ignore_repo_.get_all();
-        if (!ignore_rules.empty()) {
-            std::erase_if(files, [&](const FileInfo& f) {
-                return ignore_repo_.is_ignored(f.path.string());
-            });
-        }
+    // Detach the directory filter however the scan ends
+    struct FilterGuard {
+        IFileScanner& scanner;
+        ~FilterGuard() { scanner.set_directory_filter(nullptr); }
+    } filter_guard{*scanner_};
 
+    try {
         db_manager_.execute("BEGIN TRANSACTION;");
 
-        // 1. Identify existing vs new files
-        std::vector<FileInfo*> new_files;
+        DirectoryTracker tracker(directory_repo_.get_under(roots), ignore, signature,
+                                 cfg_.incremental_dirs, std::chrono::file_clock::now(),
+                                 progress, follow_symlinks);
+        scanner_->set_directory_filter(&tracker);
+        progress.clear();
+
+        // Directory row of each file's parent; rows are created on first use
+        std::unordered_map<std::string, int64_t> dir_ids;
+        auto dir_id_for = [&](const std::filesystem::path& dir) {
+            std::string key = dir_key(dir);
+            auto it = dir_ids.find(key);
+            if (it != dir_ids.end()) return it->second;
+            int64_t id = tracker.known_id(key).value_or(0);
+            if (id == 0) id = directory_repo_.ensure(key);
+            dir_ids.emplace(std::move(key), id);
+            return id;
+        };
+
+        std::vector<FileInfo> new_files;
         std::vector<int64_t> present_ids;
-        present_ids.reserve(files.size());
-
-        for (auto& f : files) {
-            auto existing = file_repo_.get_by_path(f.path);
-            if (existing) {
-                f.id = existing->id;
-                present_ids.push_back(f.id);
-                // Update metadata if changed
-                file_repo_.upsert(f); 
+        std::vector<FileInfo> done;
+        // Rescans can recognise unchanged files in memory. First scans have
+        // nothing to compare against, so their batches go straight to the bulk write.
+        PathIndex snapshot;
+        if (cfg_.snapshot_index && detect_moves) snapshot = file_repo_.load_snapshot(roots);
+        std::vector<FileInfo> pending;
+        std::vector<int64_t> pending_dirs;
+        std::vector<std::size_t> pending_at;
+
+        // Content may differ: stored hashes and duplicate groups no longer hold
+        std::vector<int64_t> modified;
+        auto forget_modified = [&](const std::vector<FileInfo>& files, const std::vector<UpsertResult>& results) {
+            modified.clear();
+            for (std::size_t i = 0; i < results.size(); ++i) {
+                if (results[i].is_modified) modified.push_back(files[i].id);
+            }
+            if (modified.empty()) return;
+            for (auto id : modified) file_repo_.clear_hashes(id);
+            duplicate_repo_.remove_files(modified);
+        };
+
+        std::vector<int64_t> batch_dirs;
+        auto dirs_of = [&](const std::vector<FileInfo>& files) -> const std::vector<int64_t>& {
+            batch_dirs.clear();
+            batch_dirs.reserve(files.size());
+            for (const auto& f : files) batch_dirs.push_back(dir_id_for(f.path.parent_path()));
+            return batch_dirs;
+        };
+
+        // Checkpoints commit the open transaction and record which directories
+        // are complete. Scanners may still hold files of a directory they
+        // finished reading, so a directory only counts once all of its files
+        // have arrived here (and none are held back for move detection).
+        const std::size_t checkpoint_every = cfg_.checkpoint_files;
+        std::size_t since_checkpoint = 0;
+        std::unordered_map<std::string, std::size_t> delivered;
+        std::unordered_set<std::string> held_dirs;
+        std::vector<DirectoryTracker::Visit> awaiting;
+        auto checkpoint = [&]() {
+            tracker.take_completed(awaiting);
+            std::erase_if(awaiting, [&](const DirectoryTracker::Visit& v) {
+                auto d = delivered.find(v.path);
+                const std::size_t got = d == delivered.end() ? 0 : d->second;
+                if (got < v.files || held_dirs.count(v.path)) return false;
+                int64_t id = dir_id_for(v.path);
+                directory_repo_.update_state(id, v.mtime_ns, static_cast<int64_t>(v.entries), signature);
+                session_repo_.add_progress(session_id, id, v.seen_mtime_ns);
+                if (d != delivered.end()) delivered.erase(d);
+                return true;
+            });
+            db_manager_.execute("COMMIT;");
+            db_manager_.execute("BEGIN TRANSACTION;");
+            since_checkpoint = 0;
+        };
+
+        scanner_->scan_batches(roots, include_exts, follow_symlinks, [&](std::vector<FileInfo>& batch) {
+            const std::size_t received = batch.size();
+            if (checkpoint_every) {
+                for (const auto& f : batch) ++delivered[dir_key(f.path.parent_path())];
+            }
+
+            // Filter ignored files
+            if (check_ignores) {
+                std::erase_if(batch, [&](const FileInfo& f) {
+                    return ignore.matches(f.path.string());
+                });
+            }
+
+            // 1. Write the batch in bulk. New files are held back (id 0) while
+            // they may turn out to be moves of catalogued ones.
+            const auto& dirs = dirs_of(batch);
+            if (!snapshot.empty()) {
+                // Only files the snapshot cannot vouch for reach the database
+                pending.clear();
+                pending_dirs.clear();
+                pending_at.clear();
+                for (std::size_t i = 0; i < batch.size(); ++i) {
+                    auto m = snapshot.find(batch[i], dirs[i]);
+                    if (m.state == PathIndex::State::Unchanged) {
+                        batch[i].id = m.id;
+                    } else if (m.state == PathIndex::State::Absent) {
+                        batch[i].id = 0;
+                    } else {
+                        pending_at.push_back(i);
+                        pending.push_back(std::move(batch[i]));
+                        pending_dirs.push_back(dirs[i]);
+                    }
+                }
+                forget_modified(pending, file_repo_.upsert_batch(pending, pending_dirs, !detect_moves));
+                for (std::size_t i = 0; i < pending.size(); ++i) batch[pending_at[i]] = std::move(pending[i]);
             } else {
-                new_files.push_back(&f);
+                forget_modified(batch, file_repo_.upsert_batch(batch, dirs, !detect_moves));
+            }
+            done.clear();
+            done.reserve(batch.size());
+            for (auto& f : batch) {
+                if (f.id == 0) {
+                    if (checkpoint_every) held_dirs.insert(dir_key(f.path.parent_path()));
+                    new_files.push_back(std::move(f));
+                } else {
+                    present_ids.push_back(f.id);
+                    done.push_back(std::move(f));
+                }
             }
+            if (!done.empty()) {
+                total += done.size();
+                on_batch(done);
+            }
+
+            since_checkpoint += received;
+            if (checkpoint_every && since_checkpoint >= checkpoint_every) checkpoint();
+        });
+
+        // Record what was read and carry forward the files of skipped directories
+        std::vector<int64_t> present_dirs;
+        for (const auto& v : tracker.visits()) {
+            if (v.reused_id != 0) {
+                present_dirs.push_back(v.reused_id);
+                auto carried = directory_repo_.get_files(v.reused_id);
+                std::erase_if(carried, [&](const FileInfo& f) {
+                    if (!ext_filter.accepts(f.path)) return true;
+                    return check_ignores && ignore.matches(f.path.string());
+                });
+                if (carried.empty()) continue;
+                for (const auto& f : carried) present_ids.push_back(f.id);
+                total += carried.size();
+                on_batch(carried);
+                continue;
+            }
+            int64_t id = dir_id_for(v.path);
+            present_dirs.push_back(id);
+            // A directory that could not be read has no trustworthy state
+            if (v.done) directory_repo_.update_state(id, v.mtime_ns, static_cast<int64_t>(v.entries), signature);
+            else directory_repo_.update_state(id, 0, 0, "");
         }
+        directory_repo_.prune_missing(present_dirs, roots);
 
         // 2. Detect moves (if we have new files)
         if (!new_files.empty()) {
@@ -55,39 +390,34 @@ std::vector<FileInfo> Engine::scan(const std::vector<std::filesystem::path>& roo
                 missing_by_size[m.size].push_back(m);
             }
 
-            for (auto* new_f : new_files) {
-                auto it = missing_by_size.find(new_f->size);
-                bool found_move = false;
+            for (auto& new_f : new_files) {
+                auto it = missing_by_size.find(new_f.size);
                 
                 if (it != missing_by_size.end()) {
                     auto& candidates = it->second;
                     // Find match by mtime
                     auto match_it = std::find_if(candidates.begin(), candidates.end(), [&](const FileInfo& c) {
-                        return c.mtime == new_f->mtime;
+                        return c.mtime == new_f.mtime;
                     });
 
                     if (match_it != candidates.end()) {
-                        // Found a move!
-                        file_repo_.update_path(match_it->id, new_f->path);
-                        new_f->id = match_it->id;
-                        present_ids.push_back(new_f->id);
-                        
-                        // Update metadata just in case
-                        file_repo_.upsert(*new_f);
+                        // Found a move! The row keeps its id and hashes; the
+                        // bulk write below updates its metadata.
+                        file_repo_.update_path(match_it->id, new_f.path);
 
                         // Remove from candidates
                         candidates.erase(match_it);
                         if (candidates.empty()) missing_by_size.erase(it);
-                        found_move = true;
                     }
                 }
-                
-                if (!found_move) {
-                    // Truly new
-                    file_repo_.upsert(*new_f);
-                    present_ids.push_back(new_f->id);
-                }
             }
+
+            // Moved files now match their row by path; the rest are truly new
+            forget_modified(new_files, file_repo_.upsert_batch(new_files, dirs_of(new_files)));
+            for (const auto& f : new_files) present_ids.push_back(f.id);
+
+            total += new_files.size();
+            on_batch(new_files);
         }
 
         // 3. Prune if requested
@@ -95,42 +425,158 @@ std::vector<FileInfo> Engine::scan(const std::vector<std::filesystem::path>& roo
             file_repo_.prune_missing(present_ids, roots);
         }
 
+        session_repo_.clear_progress(roots_key, signature);
         db_manager_.execute("COMMIT;");
         
-        session_repo_.end_session(session_id, "completed", static_cast<int>(files.size()));
+        session_repo_.end_session(session_id, "completed", static_cast<int>(total));
     } catch (...) {
         try { db_manager_.execute("ROLLBACK;"); } catch(...) {}
         session_repo_.end_session(session_id, "failed", 0);
         throw;
     }
     
-    return files;
+    return total;
+}
+
+ChangeStats Engine::apply_changes(const std::vector<FileChange>& changes,
+                                  const std::vector<std::string>& include_exts) {
+    auto write_lock = db_manager_.lock_writes();
+    ChangeStats stats;
+    const ExtensionFilter ext_filter(include_exts);
+    const IgnoreMatcher ignore(ignore_repo_.get_all());
+    auto accepted = [&](const std::filesystem::path& p) {
+        return ext_filter.accepts(p) && !ignore.matches(p.string());
+    };
+
+    auto forget = [&](const std::vector<int64_t>& ids) {
+        if (ids.empty()) return;
+        duplicate_repo_.remove_files(ids);
+        file_repo_.delete_files(ids);
+        stats.removed += ids.size();
+    };
+
+    // Bring the catalog entry of one path in line with the disk
+    auto sync_file = [&](const std::filesystem::path& p) {
+        std::error_code ec;
+        auto existing = file_repo_.get_by_path(p);
+        if (!std::filesystem::is_regular_file(p, ec) || !accepted(p)) {
+            if (existing) forget({existing->id});
+            return;
+        }
+        FileInfo fi;
+        fi.path = p;
+        fi.size = std::filesystem::file_size(p, ec);
+        if (ec) return;
+        auto ft = std::filesystem::last_write_time(p, ec);
+        if (!ec) fi.mtime = ft;
+        auto res = file_repo_.upsert(fi, directory_repo_.ensure(dir_key(p.parent_path())));
+        if (res.is_modified) {
+            // Content may differ: stored hashes and duplicate groups no longer hold
+            file_repo_.clear_hashes(fi.id);
+            duplicate_repo_.remove_files({fi.id});
+        }
+        if (res.is_new || res.is_modified) ++stats.updated;
+    };
+
+    // A path that may be a file, a directory (walked when it is new) or gone
+    auto sync_path = [&](const std::filesystem::path& p) {
+        std::error_code ec;
+        if (std::filesystem::is_directory(p, ec)) {
+            auto opts = std::filesystem::directory_options::skip_permission_denied;
+            for (std::filesystem::recursive_directory_iterator it(p, opts, ec), end; !ec && it != end; it.increment(ec)) {
+                std::error_code sec;
+                if (it->is_directory(sec)) {
+                    if (ignore.prunes_directory(it->path().string())) it.disable_recursion_pending();
+                    continue;
+                }
+                if (it->is_regular_file(sec)) sync_file(it->path());
+            }
+            return;
+        }
+        if (!std::filesystem::exists(p, ec)) {
+            // Whatever was there is gone, including any subtree
+            forget(file_repo_.get_ids_under(p));
+            directory_repo_.remove_tree(p);
+        }
+        sync_file(p);
+    };
+
+    db_manager_.execute("BEGIN TRANSACTION;");
+    try {
+        for (const auto& c : changes) {
+            switch (c.kind) {
+            case FileChange::Kind::Created:
+            case FileChange::Kind::Modified:
+            case FileChange::Kind::Removed:
+                sync_path(c.path);
+                break;
+            case FileChange::Kind::Renamed: {
+                directory_repo_.remove_tree(c.old_path);
+                if (auto moved = file_repo_.get_by_path(c.old_path)) {
+                    // Same content under a new name: keep id, hashes and groups
+                    if (auto clash = file_repo_.get_by_path(c.path)) forget({clash->id});
+                    file_repo_.update_path(moved->id, c.path);
+                    ++stats.renamed;
+                    sync_file(c.path);
+                } else if (!file_repo_.get_ids_under(c.old_path).empty()) {
+                    file_repo_.move_tree(c.old_path, c.path);
+                    ++stats.renamed;
+                } else {
+                    // Moved in from outside the catalog
+                    sync_path(c.path);
+                }
+                break;
+            }
+            case FileChange::Kind::Overflow:
+                break;
+            }
+        }
+        db_manager_.execute("COMMIT;");
+    } catch (...) {
+        try { db_manager_.execute("ROLLBACK;"); } catch (...) {}
+        throw;
+    }
+    return stats;
 }
 
 std::vector<DuplicateGroup> Engine::find_duplicates(const std::vector<FileInfo>& files) {
     if (!hasher_) throw std::runtime_error("hasher not found: " + cfg_.hasher);
-    // use size+fast64 strategy for now
-    SizeHashDuplicateFinder local(cfg_.use_ads_cache);
-    auto groups = local.group(files, *hasher_);
+    if (!cfg_.finder.empty() && !finder_) throw std::runtime_error("duplicate finder not found: " + cfg_.finder);
+    HashExecutor executor(cfg_.hash_jobs, cfg_.hash_io_jobs);
+    SizeHashDuplicateFinder local(sidecar_.get(), &executor);
+    const std::string algo = hasher_->name();
+    std::vector<DuplicateGroup> groups;
+    if (finder_) {
+        // Detach the executor however grouping ends
+        struct ExecutorGuard {
+            IDuplicateFinder& finder;
+            ~ExecutorGuard() { finder.set_executor(nullptr); }
+        } executor_guard{*finder_};
+        finder_->set_executor(&executor);
+        groups = finder_->group(files, *hasher_);
+    } else {
+        for (auto& h : file_repo_.get_hashes_by_algo(algo)) {
+            if (h.token) local.known.emplace(h.file_id, std::move(h));
+        }
+        groups = local.group(files, *hasher_);
+    }
 
-    // Persist duplicates
+    // Persist new hashes and the groups that changed
+    auto write_lock = db_manager_.lock_writes();
     db_manager_.execute("BEGIN TRANSACTION;");
     try {
-        duplicate_repo_.clear_all();
+        for (const auto& h : local.computed) file_repo_.add_hash(h.file_id, algo, h.value, h.token);
+        std::vector<std::vector<int64_t>> members;
+        members.reserve(groups.size());
         for (auto& g : groups) {
-            if (g.files.empty()) continue;
-            // Use first file as primary for now
-            int64_t primary_id = g.files[0].id;
-            // Ensure primary_id is valid (it should be if scan ran)
-            if (primary_id == 0) continue; 
-
-            int64_t gid = duplicate_repo_.create_group(primary_id);
+            // Use first file as primary for now; it has an id if scan ran
+            if (g.files.empty() || g.files[0].id == 0) continue;
+            auto& ids = members.emplace_back();
             for (auto& f : g.files) {
-                if (f.id != 0) {
-                    duplicate_repo_.add_member(gid, f.id);
-                }
+                if (f.id != 0) ids.push_back(f.id);
             }
         }
+        duplicate_repo_.sync_groups(members);
         db_manager_.execute("COMMIT;");
     } catch (...) {
         db_manager_.execute("ROLLBACK;");
@@ -150,35 +596,80 @@ std::vector<DuplicateGroup> Engine::SizeHashDuplicateFinder::group(const std::ve
         by_size[f.size].push_back(&f);
     }
 
-    std::vector<DuplicateGroup> groups;
+    // Sizes shared by several physical files. Catalogued hashes are taken
+    // while the file is unchanged; the other files go into the size's bucket.
+    struct SizeClass {
+        std::uintmax_t size;
+        std::vector<std::vector<const FileInfo*>> physical;
+        std::vector<std::string> hashes;     // per physical file
+        std::vector<std::size_t> pending;    // physical files in the bucket, in bucket order
+        std::vector<ChangeToken> tokens;     // per pending file
+    };
+    std::vector<SizeClass> classes;
+    std::vector<HashBucket> buckets;         // buckets[i] belongs to classes[i]
     for (auto& kv : by_size) {
         auto& vec = kv.second;
         if (vec.size() < 2) continue;
-        std::unordered_map<std::string, std::vector<const FileInfo*>> by_fast;
-        for (auto* fi : vec) {
-            std::string h;
-
-            // Try ADS cache first if enabled
-            if (use_ads_) {
-                auto cached = ADSCache::get_hash(fi->path, "fast64");
-                if (cached) {
-                    h = *cached;
-                } else {
-                    h = hasher.fast64(fi->path);
-                    ADSCache::set_hash(fi->path, "fast64", h);
-                }
+        // Hardlinks share their data: hash each physical file once
+        std::vector<FileIdentity> identities;
+        auto physical = group_by_inode(vec, &identities);
+        if (physical.size() < 2) continue;
+        auto& c = classes.emplace_back();
+        auto& bucket = buckets.emplace_back();
+        c.size = kv.first;
+        c.hashes.resize(physical.size());
+        for (size_t i = 0; i < physical.size(); ++i) {
+            const FileInfo* fi = physical[i].front();
+            const auto token = ChangeToken::of(*fi, identities[i]);
+            auto k = fi->id != 0 && token.identified() ? known.find(fi->id) : known.end();
+            if (k != known.end() && k->second.token == token) {
+                c.hashes[i] = k->second.value;
             } else {
-                h = hasher.fast64(fi->path);
+                c.pending.push_back(i);
+                c.tokens.push_back(token);
+                bucket.files.push_back(fi);
             }
+        }
+        c.physical = std::move(physical);
+    }
+
+    // The sidecar cache if enabled, then the file itself
+    const std::string algo = hasher.name();
+    HashExecutor sequential(1);
+    HashExecutor& executor = executor_ ? *executor_ : sequential;
+    executor.run(buckets, hasher, [&](IHasher& h, const FileInfo& fi) {
+        if (sidecar_) {
+            if (auto cached = sidecar_->get_hash(fi.path, algo)) return *cached;
+        }
+        std::string value = executor.read([&] { return h.fast64(fi.path); });
+        if (sidecar_) sidecar_->set_hash(fi.path, algo, value);
+        return value;
+    });
 
-            by_fast[h].push_back(fi);
+    std::vector<DuplicateGroup> groups;
+    for (size_t ci = 0; ci < classes.size(); ++ci) {
+        auto& c = classes[ci];
+        const auto& computed_hashes = buckets[ci].hashes;
+        for (size_t j = 0; j < c.pending.size(); ++j) {
+            const FileInfo* fi = buckets[ci].files[j];
+            c.hashes[c.pending[j]] = computed_hashes[j];
+            if (fi->id == 0 || computed_hashes[j].empty()) continue;
+            std::optional<ChangeToken> token;
+            if (c.tokens[j].identified()) token = c.tokens[j];
+            computed.push_back({fi->id, computed_hashes[j], token});
         }
+
+        std::unordered_map<std::string, std::vector<const std::vector<const FileInfo*>*>> by_fast;
+        for (size_t i = 0; i < c.physical.size(); ++i) by_fast[c.hashes[i]].push_back(&c.physical[i]);
         for (auto& hv : by_fast) {
             if (hv.second.size() < 2) continue;
             DuplicateGroup g;
-            g.size = kv.first;
+            g.size = c.size;
             g.fast64 = hv.first;
-            for (auto* fi : hv.second) g.files.push_back(*fi);
+            for (auto* paths : hv.second) {
+                g.files.push_back(*paths->front());
+                for (size_t i = 1; i < paths->size(); ++i) g.links.push_back(*(*paths)[i]);
+            }
             groups.push_back(std::move(g));
         }
     }
@@ -1,5 +1,6 @@
 #include "fo/core/export.hpp"
 #include "fo/core/thumbnail.hpp"
+#include "fo/core/file_catalog.hpp"
 #include <fstream>
 #include <iomanip>
 #include <sstream>
@@ -54,6 +55,19 @@ ScanStats Exporter::compute_stats(const std::vector<FileInfo>& files,
     return stats;
 }
 
+ScanStats Exporter::compute_stats(const FileCatalog& catalog,
+                                  const std::vector<CatalogGroup>& duplicates) {
+    ScanStats stats;
+    stats.total_files = catalog.size();
+    for (auto size : catalog.sizes()) stats.total_size += size;
+    for (const auto& g : duplicates) {
+        stats.duplicate_groups++;
+        stats.duplicate_files += g.files.size();
+        stats.duplicate_size += g.size * (g.files.size() - 1); // Wasted space
+    }
+    return stats;
+}
+
 std::string Exporter::json_escape(const std::string& s) {
     std::ostringstream oss;
     for (char c : s) {
@@ -176,6 +190,36 @@ void Exporter::duplicates_to_csv(std::ostream& out, const std::vector<DuplicateG
     }
 }
 
+void Exporter::to_csv(std::ostream& out, const FileCatalog& catalog) {
+    // CSV Header
+    out << "id,path,size,size_human,mtime,is_dir\n";
+    for (FileCatalog::Handle h = 0; h < catalog.size(); ++h) {
+        out << catalog.id(h) << ","
+            << csv_escape(catalog.path_string(h)) << ","
+            << catalog.file_size(h) << ","
+            << csv_escape(format_size(catalog.file_size(h))) << ","
+            << csv_escape(format_time(catalog.mtime(h))) << ","
+            << "false\n";
+    }
+}
+
+void Exporter::duplicates_to_csv(std::ostream& out, const FileCatalog& catalog,
+                                 const std::vector<CatalogGroup>& duplicates) {
+    // CSV Header
+    out << "group_id,size,size_human,fast64,file_path\n";
+    int group_id = 1;
+    for (const auto& g : duplicates) {
+        for (auto h : g.files) {
+            out << group_id << ","
+                << g.size << ","
+                << csv_escape(format_size(g.size)) << ","
+                << csv_escape(g.fast64) << ","
+                << csv_escape(catalog.path_string(h)) << "\n";
+        }
+        ++group_id;
+    }
+}
+
 void Exporter::to_html(std::ostream& out,
                        const std::vector<FileInfo>& files,
                        const std::vector<DuplicateGroup>& duplicates,
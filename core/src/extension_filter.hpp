@@ -0,0 +1,49 @@
+#pragma once
+
+// The --ext filter shared by the scanners and the engine, so they all agree
+// on which files a list of extensions selects.
+
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace fo::core {
+
+// Lower case, with the leading dot, sorted and without repeats
+inline std::vector<std::string> normalize_exts(const std::vector<std::string>& include_exts) {
+    std::vector<std::string> out;
+    out.reserve(include_exts.size());
+    for (auto e : include_exts) {
+        if (!e.empty() && e[0] != '.') e = "." + e;
+        std::transform(e.begin(), e.end(), e.begin(), [](unsigned char c){ return static_cast<char>(std::tolower(c)); });
+        out.push_back(std::move(e));
+    }
+    std::sort(out.begin(), out.end());
+    out.erase(std::unique(out.begin(), out.end()), out.end());
+    return out;
+}
+
+// Accepts every path if no extensions were given. Otherwise the path needs an
+// extension as path::extension() sees it, matched ignoring case.
+class ExtensionFilter {
+public:
+    explicit ExtensionFilter(const std::vector<std::string>& include_exts)
+        : exts_(normalize_exts(include_exts)) {}
+
+    bool accepts(const std::filesystem::path& p) const {
+        if (exts_.empty()) return true;
+        auto ext = p.extension().string();
+        if (ext.empty()) return false;
+        std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c){ return static_cast<char>(std::tolower(c)); });
+        return std::binary_search(exts_.begin(), exts_.end(), ext);
+    }
+
+    const std::vector<std::string>& extensions() const { return exts_; }
+
+private:
+    std::vector<std::string> exts_;
+};
+
+} // namespace fo::core
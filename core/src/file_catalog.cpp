@@ -0,0 +1,233 @@
+#include "fo/core/file_catalog.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <utility>
+
+namespace fo::core {
+
+namespace {
+
+constexpr FileCatalog::NameId kEmptySlot = UINT32_MAX;
+
+bool is_separator(char c) {
+#ifdef _WIN32
+    return c == '/' || c == '\\';
+#else
+    return c == '/';
+#endif
+}
+
+// Joins like path::operator/ for the components the catalog stores: no
+// separator after an empty or separator-terminated parent ("/", "C:\"), and
+// none before a bare root directory component.
+void append_component(std::string& out, std::string_view comp) {
+    if (!out.empty() && !is_separator(out.back()) && !(comp.size() == 1 && is_separator(comp[0]))) {
+        out.push_back(static_cast<char>(std::filesystem::path::preferred_separator));
+    }
+    out.append(comp);
+}
+
+} // namespace
+
+std::string_view StringArena::store(std::string_view s) {
+    if (s.size() > left_) {
+        std::size_t n = std::max(chunk_size_, s.size());
+        chunks_.push_back(std::make_unique<char[]>(n));
+        cur_ = chunks_.back().get();
+        left_ = n;
+        reserved_ += n;
+    }
+    if (!s.empty()) std::memcpy(cur_, s.data(), s.size());
+    std::string_view stored(cur_, s.size());
+    cur_ += s.size();
+    left_ -= s.size();
+    return stored;
+}
+
+FileCatalog::NameId FileCatalog::intern(std::string_view s) {
+    if ((names_.size() + 1) * 10 > name_slots_.size() * 7) grow_name_table();
+
+    const std::size_t mask = name_slots_.size() - 1;
+    std::size_t i = std::hash<std::string_view>{}(s) & mask;
+    while (name_slots_[i] != kEmptySlot) {
+        if (names_[name_slots_[i]] == s) return name_slots_[i];
+        i = (i + 1) & mask;
+    }
+    NameId id = static_cast<NameId>(names_.size());
+    names_.push_back(arena_.store(s));
+    name_slots_[i] = id;
+    return id;
+}
+
+void FileCatalog::grow_name_table() {
+    std::size_t cap = name_slots_.empty() ? 1024 : name_slots_.size() * 2;
+    name_slots_.assign(cap, kEmptySlot);
+    const std::size_t mask = cap - 1;
+    for (NameId id = 0; id < names_.size(); ++id) {
+        std::size_t i = std::hash<std::string_view>{}(names_[id]) & mask;
+        while (name_slots_[i] != kEmptySlot) i = (i + 1) & mask;
+        name_slots_[i] = id;
+    }
+}
+
+FileCatalog::DirId FileCatalog::add_dir(DirId parent, std::string_view name) {
+    NameId n = intern(name);
+    std::uint64_t key = (static_cast<std::uint64_t>(parent) << 32) | n;
+    auto [it, inserted] = dir_index_.try_emplace(key, static_cast<DirId>(dir_parent_.size()));
+    if (inserted) {
+        dir_parent_.push_back(parent);
+        dir_name_.push_back(n);
+    }
+    return it->second;
+}
+
+FileCatalog::DirId FileCatalog::dir_for(const std::filesystem::path& dir) {
+    const auto& native = dir.native();
+    if (last_dir_id_ != kNoDir && native == last_dir_) return last_dir_id_;
+
+    DirId cur = kNoDir;
+    for (const auto& comp : dir) {
+        std::string s = comp.string();
+        if (s.empty()) continue; // trailing separator
+        cur = add_dir(cur, s);
+    }
+    if (cur == kNoDir) cur = add_dir(kNoDir, ""); // bare file name, relative to cwd
+
+    last_dir_ = native;
+    last_dir_id_ = cur;
+    return cur;
+}
+
+FileCatalog::Handle FileCatalog::add(DirId dir, std::string_view name, std::uintmax_t size,
+                                     std::chrono::file_clock::time_point mtime, int64_t id) {
+    Handle h = static_cast<Handle>(size_.size());
+    dir_.push_back(dir);
+    name_.push_back(intern(name));
+    size_.push_back(size);
+    mtime_.push_back(mtime.time_since_epoch().count());
+    id_.push_back(id);
+    return h;
+}
+
+FileCatalog::Handle FileCatalog::add(const FileInfo& file) {
+    DirId d = dir_for(file.path.parent_path());
+    return add(d, file.path.filename().string(), file.size, file.mtime, file.id);
+}
+
+void FileCatalog::append(const std::vector<FileInfo>& batch) {
+    for (const auto& f : batch) add(f);
+}
+
+ScanBatchSink FileCatalog::sink() {
+    return [this](std::vector<FileInfo>& batch) { append(batch); };
+}
+
+std::string FileCatalog::dir_path_string(DirId d) const {
+    // Collect the chain leaf-first, then join root-first
+    std::vector<DirId> chain;
+    chain.reserve(32);
+    for (DirId cur = d; cur != kNoDir; cur = dir_parent_[cur]) chain.push_back(cur);
+    std::string out;
+    for (auto it = chain.rbegin(); it != chain.rend(); ++it) append_component(out, names_[dir_name_[*it]]);
+    return out;
+}
+
+std::string FileCatalog::path_string(Handle h) const {
+    std::string out = dir_path_string(dir_[h]);
+    append_component(out, names_[name_[h]]);
+    return out;
+}
+
+std::filesystem::path FileCatalog::path(Handle h) const {
+    return std::filesystem::path(path_string(h));
+}
+
+FileInfo FileCatalog::to_file_info(Handle h) const {
+    FileInfo fi;
+    fi.id = id_[h];
+    fi.path = path(h);
+    fi.size = size_[h];
+    fi.mtime = mtime(h);
+    return fi;
+}
+
+std::vector<FileCatalog::Handle> FileCatalog::handles_by_size() const {
+    // Sort (size, handle) pairs so comparisons never chase the column
+    std::vector<std::pair<std::uintmax_t, Handle>> keyed(size_.size());
+    for (Handle h = 0; h < keyed.size(); ++h) keyed[h] = {size_[h], h};
+    std::sort(keyed.begin(), keyed.end());
+
+    std::vector<Handle> out(keyed.size());
+    for (std::size_t i = 0; i < keyed.size(); ++i) out[i] = keyed[i].second;
+    return out;
+}
+
+void FileCatalog::shrink_to_fit() {
+    names_.shrink_to_fit();
+    dir_parent_.shrink_to_fit();
+    dir_name_.shrink_to_fit();
+    dir_.shrink_to_fit();
+    name_.shrink_to_fit();
+    size_.shrink_to_fit();
+    mtime_.shrink_to_fit();
+    id_.shrink_to_fit();
+}
+
+std::size_t FileCatalog::memory_usage() const {
+    std::size_t bytes = arena_.bytes_reserved();
+    bytes += names_.capacity() * sizeof(std::string_view);
+    bytes += name_slots_.capacity() * sizeof(NameId);
+    bytes += dir_parent_.capacity() * sizeof(DirId) + dir_name_.capacity() * sizeof(NameId);
+    // Node-based map: key/value plus roughly two pointers and a bucket slot per entry
+    bytes += dir_index_.size() * (sizeof(std::uint64_t) + sizeof(DirId) + 3 * sizeof(void*));
+    bytes += dir_.capacity() * sizeof(DirId) + name_.capacity() * sizeof(NameId);
+    bytes += size_.capacity() * sizeof(std::uintmax_t);
+    bytes += mtime_.capacity() * sizeof(std::chrono::file_clock::rep);
+    bytes += id_.capacity() * sizeof(int64_t);
+    return bytes;
+}
+
+std::vector<CatalogGroup> IDuplicateFinder::group_catalog(const FileCatalog& catalog, IHasher& hasher) {
+    std::vector<CatalogGroup> out;
+    auto order = catalog.handles_by_size();
+
+    std::vector<FileInfo> run;
+    std::unordered_map<std::string, FileCatalog::Handle> by_path;
+    for (std::size_t i = 0; i < order.size();) {
+        const std::uintmax_t sz = catalog.file_size(order[i]);
+        std::size_t j = i + 1;
+        while (j < order.size() && catalog.file_size(order[j]) == sz) ++j;
+
+        // A unique size cannot have duplicates; skip without touching paths
+        if (j - i >= 2) {
+            run.clear();
+            by_path.clear();
+            for (std::size_t k = i; k < j; ++k) {
+                FileInfo fi = catalog.to_file_info(order[k]);
+                by_path.emplace(fi.path.string(), order[k]);
+                run.push_back(std::move(fi));
+            }
+            for (auto& g : group(run, hasher)) {
+                CatalogGroup cg;
+                cg.size = g.size;
+                cg.fast64 = std::move(g.fast64);
+                auto to_handles = [&](const std::vector<FileInfo>& in, std::vector<FileCatalog::Handle>& handles) {
+                    handles.reserve(in.size());
+                    for (const auto& f : in) {
+                        auto it = by_path.find(f.path.string());
+                        if (it != by_path.end()) handles.push_back(it->second);
+                    }
+                };
+                to_handles(g.files, cg.files);
+                to_handles(g.links, cg.links);
+                out.push_back(std::move(cg));
+            }
+        }
+        i = j;
+    }
+    return out;
+}
+
+} // namespace fo::core
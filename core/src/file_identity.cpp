@@ -0,0 +1,66 @@
+#include "fo/core/file_identity.hpp"
+
+#include <map>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/stat.h>
+#endif
+
+namespace fo::core {
+
+FileIdentity file_identity(const FileInfo& file) {
+    FileIdentity id;
+    if (file.ino != 0) {
+        id.dev = file.dev;
+        id.ino = file.ino;
+        id.nlink = file.nlink;
+        return id;
+    }
+#ifdef _WIN32
+    HANDLE h = CreateFileW(file.path.c_str(), FILE_READ_ATTRIBUTES,
+                           FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                           nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, nullptr);
+    if (h == INVALID_HANDLE_VALUE) return id;
+    BY_HANDLE_FILE_INFORMATION info;
+    if (GetFileInformationByHandle(h, &info)) {
+        id.dev = info.dwVolumeSerialNumber;
+        id.ino = (static_cast<std::uint64_t>(info.nFileIndexHigh) << 32) | info.nFileIndexLow;
+        id.nlink = info.nNumberOfLinks;
+    }
+    CloseHandle(h);
+#else
+    struct stat st{};
+    if (::stat(file.path.c_str(), &st) == 0) {
+        id.dev = static_cast<std::uint64_t>(st.st_dev);
+        id.ino = static_cast<std::uint64_t>(st.st_ino);
+        id.nlink = static_cast<std::uint64_t>(st.st_nlink);
+    }
+#endif
+    return id;
+}
+
+std::vector<std::vector<const FileInfo*>> group_by_inode(const std::vector<const FileInfo*>& files,
+                                                         std::vector<FileIdentity>* identities) {
+    std::vector<std::vector<const FileInfo*>> out;
+    out.reserve(files.size());
+    if (identities) identities->clear();
+    std::map<std::pair<std::uint64_t, std::uint64_t>, std::size_t> seen;
+    for (const auto* f : files) {
+        auto id = file_identity(*f);
+        // A single link cannot share its inode with another path
+        if (id.ino != 0 && id.nlink != 1) {
+            auto [it, inserted] = seen.emplace(std::make_pair(id.dev, id.ino), out.size());
+            if (!inserted) {
+                out[it->second].push_back(f);
+                continue;
+            }
+        }
+        out.push_back({f});
+        if (identities) identities->push_back(id);
+    }
+    return out;
+}
+
+} // namespace fo::core
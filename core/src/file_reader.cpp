@@ -0,0 +1,134 @@
+#include "fo/core/file_reader.hpp"
+
+#include <limits>
+#include <new>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace fo::core {
+
+static constexpr std::size_t kPageSize = 4096;
+
+FileReader::~FileReader() {
+    close();
+    if (buffer_) ::operator delete[](buffer_, std::align_val_t{kPageSize});
+}
+
+std::uint8_t* FileReader::reserve(std::size_t n) {
+    if (n <= capacity_) return buffer_;
+    if (buffer_) ::operator delete[](buffer_, std::align_val_t{kPageSize});
+    capacity_ = (n + kPageSize - 1) / kPageSize * kPageSize;
+    buffer_ = static_cast<std::uint8_t*>(::operator new[](capacity_, std::align_val_t{kPageSize}));
+    return buffer_;
+}
+
+#ifndef _WIN32
+
+bool FileReader::open(const std::filesystem::path& p, Access access) {
+    close();
+    fd_ = ::open(p.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd_ < 0) return false;
+    struct stat st;
+    if (::fstat(fd_, &st) != 0 || !S_ISREG(st.st_mode)) {
+        close();
+        return false;
+    }
+    size_ = static_cast<std::uint64_t>(st.st_size);
+
+    if (access == Access::Sequential && size_ > 0 && size_ >= map_threshold_ &&
+        size_ <= std::numeric_limits<std::size_t>::max()) {
+        void* m = ::mmap(nullptr, static_cast<std::size_t>(size_), PROT_READ, MAP_PRIVATE, fd_, 0);
+        if (m != MAP_FAILED) {
+            ::madvise(m, static_cast<std::size_t>(size_), MADV_SEQUENTIAL);
+            map_ = static_cast<const std::uint8_t*>(m);
+            return true;
+        }
+        // e.g. a filesystem without mmap support: read it instead
+    }
+#ifdef POSIX_FADV_SEQUENTIAL
+    if (access == Access::Sequential && size_ > kBlockSize) {
+        ::posix_fadvise(fd_, 0, 0, POSIX_FADV_SEQUENTIAL);
+    } else if (access == Access::Sampled && size_ >= kSampledReadAhead) {
+        // Only the sampled windows are wanted, not read-ahead around them
+        ::posix_fadvise(fd_, 0, 0, POSIX_FADV_RANDOM);
+    }
+#endif
+    return true;
+}
+
+void FileReader::close() {
+    if (map_) ::munmap(const_cast<std::uint8_t*>(map_), static_cast<std::size_t>(size_));
+    map_ = nullptr;
+    if (fd_ >= 0) ::close(fd_);
+    fd_ = -1;
+    size_ = 0;
+    failed_ = false;
+}
+
+std::span<const std::uint8_t> FileReader::read(std::uint64_t offset, std::size_t len) {
+    if (offset >= size_) return {};
+    if (len > size_ - offset) len = static_cast<std::size_t>(size_ - offset);
+    if (map_) return {map_ + offset, len};
+    if (fd_ < 0) return {};
+
+    std::uint8_t* buf = reserve(len);
+    std::size_t got = 0;
+    while (got < len) {
+        const ssize_t n = ::pread(fd_, buf + got, len - got, static_cast<off_t>(offset + got));
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            failed_ = true;
+            return {};
+        }
+        if (n == 0) break;   // the file shrank
+        got += static_cast<std::size_t>(n);
+    }
+    return {buf, got};
+}
+
+#else
+
+bool FileReader::open(const std::filesystem::path& p, Access /*access*/) {
+    close();
+    file_.open(p, std::ios::binary);
+    if (!file_) return false;
+    file_.seekg(0, std::ios::end);
+    const std::streamoff len = file_.tellg();
+    if (len < 0) {
+        close();
+        return false;
+    }
+    size_ = static_cast<std::uint64_t>(len);
+    return true;
+}
+
+void FileReader::close() {
+    if (file_.is_open()) file_.close();
+    file_.clear();
+    size_ = 0;
+    failed_ = false;
+}
+
+std::span<const std::uint8_t> FileReader::read(std::uint64_t offset, std::size_t len) {
+    if (offset >= size_ || !file_.is_open()) return {};
+    if (len > size_ - offset) len = static_cast<std::size_t>(size_ - offset);
+    std::uint8_t* buf = reserve(len);
+    file_.clear();
+    file_.seekg(static_cast<std::streamoff>(offset), std::ios::beg);
+    file_.read(reinterpret_cast<char*>(buf), static_cast<std::streamsize>(len));
+    if (file_.bad()) {
+        failed_ = true;
+        return {};
+    }
+    return {buf, static_cast<std::size_t>(file_.gcount())};
+}
+
+#endif
+
+} // namespace fo::core
@@ -2,8 +2,9 @@
 #include <sqlite3.h>
 #include <stdexcept>
 #include <iostream>
+#include <algorithm>
 #include <bit>
-#include <charconv>
+#include <type_traits>
 
 namespace fo::core {
 
@@ -20,25 +21,106 @@ static int64_t to_unix(std::chrono::file_clock::time_point tp) {
     }
 }
 
-// Helper to convert unix timestamp to file_time
-static std::chrono::file_clock::time_point from_unix(int64_t t) {
-    auto sys = std::chrono::system_clock::from_time_t(static_cast<std::time_t>(t));
+// files.mtime_ns and hash tokens: unix time in nanoseconds
+static int64_t to_unix_ns(std::chrono::file_clock::time_point tp) {
+    try {
+        auto sys = std::chrono::clock_cast<std::chrono::system_clock>(tp);
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(sys.time_since_epoch()).count();
+    } catch (...) {
+        return 0;
+    }
+}
+
+static std::chrono::file_clock::time_point from_unix_ns(int64_t ns) {
+    std::chrono::sys_time<std::chrono::nanoseconds> sys{std::chrono::nanoseconds(ns)};
     return std::chrono::clock_cast<std::chrono::file_clock>(sys);
 }
 
+// dev/ino/nlink are stored as NULL while unknown; sqlite integers are signed
+static void bind_identity(sqlite3_stmt* stmt, int first, const FileInfo& file) {
+    if (file.ino == 0) {
+        for (int i = 0; i < 3; ++i) sqlite3_bind_null(stmt, first + i);
+        return;
+    }
+    sqlite3_bind_int64(stmt, first, static_cast<sqlite3_int64>(file.dev));
+    sqlite3_bind_int64(stmt, first + 1, static_cast<sqlite3_int64>(file.ino));
+    sqlite3_bind_int64(stmt, first + 2, static_cast<sqlite3_int64>(file.nlink));
+}
+
+static void read_identity(sqlite3_stmt* stmt, int first, FileInfo& file) {
+    if (sqlite3_column_type(stmt, first + 1) == SQLITE_NULL) return;
+    file.dev = static_cast<std::uint64_t>(sqlite3_column_int64(stmt, first));
+    file.ino = static_cast<std::uint64_t>(sqlite3_column_int64(stmt, first + 1));
+    file.nlink = static_cast<std::uint64_t>(sqlite3_column_int64(stmt, first + 2));
+}
+
+// Bounds of the paths strictly below dir: [dir + sep, dir + (sep + 1)). An
+// exact range on the path index, unlike LIKE (case-insensitive, '_' and '%').
+static std::pair<std::string, std::string> subtree_range(const std::filesystem::path& dir) {
+    const char sep = static_cast<char>(std::filesystem::path::preferred_separator);
+    std::string base = dir.string();
+    while (base.size() > 1 && base.back() == sep) base.pop_back();
+    if (base.size() == 1 && base[0] == sep) base.clear();   // "/" itself
+    return {base + sep, base + static_cast<char>(sep + 1)};
+}
+
+// Subtree ranges of several roots, sorted, with roots that lie below another
+// root dropped so that every row is visited once.
+static std::vector<std::pair<std::string, std::string>> subtree_ranges(const std::vector<std::filesystem::path>& roots) {
+    std::vector<std::pair<std::string, std::string>> ranges;
+    for (const auto& root : roots) ranges.push_back(subtree_range(root));
+    std::sort(ranges.begin(), ranges.end());
+    std::vector<std::pair<std::string, std::string>> out;
+    for (auto& r : ranges) {
+        if (!out.empty() && r.first < out.back().second) continue;
+        out.push_back(std::move(r));
+    }
+    return out;
+}
+
+// Ids of the files below the roots that are not in present_ids. The range
+// scan only touches the path index (which carries the rowid), and the
+// difference is taken in memory instead of through a temp table.
+static std::vector<int64_t> missing_ids_under(DatabaseManager& db, const std::vector<std::filesystem::path>& roots,
+                                              const std::vector<int64_t>& present_ids) {
+    std::vector<int64_t> missing;
+    auto stmt = db.prepare("SELECT id FROM files WHERE path >= ? AND path < ?;");
+    if (!stmt) return missing;
+
+    std::vector<int64_t> present(present_ids);
+    std::sort(present.begin(), present.end());
+    for (const auto& [lo, hi] : subtree_ranges(roots)) {
+        sqlite3_bind_text(stmt, 1, lo.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 2, hi.c_str(), -1, SQLITE_STATIC);
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            int64_t id = sqlite3_column_int64(stmt, 0);
+            if (!std::binary_search(present.begin(), present.end(), id)) missing.push_back(id);
+        }
+        sqlite3_reset(stmt);
+    }
+    return missing;
+}
+
+ChangeToken ChangeToken::of(const FileInfo& file) {
+    return of(file, file_identity(file));
+}
+
+ChangeToken ChangeToken::of(const FileInfo& file, const FileIdentity& id) {
+    return {id.dev, id.ino, file.size, to_unix_ns(file.mtime)};
+}
+
 FileRepository::FileRepository(DatabaseManager& db) : db_(db) {}
 
-UpsertResult FileRepository::upsert(FileInfo& file) {
+UpsertResult FileRepository::upsert(FileInfo& file, int64_t dir_id) {
     UpsertResult result;
     auto existing = get_by_path(file.path);
     
     if (!existing) {
         result.is_new = true;
-        std::string sql = "INSERT INTO files (path, size, mtime, is_dir) VALUES (?, ?, ?, ?) RETURNING id;";
+        std::string sql = "INSERT INTO files (path, size, mtime, is_dir, dir_id, dev, ino, nlink, mtime_ns) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?) RETURNING id;";
         
-        sqlite3_stmt* stmt;
-        int rc = sqlite3_prepare_v2(db_.get_db(), sql.c_str(), -1, &stmt, nullptr);
-        if (rc != SQLITE_OK) {
+        auto stmt = db_.prepare(sql);
+        if (!stmt) {
             throw std::runtime_error("Failed to prepare insert: " + std::string(sqlite3_errmsg(db_.get_db())));
         }
 
@@ -47,14 +129,16 @@ UpsertResult FileRepository::upsert(FileInfo& file) {
         sqlite3_bind_int64(stmt, 2, static_cast<sqlite3_int64>(file.size));
         sqlite3_bind_int64(stmt, 3, static_cast<sqlite3_int64>(to_unix(file.mtime)));
         sqlite3_bind_int(stmt, 4, file.is_dir ? 1 : 0);
+        if (dir_id != 0) sqlite3_bind_int64(stmt, 5, dir_id);
+        else sqlite3_bind_null(stmt, 5);
+        bind_identity(stmt, 6, file);
+        sqlite3_bind_int64(stmt, 9, to_unix_ns(file.mtime));
 
         if (sqlite3_step(stmt) == SQLITE_ROW) {
             file.id = sqlite3_column_int64(stmt, 0);
         } else {
-            sqlite3_finalize(stmt);
             throw std::runtime_error("Failed to execute insert: " + std::string(sqlite3_errmsg(db_.get_db())));
         }
-        sqlite3_finalize(stmt);
     } else {
         file.id = existing->id;
         // Check if modified
@@ -63,171 +147,340 @@ UpsertResult FileRepository::upsert(FileInfo& file) {
         int64_t new_mtime = to_unix(file.mtime);
         int64_t old_mtime = to_unix(existing->mtime);
         
-        if (file.size != existing->size || new_mtime != old_mtime || file.is_dir != existing->is_dir) {
+        // A different inode under the same name is a replaced file, even if size and mtime match
+        const bool replaced = file.ino != 0 && existing->ino != 0 &&
+                              (file.ino != existing->ino || file.dev != existing->dev);
+        if (file.size != existing->size || new_mtime != old_mtime || file.is_dir != existing->is_dir || replaced) {
             result.is_modified = true;
-            std::string sql = "UPDATE files SET size=?, mtime=?, is_dir=? WHERE id=?;";
+        } else if (file.ino == 0) {
+            // Scanners that do not read identity keep the recorded one of an unchanged file
+            file.dev = existing->dev;
+            file.ino = existing->ino;
+            file.nlink = existing->nlink;
+        }
+        const bool identity_changed = file.ino != existing->ino || file.dev != existing->dev ||
+                                      file.nlink != existing->nlink;
+        // Sub-second mtime changes alone do not count as modified, but are recorded
+        const int64_t new_mtime_ns = to_unix_ns(file.mtime);
+        const bool mtime_ns_changed = new_mtime_ns != to_unix_ns(existing->mtime);
+
+        if (result.is_modified || identity_changed || mtime_ns_changed) {
+            std::string sql = "UPDATE files SET size=?, mtime=?, is_dir=?, dev=?, ino=?, nlink=?, mtime_ns=? WHERE id=?;";
             
-            sqlite3_stmt* stmt;
-            int rc = sqlite3_prepare_v2(db_.get_db(), sql.c_str(), -1, &stmt, nullptr);
-            if (rc != SQLITE_OK) {
+            auto stmt = db_.prepare(sql);
+            if (!stmt) {
                 throw std::runtime_error("Failed to prepare update: " + std::string(sqlite3_errmsg(db_.get_db())));
             }
 
             sqlite3_bind_int64(stmt, 1, static_cast<sqlite3_int64>(file.size));
             sqlite3_bind_int64(stmt, 2, static_cast<sqlite3_int64>(new_mtime));
             sqlite3_bind_int(stmt, 3, file.is_dir ? 1 : 0);
-            sqlite3_bind_int64(stmt, 4, file.id);
+            bind_identity(stmt, 4, file);
+            sqlite3_bind_int64(stmt, 7, new_mtime_ns);
+            sqlite3_bind_int64(stmt, 8, file.id);
 
             if (sqlite3_step(stmt) != SQLITE_DONE) {
-                sqlite3_finalize(stmt);
                 throw std::runtime_error("Failed to execute update: " + std::string(sqlite3_errmsg(db_.get_db())));
             }
-            sqlite3_finalize(stmt);
+        }
+
+        // Rows catalogued before directories were tracked (or moved since) get linked here
+        if (dir_id != 0) {
+            auto stmt = db_.prepare("UPDATE files SET dir_id=? WHERE id=? AND dir_id IS NOT ?;");
+            if (!stmt) {
+                throw std::runtime_error("Failed to prepare dir update: " + std::string(sqlite3_errmsg(db_.get_db())));
+            }
+            sqlite3_bind_int64(stmt, 1, dir_id);
+            sqlite3_bind_int64(stmt, 2, file.id);
+            sqlite3_bind_int64(stmt, 3, dir_id);
+            int rc = sqlite3_step(stmt);
+            if (rc != SQLITE_DONE) {
+                throw std::runtime_error("Failed to execute dir update: " + std::string(sqlite3_errmsg(db_.get_db())));
+            }
         }
     }
     return result;
 }
 
-void FileRepository::prune_missing(const std::vector<int64_t>& present_ids, const std::vector<std::filesystem::path>& roots) {
-    if (roots.empty()) return;
+std::vector<UpsertResult> FileRepository::upsert_batch(std::vector<FileInfo>& files, const std::vector<int64_t>& dir_ids,
+                                                       bool insert_new) {
+    std::vector<UpsertResult> results(files.size());
+    if (files.empty()) return results;
+
+    // Set-based steps run through the statement cache rather than execute()
+    auto run = [&](const char* sql) {
+        auto stmt = db_.prepare(sql);
+        if (!stmt || sqlite3_step(stmt) != SQLITE_DONE) {
+            std::string err = sqlite3_errmsg(db_.get_db());
+            db_.execute("DELETE FROM staged_files;");
+            throw std::runtime_error("Bulk upsert failed: " + err);
+        }
+    };
+
+    db_.execute("CREATE TEMPORARY TABLE IF NOT EXISTS staged_files ("
+                "seq INTEGER PRIMARY KEY, path TEXT NOT NULL, size INTEGER, mtime INTEGER, is_dir INTEGER, "
+                "dir_id INTEGER, dev INTEGER, ino INTEGER, nlink INTEGER, mtime_ns INTEGER, "
+                "id INTEGER, is_new INTEGER NOT NULL DEFAULT 0, modified INTEGER NOT NULL DEFAULT 0);");
+
+    // 1. Stream the rows into the staging table, resolving catalogued paths
+    // to their id on the way in
+    {
+        auto stmt = db_.prepare("INSERT INTO staged_files (seq, path, size, mtime, is_dir, dir_id, dev, ino, nlink, mtime_ns, id) "
+                                "VALUES (?1, ?2, ?3, ?4, ?5, ?6, ?7, ?8, ?9, ?10, (SELECT id FROM files WHERE path = ?2));");
+        if (!stmt) {
+            throw std::runtime_error("Failed to prepare staging insert: " + std::string(sqlite3_errmsg(db_.get_db())));
+        }
+#ifndef _WIN32
+        static_assert(std::is_same_v<std::filesystem::path::value_type, char>);
+#else
+        std::string path_str;
+#endif
+        for (std::size_t i = 0; i < files.size(); ++i) {
+            const auto& file = files[i];
+#ifndef _WIN32
+            const std::string& path_str = file.path.native();
+#else
+            path_str = file.path.string();
+#endif
+            sqlite3_bind_int64(stmt, 1, static_cast<sqlite3_int64>(i));
+            sqlite3_bind_text(stmt, 2, path_str.c_str(), static_cast<int>(path_str.size()), SQLITE_STATIC);
+            sqlite3_bind_int64(stmt, 3, static_cast<sqlite3_int64>(file.size));
+            sqlite3_bind_int64(stmt, 4, static_cast<sqlite3_int64>(to_unix(file.mtime)));
+            sqlite3_bind_int(stmt, 5, file.is_dir ? 1 : 0);
+            const int64_t dir_id = i < dir_ids.size() ? dir_ids[i] : 0;
+            if (dir_id != 0) sqlite3_bind_int64(stmt, 6, dir_id);
+            else sqlite3_bind_null(stmt, 6);
+            bind_identity(stmt, 7, file);
+            sqlite3_bind_int64(stmt, 10, to_unix_ns(file.mtime));
+            if (sqlite3_step(stmt) != SQLITE_DONE) {
+                std::string err = sqlite3_errmsg(db_.get_db());
+                sqlite3_reset(stmt);
+                db_.execute("DELETE FROM staged_files;");
+                throw std::runtime_error("Failed to stage file: " + err);
+            }
+            sqlite3_reset(stmt);
+        }
+    }
 
-    // 1. Create temp table
-    db_.execute("CREATE TEMPORARY TABLE IF NOT EXISTS present_files (id INTEGER PRIMARY KEY);");
-    db_.execute("DELETE FROM present_files;");
+    // 2. Flag modified rows, by upsert()'s rules: a different known inode is a
+    // replaced file even if size and mtime match
+    run("UPDATE staged_files SET modified = 1 FROM files f WHERE f.id = staged_files.id AND ("
+        "f.size IS NOT staged_files.size OR f.mtime IS NOT staged_files.mtime "
+        "OR f.is_dir IS NOT staged_files.is_dir "
+        "OR (staged_files.ino IS NOT NULL AND f.ino IS NOT NULL "
+        "AND (f.ino IS NOT staged_files.ino OR f.dev IS NOT staged_files.dev)));");
+
+    // 3. Write changed rows. A scanner without identity keeps the recorded one
+    // of an unchanged file.
+    run("UPDATE files SET size = s.size, mtime = s.mtime, mtime_ns = s.mtime_ns, is_dir = s.is_dir, "
+        "dir_id = COALESCE(s.dir_id, files.dir_id), "
+        "dev = CASE WHEN s.ino IS NULL AND NOT s.modified THEN files.dev ELSE s.dev END, "
+        "ino = CASE WHEN s.ino IS NULL AND NOT s.modified THEN files.ino ELSE s.ino END, "
+        "nlink = CASE WHEN s.ino IS NULL AND NOT s.modified THEN files.nlink ELSE s.nlink END "
+        "FROM staged_files s WHERE files.id = s.id AND (s.modified "
+        "OR COALESCE(files.mtime_ns, files.mtime * 1000000000) IS NOT s.mtime_ns "
+        "OR files.dir_id IS NOT COALESCE(s.dir_id, files.dir_id) "
+        "OR (s.ino IS NOT NULL AND (files.dev IS NOT s.dev OR files.ino IS NOT s.ino OR files.nlink IS NOT s.nlink)));");
+
+    // 4. Insert new rows (a path staged twice is inserted once) and collect their ids
+    if (insert_new) {
+        run("INSERT INTO files (path, size, mtime, is_dir, dir_id, dev, ino, nlink, mtime_ns) "
+            "SELECT path, size, mtime, is_dir, dir_id, dev, ino, nlink, mtime_ns FROM staged_files "
+            "WHERE id IS NULL ORDER BY seq ON CONFLICT(path) DO NOTHING;");
+        if (sqlite3_changes(db_.get_db()) > 0) {
+            run("UPDATE staged_files SET id = f.id, is_new = 1 "
+                "FROM files f WHERE staged_files.id IS NULL AND f.path = staged_files.path;");
+        }
+    }
 
-    // 2. Insert IDs
-    // db_.execute("BEGIN TRANSACTION;"); // Caller handles transaction
-    sqlite3_stmt* stmt;
-    if (sqlite3_prepare_v2(db_.get_db(), "INSERT INTO present_files (id) VALUES (?);", -1, &stmt, nullptr) == SQLITE_OK) {
-        for (auto id : present_ids) {
-            sqlite3_bind_int64(stmt, 1, id);
-            sqlite3_step(stmt);
-            sqlite3_reset(stmt);
+    // 5. Hand the ids back, with the identity that was kept (as upsert() does)
+    {
+        auto stmt = db_.prepare("SELECT s.seq, s.id, s.is_new, s.modified, f.dev, f.ino, f.nlink "
+                                "FROM staged_files s LEFT JOIN files f ON f.id = s.id;");
+        if (!stmt) {
+            throw std::runtime_error("Failed to prepare staging read: " + std::string(sqlite3_errmsg(db_.get_db())));
         }
-        sqlite3_finalize(stmt);
-    }
-    // db_.execute("COMMIT;");
-
-    // 3. Delete missing files under roots
-    // db_.execute("BEGIN TRANSACTION;");
-    sqlite3_stmt* del_stmt;
-    std::string sql = "DELETE FROM files WHERE id NOT IN (SELECT id FROM present_files) AND (";
-    for (size_t i = 0; i < roots.size(); ++i) {
-        if (i > 0) sql += " OR ";
-        sql += "path LIKE ? || '%'";
-    }
-    sql += ");";
-
-    if (sqlite3_prepare_v2(db_.get_db(), sql.c_str(), -1, &del_stmt, nullptr) == SQLITE_OK) {
-        for (size_t i = 0; i < roots.size(); ++i) {
-            std::string root_str = roots[i].string();
-            // Ensure root ends with separator to avoid partial matches (e.g. /foo matching /foobar)
-            // But we need to be careful with root itself.
-            // If root is "C:/foo", we want "C:/foo/bar" but also "C:/foo" itself?
-            // Usually roots are directories.
-            // Let's just use the path string.
-            sqlite3_bind_text(del_stmt, static_cast<int>(i + 1), root_str.c_str(), -1, SQLITE_TRANSIENT);
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            const auto i = static_cast<std::size_t>(sqlite3_column_int64(stmt, 0));
+            auto& file = files[i];
+            file.id = sqlite3_column_int64(stmt, 1);  // NULL (not inserted) reads as 0
+            results[i].is_new = sqlite3_column_int(stmt, 2) != 0;
+            results[i].is_modified = sqlite3_column_int(stmt, 3) != 0;
+            if (file.ino == 0) read_identity(stmt, 4, file);
         }
-        sqlite3_step(del_stmt);
-        sqlite3_finalize(del_stmt);
     }
-    // db_.execute("COMMIT;");
-    
-    db_.execute("DROP TABLE present_files;");
+    run("DELETE FROM staged_files;");
+    return results;
+}
+
+PathIndex FileRepository::load_snapshot(const std::vector<std::filesystem::path>& roots) {
+    PathIndex index;
+    auto stmt = db_.prepare("SELECT id, path, size, COALESCE(mtime_ns, mtime * 1000000000), dir_id, dev, ino, nlink "
+                            "FROM files WHERE path >= ? AND path < ? AND is_dir = 0;");
+    if (!stmt) return index;
+
+    for (const auto& [lo, hi] : subtree_ranges(roots)) {
+        sqlite3_bind_text(stmt, 1, lo.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 2, hi.c_str(), -1, SQLITE_STATIC);
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            auto path = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+            if (!path) continue;
+            index.add(std::string_view(path, static_cast<std::size_t>(sqlite3_column_bytes(stmt, 1))),
+                      sqlite3_column_int64(stmt, 0),
+                      static_cast<std::uintmax_t>(sqlite3_column_int64(stmt, 2)),
+                      sqlite3_column_int64(stmt, 3),
+                      sqlite3_column_int64(stmt, 4),
+                      static_cast<std::uint64_t>(sqlite3_column_int64(stmt, 5)),
+                      static_cast<std::uint64_t>(sqlite3_column_int64(stmt, 6)),
+                      static_cast<std::uint64_t>(sqlite3_column_int64(stmt, 7)));
+        }
+        sqlite3_reset(stmt);
+    }
+    return index;
+}
+
+void FileRepository::prune_missing(const std::vector<int64_t>& present_ids, const std::vector<std::filesystem::path>& roots) {
+    if (roots.empty()) return;
+
+    auto missing = missing_ids_under(db_, roots, present_ids);
+    if (missing.empty()) return;
+
+    auto stmt = db_.prepare("DELETE FROM files WHERE id = ?;");
+    if (!stmt) {
+        throw std::runtime_error("Failed to prepare prune delete: " + std::string(sqlite3_errmsg(db_.get_db())));
+    }
+    for (auto id : missing) {
+        sqlite3_bind_int64(stmt, 1, id);
+        sqlite3_step(stmt);
+        sqlite3_reset(stmt);
+    }
 }
 
 void FileRepository::update_path(int64_t id, const std::filesystem::path& new_path) {
     std::string sql = "UPDATE files SET path = ? WHERE id = ?;";
-    sqlite3_stmt* stmt;
-    int rc = sqlite3_prepare_v2(db_.get_db(), sql.c_str(), -1, &stmt, nullptr);
-    if (rc != SQLITE_OK) throw std::runtime_error("Failed to prepare update_path");
+    auto stmt = db_.prepare(sql);
+    if (!stmt) throw std::runtime_error("Failed to prepare update_path");
 
     std::string path_str = new_path.string();
     sqlite3_bind_text(stmt, 1, path_str.c_str(), -1, SQLITE_STATIC);
     sqlite3_bind_int64(stmt, 2, id);
 
     if (sqlite3_step(stmt) != SQLITE_DONE) {
-        sqlite3_finalize(stmt);
         throw std::runtime_error("Failed to execute update_path");
     }
-    sqlite3_finalize(stmt);
 }
 
 std::vector<FileInfo> FileRepository::get_missing_files(const std::vector<std::filesystem::path>& roots, const std::vector<int64_t>& present_ids) {
     std::vector<FileInfo> missing;
     if (roots.empty()) return missing;
 
-    // 1. Create temp table and insert present_ids
-    db_.execute("CREATE TEMPORARY TABLE IF NOT EXISTS present_files (id INTEGER PRIMARY KEY);");
-    db_.execute("DELETE FROM present_files;");
+    auto ids = missing_ids_under(db_, roots, present_ids);
+    if (ids.empty()) return missing;
 
-    sqlite3_stmt* stmt;
-    if (sqlite3_prepare_v2(db_.get_db(), "INSERT INTO present_files (id) VALUES (?);", -1, &stmt, nullptr) == SQLITE_OK) {
-        for (auto id : present_ids) {
-            sqlite3_bind_int64(stmt, 1, id);
-            sqlite3_step(stmt);
-            sqlite3_reset(stmt);
-        }
-        sqlite3_finalize(stmt);
-    }
-
-    // 2. Select missing files
-    std::string sql = "SELECT id, path, size, mtime, is_dir FROM files WHERE id NOT IN (SELECT id FROM present_files) AND (";
-    for (size_t i = 0; i < roots.size(); ++i) {
-        if (i > 0) sql += " OR ";
-        sql += "path LIKE ? || '%'";
-    }
-    sql += ");";
-
-    sqlite3_stmt* sel_stmt;
-    if (sqlite3_prepare_v2(db_.get_db(), sql.c_str(), -1, &sel_stmt, nullptr) == SQLITE_OK) {
-        for (size_t i = 0; i < roots.size(); ++i) {
-            std::string root_str = roots[i].string();
-            sqlite3_bind_text(sel_stmt, static_cast<int>(i + 1), root_str.c_str(), -1, SQLITE_TRANSIENT);
-        }
-        
-        while (sqlite3_step(sel_stmt) == SQLITE_ROW) {
+    auto stmt = db_.prepare("SELECT id, path, size, COALESCE(mtime_ns, mtime * 1000000000), is_dir, dev, ino, nlink "
+                            "FROM files WHERE id = ?;");
+    if (!stmt) return missing;
+    for (auto id : ids) {
+        sqlite3_bind_int64(stmt, 1, id);
+        if (sqlite3_step(stmt) == SQLITE_ROW) {
             FileInfo fi;
-            fi.id = sqlite3_column_int64(sel_stmt, 0);
-            const char* path_c = reinterpret_cast<const char*>(sqlite3_column_text(sel_stmt, 1));
+            fi.id = sqlite3_column_int64(stmt, 0);
+            const char* path_c = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
             if (path_c) fi.path = std::filesystem::u8path(path_c);
-            fi.size = static_cast<std::uintmax_t>(sqlite3_column_int64(sel_stmt, 2));
-            fi.mtime = from_unix(sqlite3_column_int64(sel_stmt, 3));
-            fi.is_dir = sqlite3_column_int(sel_stmt, 4) != 0;
-            missing.push_back(fi);
+            fi.size = static_cast<std::uintmax_t>(sqlite3_column_int64(stmt, 2));
+            fi.mtime = from_unix_ns(sqlite3_column_int64(stmt, 3));
+            fi.is_dir = sqlite3_column_int(stmt, 4) != 0;
+            read_identity(stmt, 5, fi);
+            missing.push_back(std::move(fi));
         }
-        sqlite3_finalize(sel_stmt);
+        sqlite3_reset(stmt);
     }
-    
-    db_.execute("DROP TABLE present_files;");
     return missing;
 }
 
+bool FileRepository::has_files_under(const std::vector<std::filesystem::path>& roots) {
+    auto stmt = db_.prepare("SELECT 1 FROM files WHERE path >= ? AND path < ? LIMIT 1;");
+    if (!stmt) return false;
+
+    for (const auto& [lo, hi] : subtree_ranges(roots)) {
+        sqlite3_bind_text(stmt, 1, lo.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 2, hi.c_str(), -1, SQLITE_STATIC);
+        bool found = sqlite3_step(stmt) == SQLITE_ROW;
+        sqlite3_reset(stmt);
+        if (found) return true;
+    }
+    return false;
+}
+
 void FileRepository::delete_files(const std::vector<int64_t>& ids) {
     if (ids.empty()) return;
     
     db_.execute("CREATE TEMPORARY TABLE IF NOT EXISTS delete_ids (id INTEGER PRIMARY KEY);");
     db_.execute("DELETE FROM delete_ids;");
     
-    sqlite3_stmt* stmt;
-    if (sqlite3_prepare_v2(db_.get_db(), "INSERT INTO delete_ids (id) VALUES (?);", -1, &stmt, nullptr) == SQLITE_OK) {
+    auto stmt = db_.prepare("INSERT INTO delete_ids (id) VALUES (?);");
+    if (stmt) {
         for (auto id : ids) {
             sqlite3_bind_int64(stmt, 1, id);
             sqlite3_step(stmt);
             sqlite3_reset(stmt);
         }
-        sqlite3_finalize(stmt);
     }
     
     db_.execute("DELETE FROM files WHERE id IN (SELECT id FROM delete_ids);");
     db_.execute("DROP TABLE delete_ids;");
 }
 
+std::vector<int64_t> FileRepository::get_ids_under(const std::filesystem::path& dir) {
+    std::vector<int64_t> ids;
+    auto [lo, hi] = subtree_range(dir);
+    auto stmt = db_.prepare("SELECT id FROM files WHERE path >= ? AND path < ?;");
+    if (!stmt) return ids;
+
+    sqlite3_bind_text(stmt, 1, lo.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 2, hi.c_str(), -1, SQLITE_STATIC);
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        ids.push_back(sqlite3_column_int64(stmt, 0));
+    }
+    return ids;
+}
+
+void FileRepository::move_tree(const std::filesystem::path& old_dir, const std::filesystem::path& new_dir) {
+    auto [lo, hi] = subtree_range(old_dir);
+    auto new_prefix = subtree_range(new_dir).first;
+    // substr() counts characters on TEXT; take the suffix as a BLOB so the
+    // offset is the byte length of lo even when the path is not ASCII
+    std::string sql = "UPDATE files SET path = ? || CAST(substr(CAST(path AS BLOB), ?) AS TEXT) "
+                      "WHERE path >= ? AND path < ?;";
+    auto stmt = db_.prepare(sql);
+    if (!stmt) {
+        throw std::runtime_error("Failed to prepare move_tree: " + std::string(sqlite3_errmsg(db_.get_db())));
+    }
+
+    sqlite3_bind_text(stmt, 1, new_prefix.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_int64(stmt, 2, static_cast<sqlite3_int64>(lo.size() + 1));  // substr() is 1-based
+    sqlite3_bind_text(stmt, 3, lo.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 4, hi.c_str(), -1, SQLITE_STATIC);
+
+    if (sqlite3_step(stmt) != SQLITE_DONE) {
+        std::string err = sqlite3_errmsg(db_.get_db());
+        throw std::runtime_error("Failed to execute move_tree: " + err);
+    }
+}
+
+void FileRepository::clear_hashes(int64_t file_id) {
+    auto stmt = db_.prepare("DELETE FROM file_hashes WHERE file_id = ?;");
+    if (!stmt) {
+        throw std::runtime_error("Failed to prepare clear_hashes");
+    }
+    sqlite3_bind_int64(stmt, 1, file_id);
+    sqlite3_step(stmt);
+}
+
 std::optional<FileInfo> FileRepository::get_by_path(const std::filesystem::path& path) {
-    std::string sql = "SELECT id, size, mtime, is_dir FROM files WHERE path = ?;";
-    sqlite3_stmt* stmt;
-    int rc = sqlite3_prepare_v2(db_.get_db(), sql.c_str(), -1, &stmt, nullptr);
-    if (rc != SQLITE_OK) return std::nullopt;
+    std::string sql = "SELECT id, size, COALESCE(mtime_ns, mtime * 1000000000), is_dir, dev, ino, nlink FROM files WHERE path = ?;";
+    auto stmt = db_.prepare(sql);
+    if (!stmt) return std::nullopt;
 
     std::string path_str = path.string();
     sqlite3_bind_text(stmt, 1, path_str.c_str(), -1, SQLITE_STATIC);
@@ -238,57 +491,174 @@ std::optional<FileInfo> FileRepository::get_by_path(const std::filesystem::path&
         fi.path = path;
         fi.id = sqlite3_column_int64(stmt, 0);
         fi.size = static_cast<std::uintmax_t>(sqlite3_column_int64(stmt, 1));
-        fi.mtime = from_unix(sqlite3_column_int64(stmt, 2));
+        fi.mtime = from_unix_ns(sqlite3_column_int64(stmt, 2));
         fi.is_dir = sqlite3_column_int(stmt, 3) != 0;
+        read_identity(stmt, 4, fi);
         result = fi;
     }
-    sqlite3_finalize(stmt);
     return result;
 }
 
-void FileRepository::add_hash(int64_t file_id, const std::string& algo, const std::string& value) {
-    std::string sql = "INSERT INTO file_hashes (file_id, algo, value) VALUES (?, ?, ?) "
-                      "ON CONFLICT(file_id, algo) DO UPDATE SET value=excluded.value;";
-    
-    sqlite3_stmt* stmt;
-    int rc = sqlite3_prepare_v2(db_.get_db(), sql.c_str(), -1, &stmt, nullptr);
-    if (rc != SQLITE_OK) throw std::runtime_error("Prepare failed");
+// Binds a hash in its storage form: INTEGER for 64-bit digests, else BLOB
+static void bind_hash(sqlite3_stmt* stmt, int index, const HashDigest& value) {
+    if (value.is_u64()) {
+        sqlite3_bind_int64(stmt, index, static_cast<sqlite3_int64>(value.as_u64()));
+    } else {
+        sqlite3_bind_blob(stmt, index, value.data(), static_cast<int>(value.size()), SQLITE_TRANSIENT);
+    }
+}
+
+static std::optional<HashDigest> read_hash(sqlite3_stmt* stmt, int col) {
+    switch (sqlite3_column_type(stmt, col)) {
+    case SQLITE_INTEGER:
+        return HashDigest::from_u64(static_cast<std::uint64_t>(sqlite3_column_int64(stmt, col)));
+    case SQLITE_BLOB:
+        return HashDigest::from_bytes(sqlite3_column_blob(stmt, col), static_cast<std::size_t>(sqlite3_column_bytes(stmt, col)));
+    default:
+        return std::nullopt;
+    }
+}
+
+static const char* kAddHashSql = "INSERT INTO file_hashes (file_id, algo, value, dev, ino, size, mtime_ns) "
+                                 "VALUES (?, ?, ?, ?, ?, ?, ?) "
+                                 "ON CONFLICT(file_id, algo) DO UPDATE SET value=excluded.value, dev=excluded.dev, "
+                                 "ino=excluded.ino, size=excluded.size, mtime_ns=excluded.mtime_ns;";
+
+// Binds the four token columns starting at index; all NULL without a token.
+static void bind_token(sqlite3_stmt* stmt, int index, const std::optional<ChangeToken>& token) {
+    if (!token) {
+        for (int i = 0; i < 4; ++i) sqlite3_bind_null(stmt, index + i);
+        return;
+    }
+    sqlite3_bind_int64(stmt, index, static_cast<sqlite3_int64>(token->dev));
+    sqlite3_bind_int64(stmt, index + 1, static_cast<sqlite3_int64>(token->ino));
+    sqlite3_bind_int64(stmt, index + 2, static_cast<sqlite3_int64>(token->size));
+    sqlite3_bind_int64(stmt, index + 3, token->mtime_ns);
+}
+
+// Hash column as get_hashes returns it: binary values as lowercase hex.
+static std::string read_hash_text(sqlite3_stmt* stmt, int col) {
+    if (auto digest = read_hash(stmt, col)) return digest->to_hex();
+    const char* val = reinterpret_cast<const char*>(sqlite3_column_text(stmt, col));
+    return val ? val : "";
+}
+
+void FileRepository::add_hash(int64_t file_id, const std::string& algo, const HashDigest& value,
+                              const std::optional<ChangeToken>& token) {
+    auto stmt = db_.prepare(kAddHashSql);
+    if (!stmt) throw std::runtime_error("Prepare failed");
+
+    sqlite3_bind_int64(stmt, 1, file_id);
+    sqlite3_bind_text(stmt, 2, algo.c_str(), -1, SQLITE_STATIC);
+    bind_hash(stmt, 3, value);
+    bind_token(stmt, 4, token);
+
+    if (sqlite3_step(stmt) != SQLITE_DONE) {
+        std::string err = sqlite3_errmsg(db_.get_db());
+        throw std::runtime_error("Failed to add hash: " + err);
+    }
+}
+
+void FileRepository::add_hash(int64_t file_id, const std::string& algo, const std::string& value,
+                              const std::optional<ChangeToken>& token) {
+    if (auto digest = HashDigest::from_hex(value)) {
+        add_hash(file_id, algo, *digest, token);
+        return;
+    }
+
+    auto stmt = db_.prepare(kAddHashSql);
+    if (!stmt) throw std::runtime_error("Prepare failed");
 
     sqlite3_bind_int64(stmt, 1, file_id);
     sqlite3_bind_text(stmt, 2, algo.c_str(), -1, SQLITE_STATIC);
     sqlite3_bind_text(stmt, 3, value.c_str(), -1, SQLITE_STATIC);
+    bind_token(stmt, 4, token);
 
     if (sqlite3_step(stmt) != SQLITE_DONE) {
         std::string err = sqlite3_errmsg(db_.get_db());
-        sqlite3_finalize(stmt);
         throw std::runtime_error("Failed to add hash: " + err);
     }
-    sqlite3_finalize(stmt);
+}
+
+std::optional<std::string> FileRepository::get_cached_hash(int64_t file_id, const std::string& algo,
+                                                           const ChangeToken& token) {
+    if (!token.identified()) return std::nullopt;
+    auto stmt = db_.prepare("SELECT value FROM file_hashes WHERE file_id = ? AND algo = ? "
+                            "AND dev = ? AND ino = ? AND size = ? AND mtime_ns = ?;");
+    if (!stmt) return std::nullopt;
+
+    sqlite3_bind_int64(stmt, 1, file_id);
+    sqlite3_bind_text(stmt, 2, algo.c_str(), -1, SQLITE_STATIC);
+    bind_token(stmt, 3, token);
+    if (sqlite3_step(stmt) != SQLITE_ROW) return std::nullopt;
+    return read_hash_text(stmt, 0);
 }
 
 std::vector<std::pair<std::string, std::string>> FileRepository::get_hashes(int64_t file_id) {
     std::vector<std::pair<std::string, std::string>> out;
     std::string sql = "SELECT algo, value FROM file_hashes WHERE file_id = ?;";
     
-    sqlite3_stmt* stmt;
-    if (sqlite3_prepare_v2(db_.get_db(), sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) return out;
+    auto stmt = db_.prepare(sql);
+    if (!stmt) return out;
 
     sqlite3_bind_int64(stmt, 1, file_id);
 
     while (sqlite3_step(stmt) == SQLITE_ROW) {
         std::string algo = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
-        std::string val = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
-        out.emplace_back(algo, val);
+        out.emplace_back(algo, read_hash_text(stmt, 1));
+    }
+    return out;
+}
+
+std::vector<StoredHash> FileRepository::get_hashes_by_algo(const std::string& algo) {
+    std::vector<StoredHash> out;
+    auto stmt = db_.prepare("SELECT file_id, value, dev, ino, size, mtime_ns FROM file_hashes WHERE algo = ?;");
+    if (!stmt) return out;
+
+    sqlite3_bind_text(stmt, 1, algo.c_str(), -1, SQLITE_STATIC);
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        StoredHash& h = out.emplace_back();
+        h.file_id = sqlite3_column_int64(stmt, 0);
+        h.value = read_hash_text(stmt, 1);
+        if (sqlite3_column_type(stmt, 5) != SQLITE_NULL) {
+            h.token = ChangeToken{static_cast<uint64_t>(sqlite3_column_int64(stmt, 2)),
+                                  static_cast<uint64_t>(sqlite3_column_int64(stmt, 3)),
+                                  static_cast<uintmax_t>(sqlite3_column_int64(stmt, 4)),
+                                  sqlite3_column_int64(stmt, 5)};
+        }
     }
-    sqlite3_finalize(stmt);
     return out;
 }
 
+std::optional<HashDigest> FileRepository::get_hash(int64_t file_id, const std::string& algo) {
+    auto stmt = db_.prepare("SELECT value FROM file_hashes WHERE file_id = ? AND algo = ?;");
+    if (!stmt) return std::nullopt;
+
+    sqlite3_bind_int64(stmt, 1, file_id);
+    sqlite3_bind_text(stmt, 2, algo.c_str(), -1, SQLITE_STATIC);
+
+    std::optional<HashDigest> result;
+    if (sqlite3_step(stmt) == SQLITE_ROW) result = read_hash(stmt, 0);
+    return result;
+}
+
+std::vector<int64_t> FileRepository::find_by_hash(const std::string& algo, const HashDigest& value) {
+    std::vector<int64_t> ids;
+    auto stmt = db_.prepare("SELECT file_id FROM file_hashes WHERE algo = ? AND value = ?;");
+    if (!stmt) return ids;
+
+    sqlite3_bind_text(stmt, 1, algo.c_str(), -1, SQLITE_STATIC);
+    bind_hash(stmt, 2, value);
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        ids.push_back(sqlite3_column_int64(stmt, 0));
+    }
+    return ids;
+}
+
 std::optional<FileInfo> FileRepository::get_by_id(int64_t id) {
-    std::string sql = "SELECT path, size, mtime, is_dir FROM files WHERE id = ?;";
-    sqlite3_stmt* stmt;
-    int rc = sqlite3_prepare_v2(db_.get_db(), sql.c_str(), -1, &stmt, nullptr);
-    if (rc != SQLITE_OK) return std::nullopt;
+    std::string sql = "SELECT path, size, COALESCE(mtime_ns, mtime * 1000000000), is_dir, dev, ino, nlink FROM files WHERE id = ?;";
+    auto stmt = db_.prepare(sql);
+    if (!stmt) return std::nullopt;
 
     sqlite3_bind_int64(stmt, 1, id);
 
@@ -299,46 +669,90 @@ std::optional<FileInfo> FileRepository::get_by_id(int64_t id) {
         const char* path_c = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
         if (path_c) fi.path = std::filesystem::u8path(path_c);
         fi.size = static_cast<std::uintmax_t>(sqlite3_column_int64(stmt, 1));
-        fi.mtime = from_unix(sqlite3_column_int64(stmt, 2));
+        fi.mtime = from_unix_ns(sqlite3_column_int64(stmt, 2));
         fi.is_dir = sqlite3_column_int(stmt, 3) != 0;
+        read_identity(stmt, 4, fi);
         result = fi;
     }
-    sqlite3_finalize(stmt);
     return result;
 }
 
-std::vector<int64_t> FileRepository::find_similar_images(uint64_t target_hash, int threshold) {
-    std::vector<int64_t> matches;
-    // Select all dhash values
-    std::string sql = "SELECT file_id, value FROM file_hashes WHERE algo = 'dhash';";
-    
-    sqlite3_stmt* stmt;
-    if (sqlite3_prepare_v2(db_.get_db(), sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) return matches;
+// Bands of a 64-bit hash in phash_bands (see migration 9)
+static constexpr int kHashBands = 4;
+static constexpr int kBandBits = 16;
+// Past this per-band radius (thresholds of 16 and up) the probes cost more than a scan
+static constexpr int kMaxBandRadius = 3;
+
+std::vector<SimilarImage> FileRepository::find_similar(uint64_t target_hash, int threshold, const std::string& algo) {
+    std::vector<SimilarImage> out;
+    if (threshold < 0) return out;
+
+    const int band_radius = threshold / kHashBands;
+    const bool indexed = band_radius <= kMaxBandRadius;
+    if (indexed) {
+        // Stage every key within band_radius bits of each band of the target
+        db_.execute("CREATE TEMPORARY TABLE IF NOT EXISTS similar_keys ("
+                    "band INTEGER NOT NULL, key INTEGER NOT NULL, PRIMARY KEY (band, key)) WITHOUT ROWID;");
+        db_.execute("DELETE FROM similar_keys;");
+        auto ins = db_.prepare("INSERT OR IGNORE INTO similar_keys (band, key) VALUES (?, ?);");
+        if (!ins) throw std::runtime_error("Failed to prepare similar_keys insert: " + std::string(sqlite3_errmsg(db_.get_db())));
+        for (int band = 0; band < kHashBands; ++band) {
+            const auto key = static_cast<uint32_t>((target_hash >> (band * kBandBits)) & 0xFFFF);
+            for (uint32_t flip = 0; flip <= 0xFFFF; ++flip) {
+                if (std::popcount(flip) > band_radius) continue;
+                sqlite3_bind_int(ins, 1, band);
+                sqlite3_bind_int64(ins, 2, key ^ flip);
+                sqlite3_step(ins);
+                sqlite3_reset(ins);
+            }
+        }
+    }
 
+    // CROSS JOIN keeps the few staged keys as the outer loop
+    const char* sql = indexed
+        ? "SELECT f.id, f.path, f.size, COALESCE(f.mtime_ns, f.mtime * 1000000000), f.is_dir, f.dev, f.ino, f.nlink, m.distance "
+          "FROM (SELECT DISTINCT b.file_id, fo_hamming(b.value, ?2) AS distance "
+          "      FROM similar_keys k CROSS JOIN phash_bands b ON b.algo = ?1 AND b.band = k.band AND b.key = k.key "
+          "      WHERE fo_hamming(b.value, ?2) <= ?3) m "
+          "JOIN files f ON f.id = m.file_id ORDER BY m.distance, f.id;"
+        : "SELECT f.id, f.path, f.size, COALESCE(f.mtime_ns, f.mtime * 1000000000), f.is_dir, f.dev, f.ino, f.nlink, fo_hamming(h.value, ?2) AS distance "
+          "FROM file_hashes h JOIN files f ON f.id = h.file_id "
+          "WHERE h.algo = ?1 AND typeof(h.value) = 'integer' AND fo_hamming(h.value, ?2) <= ?3 "
+          "ORDER BY distance, f.id;";
+    auto stmt = db_.prepare(sql);
+    if (!stmt) return out;
+
+    sqlite3_bind_text(stmt, 1, algo.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_int64(stmt, 2, static_cast<sqlite3_int64>(target_hash));
+    sqlite3_bind_int(stmt, 3, threshold);
     while (sqlite3_step(stmt) == SQLITE_ROW) {
-        int64_t file_id = sqlite3_column_int64(stmt, 0);
-        const char* val_c = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
-        if (!val_c) continue;
-
-        uint64_t hash = 0;
-        // Parse string to uint64
-        // Assuming decimal string from std::to_string
-        std::from_chars(val_c, val_c + strlen(val_c), hash);
-
-        int dist = std::popcount(target_hash ^ hash);
-        if (dist <= threshold) {
-            matches.push_back(file_id);
-        }
+        SimilarImage m;
+        m.file.id = sqlite3_column_int64(stmt, 0);
+        const char* path_c = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+        if (path_c) m.file.path = std::filesystem::u8path(path_c);
+        m.file.size = static_cast<std::uintmax_t>(sqlite3_column_int64(stmt, 2));
+        m.file.mtime = from_unix_ns(sqlite3_column_int64(stmt, 3));
+        m.file.is_dir = sqlite3_column_int(stmt, 4) != 0;
+        read_identity(stmt, 5, m.file);
+        m.distance = sqlite3_column_int(stmt, 8);
+        out.push_back(std::move(m));
+    }
+    return out;
+}
+
+std::vector<int64_t> FileRepository::find_similar_images(uint64_t target_hash, int threshold) {
+    std::vector<int64_t> matches;
+    for (const auto& m : find_similar(target_hash, threshold)) {
+        matches.push_back(m.file.id);
     }
-    sqlite3_finalize(stmt);
     return matches;
 }
 
 void FileRepository::add_tag(int64_t file_id, const std::string& tag, double confidence, const std::string& source) {
     // 1. Ensure tag exists
     std::string sql_tag = "INSERT INTO tags (name) VALUES (?) ON CONFLICT(name) DO UPDATE SET name=name RETURNING id;";
-    sqlite3_stmt* stmt_tag;
-    if (sqlite3_prepare_v2(db_.get_db(), sql_tag.c_str(), -1, &stmt_tag, nullptr) != SQLITE_OK) return;
+    auto stmt_tag = db_.prepare(sql_tag);
+    if (!stmt_tag) return;
     
     sqlite3_bind_text(stmt_tag, 1, tag.c_str(), -1, SQLITE_STATIC);
     
@@ -346,16 +760,14 @@ void FileRepository::add_tag(int64_t file_id, const std::string& tag, double con
     if (sqlite3_step(stmt_tag) == SQLITE_ROW) {
         tag_id = sqlite3_column_int64(stmt_tag, 0);
     }
-    sqlite3_finalize(stmt_tag);
     
     if (tag_id == 0) {
         // Fallback: select id if insert failed (shouldn't happen with RETURNING but just in case)
         std::string sql_sel = "SELECT id FROM tags WHERE name = ?;";
-        sqlite3_stmt* stmt_sel;
-        sqlite3_prepare_v2(db_.get_db(), sql_sel.c_str(), -1, &stmt_sel, nullptr);
-        sqlite3_bind_text(stmt_sel, 1, tag.c_str(), -1, SQLITE_STATIC);
-        if (sqlite3_step(stmt_sel) == SQLITE_ROW) tag_id = sqlite3_column_int64(stmt_sel, 0);
-        sqlite3_finalize(stmt_sel);
+        if (auto stmt_sel = db_.prepare(sql_sel)) {
+            sqlite3_bind_text(stmt_sel, 1, tag.c_str(), -1, SQLITE_STATIC);
+            if (sqlite3_step(stmt_sel) == SQLITE_ROW) tag_id = sqlite3_column_int64(stmt_sel, 0);
+        }
     }
     
     if (tag_id == 0) return; // Failed to get tag ID
@@ -364,8 +776,8 @@ void FileRepository::add_tag(int64_t file_id, const std::string& tag, double con
     std::string sql_link = "INSERT INTO file_tags (file_id, tag_id, confidence, source) VALUES (?, ?, ?, ?) "
                            "ON CONFLICT(file_id, tag_id) DO UPDATE SET confidence=excluded.confidence, source=excluded.source;";
     
-    sqlite3_stmt* stmt_link;
-    if (sqlite3_prepare_v2(db_.get_db(), sql_link.c_str(), -1, &stmt_link, nullptr) != SQLITE_OK) return;
+    auto stmt_link = db_.prepare(sql_link);
+    if (!stmt_link) return;
 
     sqlite3_bind_int64(stmt_link, 1, file_id);
     sqlite3_bind_int64(stmt_link, 2, tag_id);
@@ -373,7 +785,6 @@ void FileRepository::add_tag(int64_t file_id, const std::string& tag, double con
     sqlite3_bind_text(stmt_link, 4, source.c_str(), -1, SQLITE_STATIC);
 
     sqlite3_step(stmt_link);
-    sqlite3_finalize(stmt_link);
 }
 
 std::vector<std::pair<std::string, double>> FileRepository::get_tags(int64_t file_id) {
@@ -382,8 +793,8 @@ std::vector<std::pair<std::string, double>> FileRepository::get_tags(int64_t fil
                       "JOIN tags t ON ft.tag_id = t.id "
                       "WHERE ft.file_id = ? ORDER BY ft.confidence DESC;";
     
-    sqlite3_stmt* stmt;
-    if (sqlite3_prepare_v2(db_.get_db(), sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) return out;
+    auto stmt = db_.prepare(sql);
+    if (!stmt) return out;
 
     sqlite3_bind_int64(stmt, 1, file_id);
 
@@ -392,7 +803,6 @@ std::vector<std::pair<std::string, double>> FileRepository::get_tags(int64_t fil
         double conf = sqlite3_column_double(stmt, 1);
         out.emplace_back(name, conf);
     }
-    sqlite3_finalize(stmt);
     return out;
 }
 
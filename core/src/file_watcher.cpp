@@ -0,0 +1,386 @@
+#ifdef __linux__
+#include "fo/core/file_watcher.hpp"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/fanotify.h>
+#include <sys/inotify.h>
+#include <sys/statfs.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <stdexcept>
+#include <unordered_map>
+
+// Directory-entry reporting (5.9) and FAN_RENAME (5.17) are newer than some
+// distribution headers; the values are part of the kernel ABI.
+#ifndef FAN_REPORT_DIR_FID
+#define FAN_REPORT_DIR_FID 0x00000400
+#endif
+#ifndef FAN_REPORT_NAME
+#define FAN_REPORT_NAME 0x00000800
+#endif
+#ifndef FAN_REPORT_DFID_NAME
+#define FAN_REPORT_DFID_NAME (FAN_REPORT_DIR_FID | FAN_REPORT_NAME)
+#endif
+#ifndef FAN_RENAME
+#define FAN_RENAME 0x10000000
+#endif
+#ifndef FAN_EVENT_INFO_TYPE_DFID_NAME
+#define FAN_EVENT_INFO_TYPE_DFID_NAME 2
+#endif
+#ifndef FAN_EVENT_INFO_TYPE_OLD_DFID_NAME
+#define FAN_EVENT_INFO_TYPE_OLD_DFID_NAME 10
+#endif
+#ifndef FAN_EVENT_INFO_TYPE_NEW_DFID_NAME
+#define FAN_EVENT_INFO_TYPE_NEW_DFID_NAME 12
+#endif
+
+namespace fo::core {
+
+namespace {
+
+std::string strip_separator(std::string s) {
+    while (s.size() > 1 && s.back() == '/') s.pop_back();
+    return s;
+}
+
+bool is_under(const std::string& path, const std::string& dir) {
+    if (path.size() < dir.size() || path.compare(0, dir.size(), dir) != 0) return false;
+    return path.size() == dir.size() || path[dir.size()] == '/' || dir == "/";
+}
+
+// Waits for fd to become readable; false on timeout or EINTR
+bool wait_readable(int fd, int timeout_ms) {
+    pollfd pfd{fd, POLLIN, 0};
+    return ::poll(&pfd, 1, timeout_ms) > 0 && (pfd.revents & POLLIN);
+}
+
+} // namespace
+
+struct FileWatcher::Impl {
+    virtual ~Impl() = default;
+    virtual std::string name() const = 0;
+    virtual std::size_t poll(std::vector<FileChange>& out, int timeout_ms) = 0;
+};
+
+// fanotify with FAN_REPORT_DFID_NAME: events carry the parent directory's
+// file handle plus the entry name, resolved back to a path through
+// open_by_handle_at(). Filesystem marks see every change on the device, so
+// events outside the roots are dropped here.
+struct FileWatcher::FanotifyImpl : FileWatcher::Impl {
+    struct Mount {
+        int fd = -1;
+        fsid_t fsid{};
+    };
+
+    int fd = -1;
+    std::vector<std::string> roots;
+    std::vector<Mount> mounts;
+
+    explicit FanotifyImpl(const std::vector<std::filesystem::path>& root_paths) {
+        fd = fanotify_init(FAN_CLASS_NOTIF | FAN_CLOEXEC | FAN_NONBLOCK | FAN_REPORT_DFID_NAME, O_RDONLY | O_CLOEXEC);
+        if (fd < 0) throw std::runtime_error(std::string("fanotify_init failed: ") + std::strerror(errno));
+
+        const uint64_t base = FAN_CREATE | FAN_DELETE | FAN_CLOSE_WRITE | FAN_ONDIR;
+        for (const auto& r : root_paths) {
+            roots.push_back(strip_separator(r.string()));
+            uint64_t mask = base | FAN_RENAME;
+            int rc = fanotify_mark(fd, FAN_MARK_ADD | FAN_MARK_FILESYSTEM, mask, AT_FDCWD, r.c_str());
+            if (rc < 0 && errno == EINVAL) {
+                // Pre-5.17 kernels: the two halves of a rename arrive unpaired
+                mask = base | FAN_MOVED_FROM | FAN_MOVED_TO;
+                rc = fanotify_mark(fd, FAN_MARK_ADD | FAN_MARK_FILESYSTEM, mask, AT_FDCWD, r.c_str());
+            }
+            if (rc < 0) {
+                int err = errno;
+                close_all();
+                throw std::runtime_error("fanotify_mark failed for " + r.string() + ": " + std::strerror(err));
+            }
+
+            Mount m;
+            m.fd = ::open(r.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+            struct statfs sfs;
+            if (m.fd >= 0 && fstatfs(m.fd, &sfs) == 0) {
+                m.fsid = sfs.f_fsid;
+                mounts.push_back(m);
+            } else if (m.fd >= 0) {
+                ::close(m.fd);
+            }
+        }
+    }
+
+    ~FanotifyImpl() override { close_all(); }
+
+    void close_all() {
+        for (auto& m : mounts) ::close(m.fd);
+        mounts.clear();
+        if (fd >= 0) ::close(fd);
+        fd = -1;
+    }
+
+    std::string name() const override { return "fanotify"; }
+
+    // Directory handle + entry name -> absolute path; empty if the directory is gone
+    std::string resolve(const fanotify_event_info_fid* info) {
+        auto* handle = reinterpret_cast<file_handle*>(const_cast<unsigned char*>(info->handle));
+        const char* entry = reinterpret_cast<const char*>(handle->f_handle + handle->handle_bytes);
+
+        for (const auto& m : mounts) {
+            if (std::memcmp(&m.fsid, &info->fsid, sizeof(fsid_t)) != 0) continue;
+            int dfd = open_by_handle_at(m.fd, handle, O_PATH | O_CLOEXEC);
+            if (dfd < 0) return {};
+            char buf[PATH_MAX];
+            std::string link = "/proc/self/fd/" + std::to_string(dfd);
+            ssize_t n = ::readlink(link.c_str(), buf, sizeof(buf) - 1);
+            ::close(dfd);
+            if (n <= 0) return {};
+            std::string dir(buf, static_cast<size_t>(n));
+            if (std::strcmp(entry, ".") == 0 || entry[0] == '\0') return dir;
+            return dir == "/" ? dir + entry : dir + "/" + entry;
+        }
+        return {};
+    }
+
+    bool wanted(const std::string& p) const {
+        if (p.empty()) return false;
+        for (const auto& r : roots) if (is_under(p, r)) return true;
+        return false;
+    }
+
+    std::size_t poll(std::vector<FileChange>& out, int timeout_ms) override {
+        const std::size_t before = out.size();
+        if (!wait_readable(fd, timeout_ms)) return 0;
+
+        alignas(fanotify_event_metadata) char buf[64 * 1024];
+        for (;;) {
+            ssize_t len = ::read(fd, buf, sizeof(buf));
+            if (len <= 0) break;   // EAGAIN: drained
+
+            auto* md = reinterpret_cast<fanotify_event_metadata*>(buf);
+            for (; FAN_EVENT_OK(md, len); md = FAN_EVENT_NEXT(md, len)) {
+                if (md->fd >= 0) ::close(md->fd);
+                if (md->mask & FAN_Q_OVERFLOW) {
+                    FileChange c;
+                    c.kind = FileChange::Kind::Overflow;
+                    out.push_back(std::move(c));
+                    continue;
+                }
+
+                std::string path, old_path, new_path;
+                const char* p = reinterpret_cast<const char*>(md) + md->metadata_len;
+                const char* end = reinterpret_cast<const char*>(md) + md->event_len;
+                while (p + sizeof(fanotify_event_info_header) <= end) {
+                    auto* hdr = reinterpret_cast<const fanotify_event_info_header*>(p);
+                    if (hdr->len == 0) break;
+                    auto* info = reinterpret_cast<const fanotify_event_info_fid*>(p);
+                    switch (hdr->info_type) {
+                    case FAN_EVENT_INFO_TYPE_DFID_NAME: path = resolve(info); break;
+                    case FAN_EVENT_INFO_TYPE_OLD_DFID_NAME: old_path = resolve(info); break;
+                    case FAN_EVENT_INFO_TYPE_NEW_DFID_NAME: new_path = resolve(info); break;
+                    default: break;
+                    }
+                    p += hdr->len;
+                }
+
+                FileChange c;
+                c.is_dir = (md->mask & FAN_ONDIR) != 0;
+                if (md->mask & FAN_RENAME) {
+                    const bool from = wanted(old_path), to = wanted(new_path);
+                    if (from && to) {
+                        c.kind = FileChange::Kind::Renamed;
+                        c.old_path = old_path;
+                        c.path = new_path;
+                    } else if (from) {
+                        c.kind = FileChange::Kind::Removed;
+                        c.path = old_path;
+                    } else if (to) {
+                        c.kind = FileChange::Kind::Created;
+                        c.path = new_path;
+                    } else {
+                        continue;
+                    }
+                    out.push_back(std::move(c));
+                    continue;
+                }
+
+                if (!wanted(path)) continue;
+                c.path = path;
+                // Merged events can carry several bits; the consumer re-checks the disk anyway
+                if (md->mask & (FAN_DELETE | FAN_MOVED_FROM)) c.kind = FileChange::Kind::Removed;
+                else if (md->mask & (FAN_CREATE | FAN_MOVED_TO)) c.kind = FileChange::Kind::Created;
+                else if (md->mask & FAN_CLOSE_WRITE) c.kind = FileChange::Kind::Modified;
+                else continue;
+                out.push_back(std::move(c));
+            }
+        }
+        return out.size() - before;
+    }
+};
+
+// Recursive inotify: one watch per directory, added as directories appear.
+// Renames are paired through the event cookie; a directory renamed within the
+// roots keeps its watches and only their recorded paths change.
+struct FileWatcher::InotifyImpl : FileWatcher::Impl {
+    static constexpr uint32_t kMask = IN_CREATE | IN_DELETE | IN_CLOSE_WRITE | IN_MOVED_FROM | IN_MOVED_TO |
+                                      IN_DONT_FOLLOW | IN_EXCL_UNLINK | IN_ONLYDIR;
+
+    int fd = -1;
+    std::unordered_map<int, std::string> dirs;   // wd -> directory path
+
+    explicit InotifyImpl(const std::vector<std::filesystem::path>& roots) {
+        fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (fd < 0) throw std::runtime_error(std::string("inotify_init1 failed: ") + std::strerror(errno));
+        for (const auto& r : roots) {
+            if (inotify_add_watch(fd, r.c_str(), kMask) < 0) {
+                int err = errno;
+                ::close(fd);
+                throw std::runtime_error("inotify_add_watch failed for " + r.string() + ": " + std::strerror(err));
+            }
+            add_tree(r);
+        }
+    }
+
+    ~InotifyImpl() override { if (fd >= 0) ::close(fd); }
+
+    std::string name() const override { return "inotify"; }
+
+    // Watches dir and every directory below it; unreadable ones are skipped
+    void add_tree(const std::filesystem::path& dir) {
+        add_watch(strip_separator(dir.string()));
+        std::error_code ec;
+        auto opts = std::filesystem::directory_options::skip_permission_denied;
+        for (std::filesystem::recursive_directory_iterator it(dir, opts, ec), end; !ec && it != end; it.increment(ec)) {
+            std::error_code sec;
+            if (it->is_directory(sec) && !it->is_symlink(sec)) add_watch(it->path().string());
+        }
+    }
+
+    void add_watch(const std::string& dir) {
+        int wd = inotify_add_watch(fd, dir.c_str(), kMask);
+        if (wd >= 0) dirs[wd] = dir;
+    }
+
+    void drop_tree(const std::string& dir) {
+        for (auto it = dirs.begin(); it != dirs.end();) {
+            if (is_under(it->second, dir)) {
+                inotify_rm_watch(fd, it->first);
+                it = dirs.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    void move_tree(const std::string& from, const std::string& to) {
+        for (auto& [wd, p] : dirs) {
+            if (is_under(p, from)) p = to + p.substr(from.size());
+        }
+    }
+
+    std::size_t poll(std::vector<FileChange>& out, int timeout_ms) override {
+        const std::size_t before = out.size();
+        if (!wait_readable(fd, timeout_ms)) return 0;
+
+        struct PendingMove {
+            std::string path;
+            bool is_dir;
+        };
+        std::vector<std::pair<uint32_t, PendingMove>> moved_from;
+
+        alignas(inotify_event) char buf[64 * 1024];
+        for (;;) {
+            ssize_t len = ::read(fd, buf, sizeof(buf));
+            if (len <= 0) break;   // EAGAIN: drained
+
+            for (char* p = buf; p < buf + len;) {
+                auto* ev = reinterpret_cast<inotify_event*>(p);
+                p += sizeof(inotify_event) + ev->len;
+
+                if (ev->mask & IN_Q_OVERFLOW) {
+                    FileChange c;
+                    c.kind = FileChange::Kind::Overflow;
+                    out.push_back(std::move(c));
+                    continue;
+                }
+                if (ev->mask & IN_IGNORED) {
+                    dirs.erase(ev->wd);
+                    continue;
+                }
+                auto d = dirs.find(ev->wd);
+                if (d == dirs.end() || ev->len == 0) continue;
+
+                FileChange c;
+                c.path = d->second + "/" + ev->name;
+                c.is_dir = (ev->mask & IN_ISDIR) != 0;
+
+                if (ev->mask & IN_MOVED_FROM) {
+                    moved_from.emplace_back(ev->cookie, PendingMove{c.path.string(), c.is_dir});
+                    continue;
+                }
+                if (ev->mask & IN_MOVED_TO) {
+                    auto m = std::find_if(moved_from.begin(), moved_from.end(),
+                                          [&](const auto& e) { return e.first == ev->cookie; });
+                    if (m != moved_from.end()) {
+                        c.kind = FileChange::Kind::Renamed;
+                        c.old_path = m->second.path;
+                        if (c.is_dir) move_tree(m->second.path, c.path.string());
+                        moved_from.erase(m);
+                    } else {
+                        c.kind = FileChange::Kind::Created;
+                        if (c.is_dir) add_tree(c.path);
+                    }
+                } else if (ev->mask & IN_CREATE) {
+                    c.kind = FileChange::Kind::Created;
+                    // Files created before the watch exists are found by the consumer's walk
+                    if (c.is_dir) add_tree(c.path);
+                } else if (ev->mask & IN_DELETE) {
+                    c.kind = FileChange::Kind::Removed;
+                } else if (ev->mask & IN_CLOSE_WRITE) {
+                    c.kind = FileChange::Kind::Modified;
+                } else {
+                    continue;
+                }
+                out.push_back(std::move(c));
+            }
+        }
+
+        // Moved out of the roots
+        for (auto& [cookie, m] : moved_from) {
+            if (m.is_dir) drop_tree(m.path);
+            FileChange c;
+            c.kind = FileChange::Kind::Removed;
+            c.path = m.path;
+            c.is_dir = m.is_dir;
+            out.push_back(std::move(c));
+        }
+        return out.size() - before;
+    }
+};
+
+FileWatcher::FileWatcher(std::vector<std::filesystem::path> roots, Backend backend) {
+    if (backend != Backend::Inotify) {
+        try {
+            impl_ = std::make_unique<FanotifyImpl>(roots);
+            return;
+        } catch (const std::runtime_error&) {
+            if (backend == Backend::Fanotify) throw;
+        }
+    }
+    impl_ = std::make_unique<InotifyImpl>(roots);
+}
+
+FileWatcher::~FileWatcher() = default;
+
+std::string FileWatcher::backend_name() const { return impl_->name(); }
+
+std::size_t FileWatcher::poll(std::vector<FileChange>& out, int timeout_ms) {
+    return impl_->poll(out, timeout_ms);
+}
+
+} // namespace fo::core
+
+#endif // __linux__
@@ -0,0 +1,71 @@
+#include "fo/core/hash_digest.hpp"
+
+#include <cstring>
+
+namespace fo::core {
+
+static constexpr char kHexDigits[] = "0123456789abcdef";
+
+static int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+HashDigest HashDigest::from_u64(std::uint64_t v) {
+    HashDigest d;
+    for (int i = 7; i >= 0; --i) {
+        d.bytes_[i] = static_cast<std::uint8_t>(v & 0xff);
+        v >>= 8;
+    }
+    d.size_ = 8;
+    return d;
+}
+
+std::optional<HashDigest> HashDigest::from_bytes(const void* data, std::size_t size) {
+    if (size > kMaxBytes) return std::nullopt;
+    HashDigest d;
+    if (size) std::memcpy(d.bytes_.data(), data, size);
+    d.size_ = static_cast<std::uint8_t>(size);
+    return d;
+}
+
+std::optional<HashDigest> HashDigest::from_hex(std::string_view hex) {
+    if (hex.empty() || hex.size() % 2 != 0 || hex.size() / 2 > kMaxBytes) return std::nullopt;
+    HashDigest d;
+    for (std::size_t i = 0; i < hex.size(); i += 2) {
+        int hi = hex_value(hex[i]);
+        int lo = hex_value(hex[i + 1]);
+        if (hi < 0 || lo < 0) return std::nullopt;
+        d.bytes_[i / 2] = static_cast<std::uint8_t>((hi << 4) | lo);
+    }
+    d.size_ = static_cast<std::uint8_t>(hex.size() / 2);
+    return d;
+}
+
+std::string HashDigest::to_hex() const {
+    std::string out(size_ * 2, '0');
+    for (std::size_t i = 0; i < size_; ++i) {
+        out[2 * i] = kHexDigits[bytes_[i] >> 4];
+        out[2 * i + 1] = kHexDigits[bytes_[i] & 0xf];
+    }
+    return out;
+}
+
+std::uint64_t HashDigest::as_u64() const {
+    std::uint64_t v = 0;
+    for (std::size_t i = 0; i < size_ && i < 8; ++i) v = (v << 8) | bytes_[i];
+    return v;
+}
+
+std::string to_hex64(std::uint64_t v) {
+    std::string out(16, '0');
+    for (int i = 15; i >= 0; --i) {
+        out[i] = kHexDigits[v & 0xf];
+        v >>= 4;
+    }
+    return out;
+}
+
+} // namespace fo::core
@@ -0,0 +1,88 @@
+#include "fo/core/hash_executor.hpp"
+#include "fo/core/registry.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+namespace fo::core {
+
+HashExecutor::HashExecutor(unsigned jobs, unsigned io_jobs)
+    : jobs_(jobs ? jobs : std::thread::hardware_concurrency())
+    , io_jobs_(io_jobs) {
+    if (jobs_ == 0) jobs_ = 1;
+    if (io_jobs_ != 0 && io_jobs_ < jobs_) io_gate_ = std::make_unique<std::counting_semaphore<>>(io_jobs_);
+}
+
+HashExecutor::~HashExecutor() = default;
+
+void HashExecutor::run(std::vector<HashBucket>& buckets, IHasher& hasher, const Job& job) {
+    // Work items: consecutive files of one bucket
+    struct Piece {
+        HashBucket* bucket;
+        std::size_t begin, end;
+    };
+    std::vector<Piece> pieces;
+    std::size_t total = 0;
+    for (auto& b : buckets) {
+        b.hashes.assign(b.files.size(), std::string());
+        for (std::size_t i = 0; i < b.files.size(); i += kChunkFiles) {
+            pieces.push_back({&b, i, std::min(i + kChunkFiles, b.files.size())});
+        }
+        total += b.files.size();
+    }
+
+    auto hash_piece = [&](IHasher& h, const Piece& p) {
+        for (std::size_t i = p.begin; i < p.end; ++i) p.bucket->hashes[i] = job(h, *p.bucket->files[i]);
+    };
+
+    // Per-worker hashers; fall back to the caller's if the registry cannot make them
+    const auto workers = static_cast<unsigned>(std::min<std::size_t>(jobs_, total));
+    std::vector<std::unique_ptr<IHasher>> hashers;
+    if (workers > 1) {
+        for (unsigned i = 0; i < workers; ++i) {
+            auto h = Registry<IHasher>::instance().create(hasher.name());
+            if (!h) break;
+            hashers.push_back(std::move(h));
+        }
+    }
+    if (hashers.size() < 2) {
+        for (const auto& p : pieces) hash_piece(hasher, p);
+        return;
+    }
+
+    std::atomic<std::size_t> next{0};
+    std::atomic<bool> failed{false};
+    std::exception_ptr error;
+    std::mutex error_mtx;
+
+    auto work = [&](IHasher& h) {
+        try {
+            while (!failed.load(std::memory_order_relaxed)) {
+                const std::size_t i = next.fetch_add(1, std::memory_order_relaxed);
+                if (i >= pieces.size()) break;
+                hash_piece(h, pieces[i]);
+            }
+        } catch (...) {
+            std::lock_guard lk(error_mtx);
+            if (!error) error = std::current_exception();
+            failed.store(true, std::memory_order_relaxed);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(hashers.size());
+    try {
+        for (auto& h : hashers) threads.emplace_back(work, std::ref(*h));
+    } catch (...) {
+        failed.store(true, std::memory_order_relaxed);
+        for (auto& t : threads) t.join();
+        throw;
+    }
+    for (auto& t : threads) t.join();
+    if (error) std::rethrow_exception(error);
+}
+
+} // namespace fo::core
@@ -1,9 +1,6 @@
 #include "fo/providers/hasher_blake3.hpp"
+#include "fo/core/hash_digest.hpp"
 #include "fo/core/registry.hpp"
-#include <fstream>
-#include <vector>
-#include <iomanip>
-#include <sstream>
 
 #ifdef FO_HAVE_BLAKE3
 #include <blake3.h>
@@ -23,35 +20,29 @@ std::string Blake3Hasher::fast64(const std::filesystem::path& p) {
     // using the same sampling logic as Fast64Hasher but with BLAKE3.
     
     // Actually, let's just do a simple partial read.
-    std::ifstream f(p, std::ios::binary);
-    if (!f) return "";
+    using fo::core::FileReader;
+    if (!reader_.open(p, FileReader::Access::Sampled)) return "";
 
     blake3_hasher hasher;
     blake3_hasher_init(&hasher);
 
-    char buffer[8192];
-    f.read(buffer, sizeof(buffer));
-    blake3_hasher_update(&hasher, buffer, f.gcount());
+    auto update = [&](std::span<const std::uint8_t> data) { blake3_hasher_update(&hasher, data.data(), data.size()); };
+    const std::size_t chunk = 8192;
+    update(reader_.read(0, chunk));
 
-    // If file is large, seek to middle and end
-    auto size = std::filesystem::file_size(p);
+    // If file is large, sample the middle and end
+    const auto size = reader_.size();
     if (size > 65536) {
-        f.seekg(size / 2);
-        f.read(buffer, sizeof(buffer));
-        blake3_hasher_update(&hasher, buffer, f.gcount());
-        
-        f.seekg(-8192, std::ios::end);
-        f.read(buffer, sizeof(buffer));
-        blake3_hasher_update(&hasher, buffer, f.gcount());
+        update(reader_.read(size / 2, chunk));
+        update(reader_.read(size - chunk, chunk));
     }
+    reader_.close();
 
     uint8_t output[BLAKE3_OUT_LEN];
     blake3_hasher_finalize(&hasher, output, BLAKE3_OUT_LEN);
 
-    std::stringstream ss;
-    for(int i=0; i<8; ++i) // Just first 8 bytes for "fast64" equivalent? Or full hash?
-        ss << std::hex << std::setw(2) << std::setfill('0') << (int)output[i];
-    return ss.str();
+    // First 8 bytes, the width of the other fast64 hashes
+    return fo::core::HashDigest::from_bytes(output, 8)->to_hex();
 #else
     (void)p;
     return "";
@@ -60,27 +51,22 @@ std::string Blake3Hasher::fast64(const std::filesystem::path& p) {
 
 std::optional<std::string> Blake3Hasher::strong(const std::filesystem::path& p) {
 #ifdef FO_HAVE_BLAKE3
-    std::ifstream f(p, std::ios::binary);
-    if (!f) return std::nullopt;
+    using fo::core::FileReader;
+    if (!reader_.open(p, FileReader::Access::Sequential)) return std::nullopt;
 
     blake3_hasher hasher;
     blake3_hasher_init(&hasher);
 
-    char buffer[65536];
-    while (f.read(buffer, sizeof(buffer))) {
-        blake3_hasher_update(&hasher, buffer, f.gcount());
-    }
-    if (f.gcount() > 0) {
-        blake3_hasher_update(&hasher, buffer, f.gcount());
-    }
+    const bool ok = reader_.for_each_block([&](std::span<const std::uint8_t> block) {
+        blake3_hasher_update(&hasher, block.data(), block.size());
+    });
+    reader_.close();
+    if (!ok) return std::nullopt;
 
     uint8_t output[BLAKE3_OUT_LEN];
     blake3_hasher_finalize(&hasher, output, BLAKE3_OUT_LEN);
 
-    std::stringstream ss;
-    for(int i=0; i<BLAKE3_OUT_LEN; ++i)
-        ss << std::hex << std::setw(2) << std::setfill('0') << (int)output[i];
-    return ss.str();
+    return fo::core::HashDigest::from_bytes(output, BLAKE3_OUT_LEN)->to_hex();
 #else
     (void)p;
     return std::nullopt;
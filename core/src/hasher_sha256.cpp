@@ -1,8 +1,7 @@
 #include "fo/core/interfaces.hpp"
+#include "fo/core/file_reader.hpp"
 #include "fo/core/registry.hpp"
 #include "../../libs/hash-library/sha256.h"
-#include <fstream>
-#include <array>
 
 namespace fo::core {
 
@@ -12,6 +11,9 @@ public:
     std::string fast64(const std::filesystem::path& p) override;
     std::optional<std::string> strong(const std::filesystem::path& p) override;
     std::string strong_algo() const override { return "sha256"; }
+
+private:
+    FileReader reader_;
 };
 
 std::string SHA256Hasher::fast64(const std::filesystem::path& p) {
@@ -22,17 +24,14 @@ std::string SHA256Hasher::fast64(const std::filesystem::path& p) {
 }
 
 std::optional<std::string> SHA256Hasher::strong(const std::filesystem::path& p) {
-    std::ifstream f(p, std::ios::binary);
-    if (!f) return std::nullopt;
+    if (!reader_.open(p, FileReader::Access::Sequential)) return std::nullopt;
 
     SHA256 sha;
-    std::array<char, 16 * 1024> buf;
-    while (f) {
-        f.read(buf.data(), buf.size());
-        std::streamsize got = f.gcount();
-        if (got <= 0) break;
-        sha.add(buf.data(), static_cast<size_t>(got));
-    }
+    const bool ok = reader_.for_each_block([&](std::span<const std::uint8_t> block) {
+        sha.add(block.data(), block.size());
+    });
+    reader_.close();
+    if (!ok) return std::nullopt;
     return sha.getHash();
 }
 
@@ -0,0 +1,322 @@
+#include "fo/core/ignore_matcher.hpp"
+#include "fo/core/ignore_repository.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <unordered_map>
+
+namespace fo::core {
+
+namespace {
+
+constexpr std::string_view kGlobPrefix = "glob:";
+constexpr std::string_view kDirPrefix = "dir:";
+
+bool is_separator(char c) {
+#ifdef _WIN32
+    return c == '/' || c == '\\';
+#else
+    return c == '/';
+#endif
+}
+
+void append_escaped(std::string& re, char c) {
+    if (std::strchr("\\^$.|?*+()[]{}", c) && c != '\0') re += '\\';
+    re += c;
+}
+
+// gitignore-style glob -> ECMAScript regex over a '/'-separated path
+std::string glob_to_regex(std::string_view g) {
+    const bool dir_only = g.size() > 1 && g.back() == '/';
+    if (dir_only) g.remove_suffix(1);
+
+    // A leading slash anchors the glob to the start of the path; otherwise it
+    // may start at any component boundary
+    std::string re = (!g.empty() && g.front() == '/') ? "^" : "(?:^|/)";
+    for (size_t i = 0; i < g.size(); ++i) {
+        char c = g[i];
+        if (c == '*') {
+            if (i + 1 < g.size() && g[i + 1] == '*') {
+                const bool at_start = i == 0 || g[i - 1] == '/';
+                if (at_start && i + 2 < g.size() && g[i + 2] == '/') {
+                    re += "(?:[^/]*/)*";   // "**/": zero or more whole components
+                    i += 2;
+                } else {
+                    re += ".*";
+                    i += 1;
+                }
+                continue;
+            }
+            re += "[^/]*";
+        } else if (c == '?') {
+            re += "[^/]";
+        } else if (c == '[') {
+            size_t j = i + 1;
+            if (j < g.size() && (g[j] == '!' || g[j] == '^')) ++j;
+            if (j < g.size() && g[j] == ']') ++j;
+            while (j < g.size() && g[j] != ']') ++j;
+            if (j >= g.size()) { re += "\\["; continue; }   // unterminated: literal '['
+            re += '[';
+            size_t k = i + 1;
+            if (g[k] == '!' || g[k] == '^') { re += '^'; ++k; }
+            for (; k < j; ++k) {
+                if (g[k] == '\\') re += "\\\\";
+                else re += g[k];
+            }
+            re += ']';
+            i = j;
+        } else if (c == '\\' && i + 1 < g.size()) {
+            append_escaped(re, g[++i]);
+        } else {
+            append_escaped(re, c);
+        }
+    }
+    re += dir_only ? "/" : "(?:/|$)";
+    return re;
+}
+
+bool is_literal(std::string_view p) {
+    return p.find_first_of("\\^$.|?*+()[]{}") == std::string_view::npos;
+}
+
+// Whether a match in a directory prefix implies a match in every longer path:
+// no end anchors, word boundaries or lookarounds
+bool prefix_safe(std::string_view p) {
+    for (size_t i = 0; i < p.size(); ++i) {
+        if (p[i] == '\\' && i + 1 < p.size()) {
+            if (p[i + 1] == 'b' || p[i + 1] == 'B') return false;
+            ++i;
+        } else if (p[i] == '$') {
+            return false;
+        } else if (p[i] == '(' && i + 1 < p.size() && p[i + 1] == '?' && i + 2 < p.size() &&
+                   (p[i + 2] == '=' || p[i + 2] == '!')) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool has_backref(std::string_view p) {
+    for (size_t i = 0; i + 1 < p.size(); ++i) {
+        if (p[i] != '\\') continue;
+        if (p[i + 1] >= '1' && p[i + 1] <= '9') return true;
+        ++i;
+    }
+    return false;
+}
+
+std::optional<std::regex> combine(const std::vector<std::string>& parts) {
+    if (parts.empty()) return std::nullopt;
+    std::string all;
+    for (const auto& p : parts) {
+        if (!all.empty()) all += '|';
+        all += "(?:" + p + ")";
+    }
+    return std::regex(all);
+}
+
+void split_components(std::string_view path, std::vector<std::string_view>& out) {
+    out.clear();
+    size_t i = 0;
+    if (!path.empty() && is_separator(path[0])) {
+        out.push_back(std::string_view());   // root
+        i = 1;
+    }
+    while (i < path.size()) {
+        size_t j = i;
+        while (j < path.size() && !is_separator(path[j])) ++j;
+        if (j > i) out.push_back(path.substr(i, j - i));
+        i = j + 1;
+    }
+}
+
+std::string with_trailing_separator(std::string_view dir) {
+    std::string s(dir);
+    if (s.empty() || !is_separator(s.back())) s += static_cast<char>(std::filesystem::path::preferred_separator);
+    return s;
+}
+
+} // namespace
+
+struct IgnoreMatcher::Literals {
+    struct Node {
+        std::vector<std::pair<unsigned char, int32_t>> next;
+        int32_t fail = 0;
+        bool out = false;
+    };
+    std::vector<Node> nodes = std::vector<Node>(1);
+
+    int32_t find(int32_t s, unsigned char c) const {
+        for (auto& [k, v] : nodes[s].next) if (k == c) return v;
+        return -1;
+    }
+
+    void add(std::string_view lit) {
+        int32_t s = 0;
+        for (unsigned char c : lit) {
+            int32_t n = find(s, c);
+            if (n < 0) {
+                n = static_cast<int32_t>(nodes.size());
+                nodes[s].next.emplace_back(c, n);
+                nodes.emplace_back();
+            }
+            s = n;
+        }
+        nodes[s].out = true;
+    }
+
+    void build() {
+        std::deque<int32_t> queue;
+        for (auto& [c, v] : nodes[0].next) queue.push_back(v);
+        while (!queue.empty()) {
+            int32_t u = queue.front();
+            queue.pop_front();
+            for (auto& [c, v] : nodes[u].next) {
+                int32_t f = nodes[u].fail;
+                int32_t g;
+                while ((g = find(f, c)) < 0 && f != 0) f = nodes[f].fail;
+                nodes[v].fail = g >= 0 ? g : 0;
+                nodes[v].out = nodes[v].out || nodes[nodes[v].fail].out;
+                queue.push_back(v);
+            }
+        }
+    }
+
+    bool search(std::string_view text) const {
+        if (nodes[0].out) return true;   // empty pattern
+        int32_t s = 0;
+        for (unsigned char c : text) {
+            int32_t g;
+            while ((g = find(s, c)) < 0 && s != 0) s = nodes[s].fail;
+            s = g >= 0 ? g : 0;
+            if (nodes[s].out) return true;
+        }
+        return false;
+    }
+};
+
+struct IgnoreMatcher::DirTrie {
+    struct Node {
+        std::unordered_map<std::string, size_t> children;
+        bool terminal = false;
+    };
+    std::vector<Node> nodes = std::vector<Node>(1);
+
+    void add(std::string_view dir) {
+        std::vector<std::string_view> comps;
+        split_components(dir, comps);
+        size_t n = 0;
+        for (auto comp : comps) {
+            auto it = nodes[n].children.find(std::string(comp));
+            if (it == nodes[n].children.end()) {
+                size_t id = nodes.size();
+                nodes[n].children.emplace(std::string(comp), id);
+                nodes.emplace_back();
+                n = id;
+            } else {
+                n = it->second;
+            }
+        }
+        nodes[n].terminal = true;
+    }
+
+    // True if some rule is the path itself or one of its ancestors
+    bool covers(std::string_view path) const {
+        std::vector<std::string_view> comps;
+        split_components(path, comps);
+        size_t n = 0;
+        if (nodes[0].terminal) return true;
+        std::string key;
+        for (auto comp : comps) {
+            key.assign(comp);
+            auto it = nodes[n].children.find(key);
+            if (it == nodes[n].children.end()) return false;
+            n = it->second;
+            if (nodes[n].terminal) return true;
+        }
+        return false;
+    }
+};
+
+IgnoreMatcher::IgnoreMatcher() = default;
+IgnoreMatcher::~IgnoreMatcher() = default;
+IgnoreMatcher::IgnoreMatcher(IgnoreMatcher&&) noexcept = default;
+IgnoreMatcher& IgnoreMatcher::operator=(IgnoreMatcher&&) noexcept = default;
+
+IgnoreMatcher::IgnoreMatcher(const std::vector<IgnoreRule>& rules) {
+    std::vector<std::string> globs, prunable, other;
+    for (const auto& r : rules) {
+        std::string_view p = r.pattern;
+        if (p.substr(0, kGlobPrefix.size()) == kGlobPrefix) {
+            globs.push_back(glob_to_regex(p.substr(kGlobPrefix.size())));
+            continue;
+        }
+        if (p.substr(0, kDirPrefix.size()) == kDirPrefix) {
+            if (!dirs_) dirs_ = std::make_unique<DirTrie>();
+            dirs_->add(p.substr(kDirPrefix.size()));
+            continue;
+        }
+        bool literal = is_literal(p);
+        if (!literal) {
+            // Invalid expressions were always matched as plain substrings
+            try { std::regex check(r.pattern); } catch (...) { literal = true; }
+        }
+        if (literal) {
+            if (!literals_) literals_ = std::make_unique<Literals>();
+            literals_->add(p);
+        } else if (has_backref(p)) {
+            backref_regexes_.emplace_back(r.pattern);
+        } else if (prefix_safe(p)) {
+            prunable.push_back(r.pattern);
+        } else {
+            other.push_back(r.pattern);
+        }
+    }
+    if (literals_) literals_->build();
+    globs_ = combine(globs);
+    prunable_regex_ = combine(prunable);
+    other_regex_ = combine(other);
+    empty_ = rules.empty();
+}
+
+bool IgnoreMatcher::matches(std::string_view path) const {
+    if (empty_) return false;
+    if (dirs_ && dirs_->covers(path)) return true;
+    if (literals_ && literals_->search(path)) return true;
+    if (globs_) {
+#ifdef _WIN32
+        std::string generic(path);
+        std::replace(generic.begin(), generic.end(), '\\', '/');
+        if (std::regex_search(generic, *globs_)) return true;
+#else
+        if (std::regex_search(path.begin(), path.end(), *globs_)) return true;
+#endif
+    }
+    if (prunable_regex_ && std::regex_search(path.begin(), path.end(), *prunable_regex_)) return true;
+    if (other_regex_ && std::regex_search(path.begin(), path.end(), *other_regex_)) return true;
+    for (const auto& re : backref_regexes_) {
+        if (std::regex_search(path.begin(), path.end(), re)) return true;
+    }
+    return false;
+}
+
+bool IgnoreMatcher::prunes_directory(std::string_view dir) const {
+    if (empty_) return false;
+    if (dirs_ && dirs_->covers(dir)) return true;
+    // Every path below dir starts with "dir/", so a match there carries over
+    const std::string prefix = with_trailing_separator(dir);
+    if (literals_ && literals_->search(prefix)) return true;
+    if (globs_) {
+        std::string generic = prefix;
+#ifdef _WIN32
+        std::replace(generic.begin(), generic.end(), '\\', '/');
+#endif
+        if (std::regex_search(generic, *globs_)) return true;
+    }
+    if (prunable_regex_ && std::regex_search(prefix, *prunable_regex_)) return true;
+    return false;
+}
+
+} // namespace fo::core
@@ -0,0 +1,67 @@
+#pragma once
+
+// Pieces shared by the scanners that read directories with getdents64 and
+// stat files with statx (scanner_linux.cpp, scanner_uring.cpp).
+
+#ifdef __linux__
+#include <sys/stat.h>
+
+#include "extension_filter.hpp"
+
+#include <cctype>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace fo::core {
+
+// Fixed header of the kernel record returned by getdents64 (not exported by
+// glibc headers); the NUL-terminated name follows d_type directly.
+struct linux_dirent64 {
+    uint64_t d_ino;
+    int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+};
+inline constexpr size_t kDirentNameOffset = offsetof(linux_dirent64, d_type) + 1;
+
+inline std::chrono::file_clock::time_point from_statx_time(const struct statx_timestamp& ts) {
+    auto sys = std::chrono::system_clock::time_point(
+        std::chrono::duration_cast<std::chrono::system_clock::duration>(
+            std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec)));
+    return std::chrono::clock_cast<std::chrono::file_clock>(sys);
+}
+
+// Extension filter that works on the raw d_name, so rejected entries never
+// build a path or hit statx. Same rules as ExtensionFilter.
+class DirentNameFilter {
+public:
+    explicit DirentNameFilter(const std::vector<std::string>& include_exts)
+        : exts_(normalize_exts(include_exts)) {}
+
+    bool accepts(const char* name, size_t len) const {
+        if (exts_.empty()) return true;
+        const char* dot = static_cast<const char*>(memrchr(name, '.', len));
+        if (!dot || dot == name) return false;
+        size_t ext_len = len - static_cast<size_t>(dot - name);
+        for (auto& e : exts_) {
+            if (e.size() != ext_len) continue;
+            bool eq = true;
+            for (size_t i = 0; i < ext_len && eq; ++i) {
+                eq = static_cast<char>(std::tolower(static_cast<unsigned char>(dot[i]))) == e[i];
+            }
+            if (eq) return true;
+        }
+        return false;
+    }
+
+private:
+    std::vector<std::string> exts_;   // lower case, with the leading dot
+};
+
+} // namespace fo::core
+
+#endif // __linux__
@@ -33,8 +33,8 @@ int64_t OperationRepository::log_operation(const OperationRecord& record) {
         VALUES (?, ?, ?, ?, ?, ?, ?, ?)
     )";
 
-    sqlite3_stmt* stmt;
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+    auto stmt = db_.prepare(sql);
+    if (!stmt) {
         throw std::runtime_error("Failed to prepare statement: " + std::string(sqlite3_errmsg(db)));
     }
 
@@ -50,12 +50,10 @@ int64_t OperationRepository::log_operation(const OperationRecord& record) {
     sqlite3_bind_int(stmt, 8, record.undone ? 1 : 0);
 
     if (sqlite3_step(stmt) != SQLITE_DONE) {
-        sqlite3_finalize(stmt);
         throw std::runtime_error("Failed to insert operation: " + std::string(sqlite3_errmsg(db)));
     }
 
     int64_t id = sqlite3_last_insert_rowid(db);
-    sqlite3_finalize(stmt);
     return id;
 }
 
@@ -66,8 +64,8 @@ std::vector<OperationRecord> OperationRepository::get_all(int limit) {
     std::string sql = "SELECT id, timestamp, operation_type, source_path, dest_path, file_size, file_hash, status, undone "
                       "FROM operation_log ORDER BY timestamp DESC LIMIT " + std::to_string(limit);
 
-    sqlite3_stmt* stmt;
-    if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+    auto stmt = db_.prepare(sql);
+    if (!stmt) {
         throw std::runtime_error("Failed to prepare statement: " + std::string(sqlite3_errmsg(db)));
     }
 
@@ -85,7 +83,6 @@ std::vector<OperationRecord> OperationRepository::get_all(int limit) {
         results.push_back(rec);
     }
 
-    sqlite3_finalize(stmt);
     return results;
 }
 
@@ -96,8 +93,8 @@ std::vector<OperationRecord> OperationRepository::get_undoable(int limit) {
     std::string sql = "SELECT id, timestamp, operation_type, source_path, dest_path, file_size, file_hash, status, undone "
                       "FROM operation_log WHERE undone = 0 AND status = 'completed' ORDER BY timestamp DESC LIMIT " + std::to_string(limit);
 
-    sqlite3_stmt* stmt;
-    if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+    auto stmt = db_.prepare(sql);
+    if (!stmt) {
         throw std::runtime_error("Failed to prepare statement: " + std::string(sqlite3_errmsg(db)));
     }
 
@@ -115,7 +112,6 @@ std::vector<OperationRecord> OperationRepository::get_undoable(int limit) {
         results.push_back(rec);
     }
 
-    sqlite3_finalize(stmt);
     return results;
 }
 
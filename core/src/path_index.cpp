@@ -0,0 +1,121 @@
+#include "fo/core/path_index.hpp"
+
+#include <chrono>
+#include <functional>
+
+namespace fo::core {
+
+namespace {
+
+// splitmix64 finaliser
+std::uint64_t mix(std::uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+// Same conversion FileRepository uses for files.mtime_ns
+int64_t to_unix_ns(std::chrono::file_clock::time_point tp) {
+    try {
+        auto sys = std::chrono::clock_cast<std::chrono::system_clock>(tp);
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(sys.time_since_epoch()).count();
+    } catch (...) {
+        return 0;
+    }
+}
+
+} // namespace
+
+std::uint64_t PathIndex::hash_path(std::string_view path) {
+    // std::hash is only 32 bits wide on some platforms; mix() spreads it over 64
+    std::uint64_t h = mix(static_cast<std::uint64_t>(std::hash<std::string_view>{}(path)) ^ (path.size() << 48));
+    return h == 0 ? 1 : h;
+}
+
+std::uint64_t PathIndex::make_stamp(std::uintmax_t size, int64_t mtime_ns, int64_t dir_id) {
+    std::uint64_t h = mix(static_cast<std::uint64_t>(size));
+    h = mix(h ^ static_cast<std::uint64_t>(mtime_ns));
+    return mix(h ^ static_cast<std::uint64_t>(dir_id));
+}
+
+std::uint32_t PathIndex::make_ident(std::uint64_t dev, std::uint64_t ino, std::uint64_t nlink) {
+    if (ino == 0) return 0;
+    std::uint32_t h = static_cast<std::uint32_t>(mix(mix(mix(dev) ^ ino) ^ nlink) >> 32);
+    return h == 0 ? 1 : h;
+}
+
+void PathIndex::add(std::string_view path, int64_t id, std::uintmax_t size, int64_t mtime_ns,
+                    int64_t dir_id, std::uint64_t dev, std::uint64_t ino, std::uint64_t nlink) {
+    if ((count_ + 1) * 5 > slots_.size() * 4) grow();
+
+    const std::uint64_t hash = hash_path(path);
+    const std::size_t mask = slots_.size() - 1;
+    std::size_t i = hash & mask;
+    while (slots_[i].hash != 0) {
+        if (slots_[i].hash == hash) {
+            // Two catalogued paths share the hash: neither can be trusted
+            slots_[i].id = 0;
+            return;
+        }
+        i = (i + 1) & mask;
+    }
+    Slot& s = slots_[i];
+    s.hash = hash;
+    s.stamp = make_stamp(size, mtime_ns, dir_id);
+    // Ids beyond 32 bits are looked up in the database like collisions
+    s.id = id > 0 && id <= static_cast<int64_t>(UINT32_MAX) ? static_cast<std::uint32_t>(id) : 0;
+    s.ident = make_ident(dev, ino, nlink);
+    ++count_;
+}
+
+const PathIndex::Slot* PathIndex::lookup(std::uint64_t hash) const {
+    if (slots_.empty()) return nullptr;
+    const std::size_t mask = slots_.size() - 1;
+    std::size_t i = hash & mask;
+    while (slots_[i].hash != 0) {
+        if (slots_[i].hash == hash) return &slots_[i];
+        i = (i + 1) & mask;
+    }
+    return nullptr;
+}
+
+PathIndex::Match PathIndex::find(const FileInfo& file, int64_t dir_id) const {
+    Match m;
+#ifdef _WIN32
+    const std::string path = file.path.string();
+#else
+    const std::string& path = file.path.native();
+#endif
+    const Slot* s = lookup(hash_path(path));
+    if (!s) return m;
+    if (s->id == 0) {
+        m.state = State::Ambiguous;
+        return m;
+    }
+    m.id = s->id;
+    // An identity the scanner read must match the recorded one (or be written
+    // if none is recorded); without one only size, mtime and directory count
+    const std::uint32_t ident = make_ident(file.dev, file.ino, file.nlink);
+    const bool same_identity = ident == 0 || ident == s->ident;
+    m.state = same_identity && s->stamp == make_stamp(file.size, to_unix_ns(file.mtime), dir_id)
+                  ? State::Unchanged
+                  : State::Changed;
+    return m;
+}
+
+void PathIndex::grow() {
+    std::vector<Slot> old = std::move(slots_);
+    slots_.assign(old.empty() ? 1024 : old.size() * 2, Slot{});
+    const std::size_t mask = slots_.size() - 1;
+    for (const auto& s : old) {
+        if (s.hash == 0) continue;
+        std::size_t i = s.hash & mask;
+        while (slots_[i].hash != 0) i = (i + 1) & mask;
+        slots_[i] = s;
+    }
+}
+
+} // namespace fo::core
@@ -1,14 +1,14 @@
 #include "fo/providers/blake3/blake3_hasher.hpp"
+#include "fo/core/hash_digest.hpp"
+#include "fo/core/file_reader.hpp"
 #include "fo/core/provider.hpp"
-#include <fstream>
-#include <sstream>
-#include <iomanip>
 
 #ifdef FO_HAVE_BLAKE3
 
 namespace fo::providers::blake3 {
     struct Blake3Hasher::Impl {
         blake3_hasher hasher;
+        fo::core::FileReader reader;
     };
 
     Blake3Hasher::Blake3Hasher() : impl_(std::make_unique<Impl>()) {
@@ -26,27 +26,22 @@ namespace fo::providers::blake3 {
     std::optional<std::string> Blake3Hasher::strong(const std::filesystem::path& p) {
         // Implementation of strong hash
         // Using BLAKE3 to hash the file content
-         std::ifstream file(p, std::ios::binary);
-        if (!file) return std::nullopt;
+        auto& reader = impl_->reader;
+        if (!reader.open(p, fo::core::FileReader::Access::Sequential)) return std::nullopt;
 
         blake3_hasher hasher;
         blake3_hasher_init(&hasher);
 
-        char buffer[8192];
-        while (file.read(buffer, sizeof(buffer)) || file.gcount() > 0) {
-            blake3_hasher_update(&hasher, buffer, file.gcount());
-            if (file.eof()) break;
-        }
+        const bool ok = reader.for_each_block([&](std::span<const std::uint8_t> block) {
+            blake3_hasher_update(&hasher, block.data(), block.size());
+        });
+        reader.close();
+        if (!ok) return std::nullopt;
 
         uint8_t output[BLAKE3_OUT_LEN];
         blake3_hasher_finalize(&hasher, output, BLAKE3_OUT_LEN);
 
-        std::stringstream ss;
-        ss << std::hex << std::setfill('0');
-        for (int i = 0; i < BLAKE3_OUT_LEN; ++i) {
-            ss << std::setw(2) << static_cast<int>(output[i]);
-        }
-        return ss.str();
+        return fo::core::HashDigest::from_bytes(output, BLAKE3_OUT_LEN)->to_hex();
     }
 
     std::string Blake3Hasher::strong_algo() const {
@@ -1,7 +1,6 @@
 #include "fo/providers/dhash.hpp"
 
 #include <vector>
-#include <fstream>
 #include <sstream>
 #include <iomanip>
 
@@ -18,28 +17,24 @@ namespace fo::providers {
     }
 
     std::string DHash::fast64(const std::filesystem::path& p) {
-        std::ifstream file(p, std::ios::binary);
-        if (!file) {
+        // Decode straight from the mapped (or read) file contents
+        if (!reader_.open(p, fo::core::FileReader::Access::Sequential)) {
             return "";
         }
-
-        // Read the file into a buffer
-        file.seekg(0, std::ios::end);
-        std::vector<char> buffer(file.tellg());
-        file.seekg(0, std::ios::beg);
-        file.read(buffer.data(), buffer.size());
+        auto buffer = reader_.read(0, static_cast<std::size_t>(reader_.size()));
 
         // Load the image
         int width, height, channels;
         unsigned char* data = stbi_load_from_memory(
-            reinterpret_cast<const stbi_uc*>(buffer.data()),
-            buffer.size(),
+            buffer.data(),
+            static_cast<int>(buffer.size()),
             &width,
             &height,
             &channels,
             1 // Force grayscale
         );
 
+        reader_.close();
         if (!data) {
             return "";
         }
@@ -17,10 +17,23 @@ namespace fo::core {
         register_scanner_win32();
 #endif
         register_scanner_dirent();
+#ifdef __linux__
+        register_scanner_linux();
+        register_scanner_uring();
+#endif
+        register_scanner_parallel();
         register_hasher_fast64();
         register_hasher_sha256();
         register_hasher_xxhash();
         register_hasher_blake3();
+#ifdef _WIN32
+        register_sidecar_ads();
+#endif
+#ifdef __linux__
+        register_sidecar_xattr();
+#endif
+        register_finder_size_hash();
+        register_finder_multistage();
         register_metadata_tinyexif();
         register_linter_std(); // Added
         
@@ -0,0 +1,41 @@
+#include "fo/core/reader_pool.hpp"
+
+namespace fo::core {
+
+ReaderPool::Lease::~Lease() {
+    if (pool_) pool_->give_back(db_);
+}
+
+ReaderPool::ReaderPool(DatabaseManager& writer, std::size_t size)
+    : writer_(writer), size_(size == 0 ? 1 : size) {}
+
+ReaderPool::Lease ReaderPool::acquire() {
+    if (writer_.path() == ":memory:") return Lease(nullptr, &writer_);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (idle_.empty() && connections_.size() < size_) {
+        auto db = std::make_unique<DatabaseManager>();
+        db->open(writer_.path(), DatabaseManager::Access::ReadOnly);
+        connections_.push_back(std::move(db));
+        return Lease(this, connections_.back().get());
+    }
+    returned_.wait(lock, [&] { return !idle_.empty(); });
+    DatabaseManager* db = idle_.back();
+    idle_.pop_back();
+    return Lease(this, db);
+}
+
+std::size_t ReaderPool::open_count() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return connections_.size();
+}
+
+void ReaderPool::give_back(DatabaseManager* db) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        idle_.push_back(db);
+    }
+    returned_.notify_one();
+}
+
+} // namespace fo::core
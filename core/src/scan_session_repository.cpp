@@ -6,28 +6,30 @@ namespace fo::core {
 
 ScanSessionRepository::ScanSessionRepository(DatabaseManager& db) : db_(db) {}
 
-int64_t ScanSessionRepository::start_session() {
-    std::string sql = "INSERT INTO scan_sessions (start_time, status) VALUES (?, 'running') RETURNING id;";
-    sqlite3_stmt* stmt;
-    if (sqlite3_prepare_v2(db_.get_db(), sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) return 0;
+int64_t ScanSessionRepository::start_session(const std::string& roots, const std::string& filter, bool detect_moves) {
+    std::string sql = "INSERT INTO scan_sessions (start_time, status, roots, filter, detect_moves) VALUES (?, 'running', ?, ?, ?) RETURNING id;";
+    auto stmt = db_.prepare(sql);
+    if (!stmt) return 0;
     
     auto now = std::chrono::system_clock::now();
     int64_t ts = std::chrono::system_clock::to_time_t(now);
     
     sqlite3_bind_int64(stmt, 1, ts);
+    sqlite3_bind_text(stmt, 2, roots.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 3, filter.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_int(stmt, 4, detect_moves ? 1 : 0);
     
     int64_t id = 0;
     if (sqlite3_step(stmt) == SQLITE_ROW) {
         id = sqlite3_column_int64(stmt, 0);
     }
-    sqlite3_finalize(stmt);
     return id;
 }
 
 void ScanSessionRepository::end_session(int64_t id, const std::string& status, int scanned_count) {
     std::string sql = "UPDATE scan_sessions SET end_time = ?, status = ?, scanned_count = ?, duration_ms = ? WHERE id = ?;";
-    sqlite3_stmt* stmt;
-    if (sqlite3_prepare_v2(db_.get_db(), sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) return;
+    auto stmt = db_.prepare(sql);
+    if (!stmt) return;
     
     auto now = std::chrono::system_clock::now();
     int64_t ts = std::chrono::system_clock::to_time_t(now);
@@ -38,13 +40,12 @@ void ScanSessionRepository::end_session(int64_t id, const std::string& status, i
     // Let's query start_time first.
     int64_t start_time = 0;
     {
-        sqlite3_stmt* qstmt;
-        if (sqlite3_prepare_v2(db_.get_db(), "SELECT start_time FROM scan_sessions WHERE id = ?", -1, &qstmt, nullptr) == SQLITE_OK) {
+        auto qstmt = db_.prepare("SELECT start_time FROM scan_sessions WHERE id = ?");
+        if (qstmt) {
             sqlite3_bind_int64(qstmt, 1, id);
             if (sqlite3_step(qstmt) == SQLITE_ROW) {
                 start_time = sqlite3_column_int64(qstmt, 0);
             }
-            sqlite3_finalize(qstmt);
         }
     }
     
@@ -57,7 +58,78 @@ void ScanSessionRepository::end_session(int64_t id, const std::string& status, i
     sqlite3_bind_int64(stmt, 5, id);
     
     sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
+}
+
+std::optional<ScanSession> ScanSessionRepository::find_resumable(const std::string& roots, const std::string& filter) {
+    std::string sql = "SELECT id, start_time, status, scanned_count, detect_moves FROM scan_sessions "
+                      "WHERE roots = ? AND filter = ? ORDER BY id DESC LIMIT 1;";
+    auto stmt = db_.prepare(sql);
+    if (!stmt) return std::nullopt;
+
+    sqlite3_bind_text(stmt, 1, roots.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 2, filter.c_str(), -1, SQLITE_STATIC);
+
+    std::optional<ScanSession> result;
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        ScanSession s;
+        s.id = sqlite3_column_int64(stmt, 0);
+        s.start_time = sqlite3_column_int64(stmt, 1);
+        const char* status_c = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
+        if (status_c) s.status = status_c;
+        s.scanned_count = sqlite3_column_int(stmt, 3);
+        s.detect_moves = sqlite3_column_int(stmt, 4) != 0;
+        s.roots = roots;
+        s.filter = filter;
+        if (s.status != "completed") result = std::move(s);
+    }
+    return result;
+}
+
+void ScanSessionRepository::reopen_session(int64_t id) {
+    auto stmt = db_.prepare("UPDATE scan_sessions SET status = 'running', end_time = NULL WHERE id = ?;");
+    if (!stmt) return;
+    sqlite3_bind_int64(stmt, 1, id);
+    sqlite3_step(stmt);
+}
+
+void ScanSessionRepository::add_progress(int64_t session_id, int64_t dir_id, int64_t mtime_ns) {
+    std::string sql = "INSERT OR REPLACE INTO scan_progress (session_id, dir_id, mtime_ns) VALUES (?, ?, ?);";
+    auto stmt = db_.prepare(sql);
+    if (!stmt) {
+        throw std::runtime_error("Failed to prepare progress insert: " + std::string(sqlite3_errmsg(db_.get_db())));
+    }
+    sqlite3_bind_int64(stmt, 1, session_id);
+    sqlite3_bind_int64(stmt, 2, dir_id);
+    sqlite3_bind_int64(stmt, 3, mtime_ns);
+    if (sqlite3_step(stmt) != SQLITE_DONE) {
+        throw std::runtime_error("Failed to execute progress insert: " + std::string(sqlite3_errmsg(db_.get_db())));
+    }
+}
+
+std::vector<std::pair<std::filesystem::path, int64_t>> ScanSessionRepository::get_progress(int64_t session_id) {
+    std::vector<std::pair<std::filesystem::path, int64_t>> out;
+    std::string sql = "SELECT d.path, p.mtime_ns FROM scan_progress p JOIN directories d ON d.id = p.dir_id "
+                      "WHERE p.session_id = ?;";
+    auto stmt = db_.prepare(sql);
+    if (!stmt) return out;
+
+    sqlite3_bind_int64(stmt, 1, session_id);
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        const char* path_c = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+        if (!path_c) continue;
+        out.emplace_back(std::filesystem::u8path(path_c), sqlite3_column_int64(stmt, 1));
+    }
+    return out;
+}
+
+void ScanSessionRepository::clear_progress(const std::string& roots, const std::string& filter) {
+    std::string sql = "DELETE FROM scan_progress WHERE session_id IN "
+                      "(SELECT id FROM scan_sessions WHERE roots = ? AND filter = ?);";
+    auto stmt = db_.prepare(sql);
+    if (!stmt) return;
+    sqlite3_bind_text(stmt, 1, roots.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 2, filter.c_str(), -1, SQLITE_STATIC);
+    sqlite3_step(stmt);
 }
 
 } // namespace fo::core
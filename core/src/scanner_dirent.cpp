@@ -1,5 +1,6 @@
 #include "fo/core/interfaces.hpp"
 #include "fo/core/registry.hpp"
+#include "extension_filter.hpp"
 
 #include <string>
 #include <vector>
@@ -17,28 +18,14 @@ class DirentScanner : public IFileScanner {
 public:
     std::string name() const override { return "dirent"; }
 
-    std::vector<FileInfo> scan(const std::vector<std::filesystem::path>& roots,
-                               const std::vector<std::string>& include_exts,
-                               bool /*follow_symlinks*/) override {
+    void scan_batches(const std::vector<std::filesystem::path>& roots,
+                      const std::vector<std::string>& include_exts,
+                      bool /*follow_symlinks*/,
+                      const ScanBatchSink& sink) override {
         std::vector<FileInfo> out;
+        out.reserve(kScanBatchSize);
 
-        auto to_lower = [](std::string s){
-            std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c){ return static_cast<char>(std::tolower(c)); });
-            return s;
-        };
-        std::vector<std::string> norm_exts;
-        norm_exts.reserve(include_exts.size());
-        for (auto e : include_exts) {
-            if (!e.empty() && e[0] != '.') e = "." + e;
-            norm_exts.push_back(to_lower(e));
-        }
-        auto accept_ext = [&](const std::filesystem::path& p) {
-            if (norm_exts.empty()) return true;
-            auto ext = to_lower(p.extension().string());
-            if (ext.empty()) return false;
-            for (auto& e : norm_exts) if (ext == e) return true;
-            return false;
-        };
+        const ExtensionFilter ext_filter(include_exts);
 
         std::vector<std::filesystem::path> stack;
         for (auto& r : roots) {
@@ -46,16 +33,33 @@ public:
             stack.push_back(r);
         }
 
+        std::vector<std::filesystem::path> subdirs;
         while (!stack.empty()) {
             std::filesystem::path cur = stack.back();
             stack.pop_back();
 
+            std::filesystem::file_time_type dir_mtime{};
+            if (filter_) {
+                std::error_code ec;
+                dir_mtime = std::filesystem::last_write_time(cur, ec);
+                if (ec) continue;
+                subdirs.clear();
+                auto action = filter_->enter_directory(cur, dir_mtime, subdirs);
+                if (action == IScanDirectoryFilter::Action::Skip) continue;
+                if (action == IScanDirectoryFilter::Action::Reuse) {
+                    for (auto& s : subdirs) stack.push_back(std::move(s));
+                    continue;
+                }
+            }
+
             DIR* dir = opendir(cur.string().c_str());
             if (!dir) continue;
 
+            std::size_t entries = 0, files = 0;
             while (dirent* de = readdir(dir)) {
                 const char* name = de->d_name;
                 if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) continue;
+                ++entries;
                 std::filesystem::path p = cur / name;
 
                 struct stat stbuf{};
@@ -65,23 +69,34 @@ public:
                 if (is_dir) {
                     stack.push_back(p);
                 } else {
-                    if (!accept_ext(p)) continue;
+                    if (!ext_filter.accepts(p)) continue;
 
                     FileInfo fi;
                     fi.path = p;
                     fi.size = static_cast<std::uintmax_t>(stbuf.st_size);
+                    fi.dev = static_cast<std::uint64_t>(stbuf.st_dev);
+                    fi.ino = static_cast<std::uint64_t>(stbuf.st_ino);
+                    fi.nlink = static_cast<std::uint64_t>(stbuf.st_nlink);
 
                     // Use std::filesystem for consistent file_clock timestamp
                     std::error_code ec;
                     auto ft = std::filesystem::last_write_time(p, ec);
                     if (!ec) fi.mtime = ft;
                     out.push_back(std::move(fi));
+                    ++files;
+                    if (out.size() >= kScanBatchSize) { sink(out); out.clear(); }
                 }
             }
             closedir(dir);
+            if (filter_) filter_->directory_done(cur, dir_mtime, entries, files);
         }
-        return out;
+        if (!out.empty()) sink(out);
     }
+
+    void set_directory_filter(IScanDirectoryFilter* filter) override { filter_ = filter; }
+
+private:
+    IScanDirectoryFilter* filter_ = nullptr;
 };
 
 // Static registration
@@ -0,0 +1,156 @@
+#ifdef __linux__
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/sysmacros.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+
+#include "fo/core/interfaces.hpp"
+#include "fo/core/registry.hpp"
+#include "linux_dirent.hpp"
+
+namespace fo::core {
+
+class LinuxScanner : public IFileScanner {
+public:
+    std::string name() const override { return "linux"; }
+
+    void scan_batches(const std::vector<std::filesystem::path>& roots,
+                      const std::vector<std::string>& include_exts,
+                      bool follow_symlinks,
+                      const ScanBatchSink& sink) override {
+        std::vector<FileInfo> out;
+        out.reserve(kScanBatchSize);
+
+        const DirentNameFilter name_filter(include_exts);
+
+        std::vector<std::string> stack;
+        for (auto& r : roots) {
+            if (!std::filesystem::exists(r)) continue;
+            stack.push_back(r.string());
+        }
+
+        std::vector<char> buf(kDirentBufferSize);
+        std::string child;
+        std::vector<std::filesystem::path> subdirs;
+
+        while (!stack.empty()) {
+            std::string cur = std::move(stack.back());
+            stack.pop_back();
+
+            std::chrono::file_clock::time_point dir_mtime{};
+            if (filter_) {
+                struct statx dstx{};
+                if (statx(AT_FDCWD, cur.c_str(), AT_NO_AUTOMOUNT, STATX_MTIME, &dstx) != 0) continue;
+                dir_mtime = from_statx_time(dstx.stx_mtime);
+                subdirs.clear();
+                auto action = filter_->enter_directory(cur, dir_mtime, subdirs);
+                if (action == IScanDirectoryFilter::Action::Skip) continue;
+                if (action == IScanDirectoryFilter::Action::Reuse) {
+                    for (auto& s : subdirs) stack.push_back(s.string());
+                    continue;
+                }
+            }
+
+            int dfd = open(cur.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+            if (dfd < 0) continue; // skip unreadable folders
+
+            std::size_t entries = 0, files = 0;
+
+            const bool needs_sep = !cur.empty() && cur.back() != '/';
+            for (;;) {
+                long nread = syscall(SYS_getdents64, dfd, buf.data(), buf.size());
+                if (nread <= 0) break;
+
+                for (long off = 0; off < nread;) {
+                    auto* de = reinterpret_cast<linux_dirent64*>(buf.data() + off);
+                    off += de->d_reclen;
+
+                    const char* name = reinterpret_cast<const char*>(de) + kDirentNameOffset;
+                    if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) continue;
+                    ++entries;
+                    size_t name_len = std::strlen(name);
+
+                    unsigned char type = de->d_type;
+                    if (type == DT_DIR) {
+                        child.assign(cur);
+                        if (needs_sep) child.push_back('/');
+                        child.append(name, name_len);
+                        stack.push_back(child);
+                        continue;
+                    }
+                    if (type != DT_REG && type != DT_LNK && type != DT_UNKNOWN) continue;
+                    // Directories hidden behind DT_LNK/DT_UNKNOWN must still reach statx
+                    bool may_be_dir = type != DT_REG;
+                    if (!may_be_dir && !name_filter.accepts(name, name_len)) continue;
+
+                    // One statx per candidate, relative to the open directory, asking
+                    // only for what FileInfo needs. Symlinks are resolved like std's
+                    // is_regular_file(); fs::recursive_directory_iterator semantics for dirs.
+                    unsigned mask = STATX_SIZE | STATX_MTIME | STATX_INO | STATX_NLINK | (may_be_dir ? STATX_TYPE : 0u);
+                    int flags = AT_NO_AUTOMOUNT | (type == DT_LNK ? 0 : AT_SYMLINK_NOFOLLOW);
+                    struct statx stx{};
+                    if (statx(dfd, name, flags, mask, &stx) != 0) continue;
+
+                    if (may_be_dir) {
+                        if (S_ISDIR(stx.stx_mode)) {
+                            if (type == DT_LNK && !follow_symlinks) continue;
+                            child.assign(cur);
+                            if (needs_sep) child.push_back('/');
+                            child.append(name, name_len);
+                            stack.push_back(child);
+                            continue;
+                        }
+                        if (!S_ISREG(stx.stx_mode)) continue;
+                        if (!name_filter.accepts(name, name_len)) continue;
+                    }
+
+                    FileInfo fi;
+                    child.assign(cur);
+                    if (needs_sep) child.push_back('/');
+                    child.append(name, name_len);
+                    fi.path = child;
+                    fi.size = static_cast<std::uintmax_t>(stx.stx_size);
+                    fi.mtime = from_statx_time(stx.stx_mtime);
+                    fi.dev = makedev(stx.stx_dev_major, stx.stx_dev_minor);
+                    fi.ino = stx.stx_ino;
+                    fi.nlink = stx.stx_nlink;
+                    out.push_back(std::move(fi));
+                    ++files;
+                    if (out.size() >= kScanBatchSize) { sink(out); out.clear(); }
+                }
+            }
+            close(dfd);
+            if (filter_) filter_->directory_done(cur, dir_mtime, entries, files);
+        }
+        if (!out.empty()) sink(out);
+    }
+
+    void set_directory_filter(IScanDirectoryFilter* filter) override { filter_ = filter; }
+
+private:
+    IScanDirectoryFilter* filter_ = nullptr;
+
+    // Large reads amortise the getdents64 syscall over many entries
+    static constexpr size_t kDirentBufferSize = 256 * 1024;
+};
+
+// Static registration
+static bool reg_scanner_linux = [](){
+    Registry<IFileScanner>::instance().add("linux", [](){ return std::make_unique<LinuxScanner>(); });
+    return true;
+}();
+
+void register_scanner_linux() { (void)reg_scanner_linux; }
+
+} // namespace fo::core
+
+#endif // __linux__
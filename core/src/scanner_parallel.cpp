@@ -0,0 +1,212 @@
+#include "fo/core/interfaces.hpp"
+#include "fo/core/registry.hpp"
+#include "extension_filter.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <system_error>
+
+namespace fo::core {
+
+// Multi-threaded directory walker. Each worker owns a deque of pending
+// directories: it pushes/pops at the back (depth-first, cache-warm) and idle
+// workers steal from the front of a victim's deque (oldest = largest subtrees).
+// Per-entry semantics mirror StdFsScanner so results are interchangeable.
+// Full batches go through a small bounded queue to the calling thread, which
+// runs the sink; workers stall while it is full, so a slow consumer keeps
+// memory bounded instead of letting results pile up.
+class ParallelScanner : public IFileScanner {
+public:
+    std::string name() const override { return "parallel"; }
+
+    void set_threads(unsigned threads) override { threads_ = threads; }
+    void set_directory_filter(IScanDirectoryFilter* filter) override { filter_ = filter; }
+
+    void scan_batches(const std::vector<std::filesystem::path>& roots,
+                      const std::vector<std::string>& include_exts,
+                      bool follow_symlinks,
+                      const ScanBatchSink& sink) override {
+        const ExtensionFilter ext_filter(include_exts);
+
+        unsigned n = threads_ ? threads_ : std::thread::hardware_concurrency();
+        if (n == 0) n = 1;
+
+        std::vector<Worker> workers(n);
+        std::atomic<std::size_t> pending{0};
+
+        // Seed roots round-robin so every worker starts with something to do
+        size_t next = 0;
+        for (auto& r : roots) {
+            if (!std::filesystem::exists(r)) continue;
+            pending.fetch_add(1, std::memory_order_relaxed);
+            workers[next++ % n].queue.push_back(r);
+        }
+
+        auto opts = std::filesystem::directory_options::skip_permission_denied;
+
+        // Hand-off between workers and the consuming (calling) thread
+        std::mutex ready_mtx;
+        std::condition_variable ready_cv;   // consumer: batch queued or worker finished
+        std::condition_variable space_cv;   // workers: queue drained below the limit
+        std::deque<std::vector<FileInfo>> ready;
+        unsigned running = n;
+        const size_t max_ready = 2 * static_cast<size_t>(n);
+
+        auto publish = [&](std::vector<FileInfo>&& batch) {
+            std::unique_lock lk(ready_mtx);
+            space_cv.wait(lk, [&]{ return ready.size() < max_ready; });
+            ready.push_back(std::move(batch));
+            ready_cv.notify_one();
+        };
+
+        // The directory filter is not thread-safe; workers take turns calling it
+        std::mutex filter_mtx;
+
+        auto list_dir = [&](Worker& self, const std::filesystem::path& dir) {
+            std::error_code ec;
+            std::filesystem::file_time_type dir_mtime{};
+            if (filter_) {
+                dir_mtime = std::filesystem::last_write_time(dir, ec);
+                if (ec) return;
+                std::vector<std::filesystem::path> subdirs;
+                IScanDirectoryFilter::Action action;
+                {
+                    std::lock_guard lk(filter_mtx);
+                    action = filter_->enter_directory(dir, dir_mtime, subdirs);
+                }
+                if (action == IScanDirectoryFilter::Action::Skip) return;
+                if (action == IScanDirectoryFilter::Action::Reuse) {
+                    pending.fetch_add(subdirs.size(), std::memory_order_relaxed);
+                    std::lock_guard lk(self.mtx);
+                    for (auto& s : subdirs) self.queue.push_back(std::move(s));
+                    return;
+                }
+            }
+            std::filesystem::directory_iterator it(dir, opts, ec), end;
+            if (ec) return;
+            std::size_t entries = 0, files = 0;
+            for (; it != end; it.increment(ec)) {
+                if (ec) break;
+                ++entries;
+                const auto& de = *it;
+                std::error_code sec;
+                if (de.is_directory(sec)) {
+                    // Same recursion rule as recursive_directory_iterator
+                    if (!follow_symlinks && de.is_symlink(sec)) continue;
+                    pending.fetch_add(1, std::memory_order_relaxed);
+                    std::lock_guard lk(self.mtx);
+                    self.queue.push_back(de.path());
+                    continue;
+                }
+                if (!de.is_regular_file(sec)) continue;
+                if (!ext_filter.accepts(de.path())) continue;
+                FileInfo fi;
+                fi.path = de.path();
+                fi.size = de.file_size(sec);
+                std::filesystem::file_time_type ft = de.last_write_time(sec);
+                if (!sec) fi.mtime = ft;
+                self.out.push_back(std::move(fi));
+                ++files;
+                if (self.out.size() >= kScanBatchSize) {
+                    publish(std::move(self.out));
+                    self.out = {};
+                    self.out.reserve(kScanBatchSize);
+                }
+            }
+            if (filter_) {
+                std::lock_guard lk(filter_mtx);
+                filter_->directory_done(dir, dir_mtime, entries, files);
+            }
+        };
+
+        auto run = [&](unsigned id) {
+            Worker& self = workers[id];
+            unsigned idle_spins = 0;
+            while (true) {
+                std::filesystem::path dir;
+                bool got = false;
+                {
+                    std::lock_guard lk(self.mtx);
+                    if (!self.queue.empty()) {
+                        dir = std::move(self.queue.back());
+                        self.queue.pop_back();
+                        got = true;
+                    }
+                }
+                for (unsigned k = 1; !got && k < n; ++k) {
+                    Worker& victim = workers[(id + k) % n];
+                    std::lock_guard lk(victim.mtx);
+                    if (!victim.queue.empty()) {
+                        dir = std::move(victim.queue.front());
+                        victim.queue.pop_front();
+                        got = true;
+                    }
+                }
+                if (!got) {
+                    // Nothing queued anywhere; finished once no directory is in flight
+                    if (pending.load(std::memory_order_acquire) == 0) break;
+                    if (++idle_spins < 64) std::this_thread::yield();
+                    else std::this_thread::sleep_for(std::chrono::microseconds(50));
+                    continue;
+                }
+                idle_spins = 0;
+                list_dir(self, dir);
+                pending.fetch_sub(1, std::memory_order_acq_rel);
+            }
+            if (!self.out.empty()) publish(std::move(self.out));
+            std::lock_guard lk(ready_mtx);
+            --running;
+            ready_cv.notify_one();
+        };
+
+        std::vector<std::thread> pool;
+        pool.reserve(n);
+        for (unsigned i = 0; i < n; ++i) pool.emplace_back(run, i);
+
+        // Drain batches here so the sink never runs on a worker thread. If the
+        // sink throws, keep draining (discarding) so workers can finish.
+        std::exception_ptr error;
+        for (;;) {
+            std::vector<FileInfo> batch;
+            {
+                std::unique_lock lk(ready_mtx);
+                ready_cv.wait(lk, [&]{ return !ready.empty() || running == 0; });
+                if (ready.empty()) break;
+                batch = std::move(ready.front());
+                ready.pop_front();
+                space_cv.notify_one();
+            }
+            if (error) continue;
+            try { sink(batch); } catch (...) { error = std::current_exception(); }
+        }
+        for (auto& t : pool) t.join();
+        if (error) std::rethrow_exception(error);
+    }
+
+private:
+    struct Worker {
+        std::mutex mtx;
+        std::deque<std::filesystem::path> queue;
+        std::vector<FileInfo> out;
+    };
+
+    unsigned threads_ = 0; // 0 = hardware_concurrency
+    IScanDirectoryFilter* filter_ = nullptr;
+};
+
+// Static registration
+static bool reg_scanner_parallel = [](){
+    Registry<IFileScanner>::instance().add("parallel", [](){ return std::make_unique<ParallelScanner>(); });
+    return true;
+}();
+
+void register_scanner_parallel() { (void)reg_scanner_parallel; }
+
+} // namespace fo::core
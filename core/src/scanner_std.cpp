@@ -1,5 +1,6 @@
 #include "fo/core/interfaces.hpp"
 #include "fo/core/registry.hpp"
+#include "extension_filter.hpp"
 #include <filesystem>
 #include <algorithm>
 
@@ -9,30 +10,74 @@ class StdFsScanner : public IFileScanner {
 public:
     std::string name() const override { return "std"; }
 
-    std::vector<FileInfo> scan(const std::vector<std::filesystem::path>& roots,
-                               const std::vector<std::string>& include_exts,
-                               bool follow_symlinks) override {
+    void scan_batches(const std::vector<std::filesystem::path>& roots,
+                      const std::vector<std::string>& include_exts,
+                      bool follow_symlinks,
+                      const ScanBatchSink& sink) override {
         std::vector<FileInfo> out;
+        out.reserve(kScanBatchSize);
         auto opts = std::filesystem::directory_options::skip_permission_denied;
         if (follow_symlinks) opts |= std::filesystem::directory_options::follow_directory_symlink;
 
-        auto to_lower = [](std::string s){
-            std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c){ return static_cast<char>(std::tolower(c)); });
-            return s;
+        const ExtensionFilter ext_filter(include_exts);
+
+        auto emit = [&](const std::filesystem::directory_entry& de) {
+            std::error_code ec;
+            FileInfo fi;
+            fi.path = de.path();
+            fi.size = de.file_size(ec);
+            std::filesystem::file_time_type ft = de.last_write_time(ec);
+            if (!ec) fi.mtime = ft;
+            out.push_back(std::move(fi));
+            if (out.size() >= kScanBatchSize) { sink(out); out.clear(); }
         };
-        std::vector<std::string> norm_exts;
-        norm_exts.reserve(include_exts.size());
-        for (auto e : include_exts) {
-            if (!e.empty() && e[0] != '.') e = "." + e;
-            norm_exts.push_back(to_lower(e));
+
+        if (filter_) {
+            // Directory-at-a-time walk so the filter can skip whole directories;
+            // same recursion rules as recursive_directory_iterator below.
+            std::vector<std::filesystem::path> stack;
+            for (auto& r : roots) {
+                if (std::filesystem::exists(r)) stack.push_back(r);
+            }
+            std::vector<std::filesystem::path> subdirs;
+            while (!stack.empty()) {
+                std::filesystem::path cur = std::move(stack.back());
+                stack.pop_back();
+
+                std::error_code ec;
+                auto dir_mtime = std::filesystem::last_write_time(cur, ec);
+                if (ec) continue;
+                subdirs.clear();
+                auto action = filter_->enter_directory(cur, dir_mtime, subdirs);
+                if (action == IScanDirectoryFilter::Action::Skip) continue;
+                if (action == IScanDirectoryFilter::Action::Reuse) {
+                    for (auto& s : subdirs) stack.push_back(std::move(s));
+                    continue;
+                }
+
+                std::filesystem::directory_iterator it(cur, opts, ec), end;
+                if (ec) continue;
+                std::size_t entries = 0, files = 0;
+                for (; it != end; it.increment(ec)) {
+                    if (ec) break;
+                    ++entries;
+                    const auto& de = *it;
+                    std::error_code sec;
+                    if (de.is_directory(sec)) {
+                        if (!follow_symlinks && de.is_symlink(sec)) continue;
+                        stack.push_back(de.path());
+                        continue;
+                    }
+                    if (!de.is_regular_file(sec)) continue;
+                    if (!ext_filter.accepts(de.path())) continue;
+                    emit(de);
+                    ++files;
+                }
+                filter_->directory_done(cur, dir_mtime, entries, files);
+            }
+            if (!out.empty()) sink(out);
+            return;
         }
-        auto accept_ext = [&](const std::filesystem::path& p) {
-            if (norm_exts.empty()) return true;
-            auto ext = to_lower(p.extension().string());
-            if (ext.empty()) return false;
-            for (auto& e : norm_exts) if (ext == e) return true;
-            return false;
-        };
 
         for (auto& root : roots) {
             if (!std::filesystem::exists(root)) continue;
@@ -41,17 +86,17 @@ public:
                 std::filesystem::directory_entry de;
                 try { de = *it; ++it; } catch (...) { ++it; continue; }
                 if (!de.is_regular_file(ec)) continue;
-                if (!accept_ext(de.path())) continue;
-                FileInfo fi;
-                fi.path = de.path();
-                fi.size = de.file_size(ec);
-                std::filesystem::file_time_type ft = de.last_write_time(ec);
-                if (!ec) fi.mtime = ft;
-                out.push_back(std::move(fi));
+                if (!ext_filter.accepts(de.path())) continue;
+                emit(de);
             }
         }
-        return out;
+        if (!out.empty()) sink(out);
     }
+
+    void set_directory_filter(IScanDirectoryFilter* filter) override { filter_ = filter; }
+
+private:
+    IScanDirectoryFilter* filter_ = nullptr;
 };
 
 // Static registration
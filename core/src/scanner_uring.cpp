@@ -0,0 +1,225 @@
+#ifdef __linux__
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/sysmacros.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+
+#include "fo/core/interfaces.hpp"
+#include "fo/core/registry.hpp"
+#include "fo/core/uring_stat.hpp"
+#include "linux_dirent.hpp"
+
+namespace fo::core {
+
+// Same traversal rules as LinuxScanner, but directory opens and per-file
+// statx calls are handed to UringStatBatch in large batches instead of being
+// issued one at a time. Falls back to synchronous calls without io_uring.
+class UringScanner : public IFileScanner {
+public:
+    std::string name() const override { return "uring"; }
+
+    void scan_batches(const std::vector<std::filesystem::path>& roots,
+                      const std::vector<std::string>& include_exts,
+                      bool follow_symlinks,
+                      const ScanBatchSink& sink) override {
+        std::vector<FileInfo> out;
+        out.reserve(kScanBatchSize);
+
+        const DirentNameFilter name_filter(include_exts);
+
+        std::vector<std::string> stack;
+        for (auto& r : roots) {
+            if (!std::filesystem::exists(r)) continue;
+            stack.push_back(r.string());
+        }
+
+        UringStatBatch batch(kQueueDepth);
+        std::vector<char> buf(kDirentBufferSize);
+
+        std::vector<std::string> dirs;
+        std::vector<UringStatBatch::OpenOp> opens;
+
+        // Candidates waiting for statx; names live back to back in `names`
+        struct Candidate {
+            size_t dir;
+            size_t name_off;
+            size_t name_len;
+            unsigned char type;
+        };
+        std::vector<Candidate> cands;
+        std::string names;
+        std::vector<struct statx> stx;
+        std::vector<UringStatBatch::StatOp> stats;
+        // Per directory of the group: entries read (-1 if unreadable) and files emitted
+        std::vector<std::ptrdiff_t> dir_entries;
+        std::vector<std::size_t> dir_files;
+
+        auto join = [&](size_t dir, const char* name, size_t len) {
+            const std::string& base = dirs[dir];
+            std::string p;
+            p.reserve(base.size() + 1 + len);
+            p.assign(base);
+            if (!base.empty() && base.back() != '/') p.push_back('/');
+            p.append(name, len);
+            return p;
+        };
+
+        auto flush = [&]() {
+            if (cands.empty()) return;
+            stx.assign(cands.size(), {});
+            stats.resize(cands.size());
+            for (size_t i = 0; i < cands.size(); ++i) {
+                const Candidate& c = cands[i];
+                auto& op = stats[i];
+                op.dirfd = opens[c.dir].result;
+                op.path = names.data() + c.name_off;
+                // Symlinks are resolved like std's is_regular_file(); fs::recursive_directory_iterator semantics for dirs.
+                op.flags = AT_NO_AUTOMOUNT | (c.type == DT_LNK ? 0 : AT_SYMLINK_NOFOLLOW);
+                op.mask = STATX_SIZE | STATX_MTIME | STATX_INO | STATX_NLINK | (c.type != DT_REG ? STATX_TYPE : 0u);
+                op.out = &stx[i];
+            }
+            batch.stat_all(stats);
+
+            for (size_t i = 0; i < cands.size(); ++i) {
+                if (stats[i].result != 0) continue;
+                const Candidate& c = cands[i];
+                const char* name = names.data() + c.name_off;
+                const struct statx& st = stx[i];
+                if (c.type != DT_REG) {
+                    if (S_ISDIR(st.stx_mode)) {
+                        if (c.type == DT_LNK && !follow_symlinks) continue;
+                        stack.push_back(join(c.dir, name, c.name_len));
+                        continue;
+                    }
+                    if (!S_ISREG(st.stx_mode)) continue;
+                    if (!name_filter.accepts(name, c.name_len)) continue;
+                }
+                FileInfo fi;
+                fi.path = join(c.dir, name, c.name_len);
+                fi.size = static_cast<std::uintmax_t>(st.stx_size);
+                fi.mtime = from_statx_time(st.stx_mtime);
+                fi.dev = makedev(st.stx_dev_major, st.stx_dev_minor);
+                fi.ino = st.stx_ino;
+                fi.nlink = st.stx_nlink;
+                out.push_back(std::move(fi));
+                ++dir_files[c.dir];
+                if (out.size() >= kScanBatchSize) { sink(out); out.clear(); }
+            }
+            cands.clear();
+            names.clear();
+        };
+
+        std::vector<std::chrono::file_clock::time_point> dir_mtimes;
+        std::vector<std::filesystem::path> subdirs;
+
+        while (!stack.empty()) {
+            // Open the next group of directories in one submission
+            dirs.clear();
+            dir_mtimes.clear();
+            while (!stack.empty() && dirs.size() < kDirBatch) {
+                std::string cur = std::move(stack.back());
+                stack.pop_back();
+                std::chrono::file_clock::time_point dir_mtime{};
+                if (filter_) {
+                    struct statx dstx{};
+                    if (statx(AT_FDCWD, cur.c_str(), AT_NO_AUTOMOUNT, STATX_MTIME, &dstx) != 0) continue;
+                    dir_mtime = from_statx_time(dstx.stx_mtime);
+                    subdirs.clear();
+                    auto action = filter_->enter_directory(cur, dir_mtime, subdirs);
+                    if (action == IScanDirectoryFilter::Action::Skip) continue;
+                    if (action == IScanDirectoryFilter::Action::Reuse) {
+                        for (auto& s : subdirs) stack.push_back(s.string());
+                        continue;
+                    }
+                }
+                dirs.push_back(std::move(cur));
+                dir_mtimes.push_back(dir_mtime);
+            }
+            dir_entries.assign(dirs.size(), -1);
+            dir_files.assign(dirs.size(), 0);
+            opens.assign(dirs.size(), {});
+            for (size_t d = 0; d < dirs.size(); ++d) opens[d].path = dirs[d].c_str();
+            batch.open_all(opens);
+
+            for (size_t d = 0; d < dirs.size(); ++d) {
+                int dfd = opens[d].result;
+                if (dfd < 0) continue; // skip unreadable folders
+
+                std::size_t entries = 0;
+                for (;;) {
+                    long nread = syscall(SYS_getdents64, dfd, buf.data(), buf.size());
+                    if (nread <= 0) break;
+
+                    for (long off = 0; off < nread;) {
+                        auto* de = reinterpret_cast<linux_dirent64*>(buf.data() + off);
+                        off += de->d_reclen;
+
+                        const char* name = reinterpret_cast<const char*>(de) + kDirentNameOffset;
+                        if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) continue;
+                        ++entries;
+                        size_t name_len = std::strlen(name);
+
+                        unsigned char type = de->d_type;
+                        if (type == DT_DIR) {
+                            stack.push_back(join(d, name, name_len));
+                            continue;
+                        }
+                        if (type != DT_REG && type != DT_LNK && type != DT_UNKNOWN) continue;
+                        if (type == DT_REG && !name_filter.accepts(name, name_len)) continue;
+
+                        cands.push_back({d, names.size(), name_len, type});
+                        names.append(name, name_len);
+                        names.push_back('\0');
+                    }
+                    // Bound memory on huge directories; fds of this group stay open until the group is done
+                    if (cands.size() >= kStatBatch) flush();
+                }
+                dir_entries[d] = static_cast<std::ptrdiff_t>(entries);
+            }
+            flush();
+            // Only now are the file counts final
+            if (filter_) {
+                for (size_t d = 0; d < dirs.size(); ++d) {
+                    if (dir_entries[d] < 0) continue;
+                    filter_->directory_done(dirs[d], dir_mtimes[d], static_cast<std::size_t>(dir_entries[d]), dir_files[d]);
+                }
+            }
+
+            for (auto& op : opens) {
+                if (op.result >= 0) close(op.result);
+            }
+        }
+        if (!out.empty()) sink(out);
+    }
+
+    void set_directory_filter(IScanDirectoryFilter* filter) override { filter_ = filter; }
+
+private:
+    IScanDirectoryFilter* filter_ = nullptr;
+
+    static constexpr unsigned kQueueDepth = 256;      // ops in flight per ring
+    static constexpr size_t kDirBatch = 64;           // directories opened per submission
+    static constexpr size_t kStatBatch = 8192;        // statx candidates per flush
+    static constexpr size_t kDirentBufferSize = 256 * 1024;
+};
+
+// Static registration
+static bool reg_scanner_uring = [](){
+    Registry<IFileScanner>::instance().add("uring", [](){ return std::make_unique<UringScanner>(); });
+    return true;
+}();
+
+void register_scanner_uring() { (void)reg_scanner_uring; }
+
+} // namespace fo::core
+
+#endif // __linux__
@@ -8,6 +8,7 @@
 
 #include "fo/core/interfaces.hpp"
 #include "fo/core/registry.hpp"
+#include "extension_filter.hpp"
 
 namespace fo::core {
 
@@ -25,28 +26,14 @@ class Win32Scanner : public IFileScanner {
 public:
     std::string name() const override { return "win32"; }
 
-    std::vector<FileInfo> scan(const std::vector<std::filesystem::path>& roots,
-                               const std::vector<std::string>& include_exts,
-                               bool /*follow_symlinks*/) override {
+    void scan_batches(const std::vector<std::filesystem::path>& roots,
+                      const std::vector<std::string>& include_exts,
+                      bool /*follow_symlinks*/,
+                      const ScanBatchSink& sink) override {
         std::vector<FileInfo> out;
+        out.reserve(kScanBatchSize);
 
-        auto to_lower = [](std::string s){
-            std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c){ return static_cast<char>(std::tolower(c)); });
-            return s;
-        };
-        std::vector<std::string> norm_exts;
-        norm_exts.reserve(include_exts.size());
-        for (auto e : include_exts) {
-            if (!e.empty() && e[0] != '.') e = "." + e;
-            norm_exts.push_back(to_lower(e));
-        }
-        auto accept_ext = [&](const std::filesystem::path& p) {
-            if (norm_exts.empty()) return true;
-            auto ext = to_lower(p.extension().string());
-            if (ext.empty()) return false;
-            for (auto& e : norm_exts) if (ext == e) return true;
-            return false;
-        };
+        const ExtensionFilter ext_filter(include_exts);
 
         // Iterative DFS stack
         std::vector<std::filesystem::path> stack;
@@ -56,10 +43,25 @@ public:
         }
 
         WIN32_FIND_DATAW ffd;
+        std::vector<std::filesystem::path> subdirs;
         while (!stack.empty()) {
             std::filesystem::path cur = stack.back();
             stack.pop_back();
 
+            std::filesystem::file_time_type dir_mtime{};
+            if (filter_) {
+                std::error_code ec;
+                dir_mtime = std::filesystem::last_write_time(cur, ec);
+                if (ec) continue;
+                subdirs.clear();
+                auto action = filter_->enter_directory(cur, dir_mtime, subdirs);
+                if (action == IScanDirectoryFilter::Action::Skip) continue;
+                if (action == IScanDirectoryFilter::Action::Reuse) {
+                    for (auto& s : subdirs) stack.push_back(std::move(s));
+                    continue;
+                }
+            }
+
             std::wstring pattern = to_wstring(cur);
             if (!pattern.empty() && pattern.back() != L'\\' && pattern.back() != L'/') pattern += L"\\";
             pattern += L"*";
@@ -69,9 +71,11 @@ public:
                 continue; // skip unreadable folders
             }
 
+            std::size_t entries = 0, files = 0;
             do {
                 const wchar_t* name = ffd.cFileName;
                 if (name[0] == L'.' && (name[1] == 0 || (name[1] == L'.' && name[2] == 0))) continue; // . or ..
+                ++entries;
 
                 bool is_dir = (ffd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
                 std::filesystem::path p = join_path(cur, name);
@@ -79,7 +83,7 @@ public:
                 if (is_dir) {
                     stack.push_back(p);
                 } else {
-                    if (!accept_ext(p)) continue;
+                    if (!ext_filter.accepts(p)) continue;
 
                     FileInfo fi;
                     fi.path = p;
@@ -96,13 +100,21 @@ public:
                     fi.mtime = std::chrono::file_clock::time_point(std::chrono::file_clock::duration(date_val.QuadPart));
 
                     out.push_back(std::move(fi));
+                    ++files;
+                    if (out.size() >= kScanBatchSize) { sink(out); out.clear(); }
                 }
             } while (FindNextFileW(hFind, &ffd));
 
             FindClose(hFind);
+            if (filter_) filter_->directory_done(cur, dir_mtime, entries, files);
         }
-        return out;
+        if (!out.empty()) sink(out);
     }
+
+    void set_directory_filter(IScanDirectoryFilter* filter) override { filter_ = filter; }
+
+private:
+    IScanDirectoryFilter* filter_ = nullptr;
 };
 
 // Static registration
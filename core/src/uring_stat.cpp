@@ -0,0 +1,241 @@
+#ifdef __linux__
+#include "fo/core/uring_stat.hpp"
+
+#include <linux/io_uring.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+
+// glibc only exports the syscall numbers from 2.33 on; they are identical on
+// every architecture that has io_uring.
+#ifndef SYS_io_uring_setup
+#define SYS_io_uring_setup 425
+#endif
+#ifndef SYS_io_uring_enter
+#define SYS_io_uring_enter 426
+#endif
+#ifndef SYS_io_uring_register
+#define SYS_io_uring_register 427
+#endif
+
+namespace fo::core {
+
+namespace {
+
+// Marks ops whose completion has not been reaped yet
+constexpr int kPending = INT_MIN;
+
+int sync_open(const UringStatBatch::OpenOp& op) {
+    int fd = openat(op.dirfd, op.path, op.flags);
+    return fd < 0 ? -errno : fd;
+}
+
+int sync_stat(const UringStatBatch::StatOp& op) {
+    return statx(op.dirfd, op.path, op.flags, op.mask, op.out) == 0 ? 0 : -errno;
+}
+
+} // namespace
+
+// Minimal raw io_uring: one SQ/CQ pair mapped from the kernel, no liburing.
+struct UringStatBatch::Ring {
+    int fd = -1;
+    unsigned entries = 0;
+
+    void* sq_map = MAP_FAILED;
+    size_t sq_map_len = 0;
+    void* cq_map = MAP_FAILED;
+    size_t cq_map_len = 0;
+    io_uring_sqe* sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+    size_t sqes_len = 0;
+
+    unsigned* sq_head = nullptr;
+    unsigned* sq_tail = nullptr;
+    unsigned* sq_mask = nullptr;
+    unsigned* sq_array = nullptr;
+    unsigned* cq_head = nullptr;
+    unsigned* cq_tail = nullptr;
+    unsigned* cq_mask = nullptr;
+    io_uring_cqe* cqes = nullptr;
+
+    ~Ring() {
+        if (sqes != MAP_FAILED) munmap(sqes, sqes_len);
+        if (cq_map != MAP_FAILED && cq_map != sq_map) munmap(cq_map, cq_map_len);
+        if (sq_map != MAP_FAILED) munmap(sq_map, sq_map_len);
+        if (fd >= 0) close(fd);
+    }
+
+    static std::unique_ptr<Ring> create(unsigned depth) {
+        io_uring_params p{};
+        int fd = static_cast<int>(syscall(SYS_io_uring_setup, depth, &p));
+        if (fd < 0) return nullptr;
+
+        auto r = std::make_unique<Ring>();
+        r->fd = fd;
+        r->entries = p.sq_entries;
+        if (!r->supports(IORING_OP_STATX) || !r->supports(IORING_OP_OPENAT)) return nullptr;
+
+        r->sq_map_len = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+        r->cq_map_len = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+        const bool single = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (single) r->sq_map_len = r->cq_map_len = std::max(r->sq_map_len, r->cq_map_len);
+
+        r->sq_map = mmap(nullptr, r->sq_map_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+        if (r->sq_map == MAP_FAILED) return nullptr;
+        if (single) {
+            r->cq_map = r->sq_map;
+        } else {
+            r->cq_map = mmap(nullptr, r->cq_map_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+            if (r->cq_map == MAP_FAILED) return nullptr;
+        }
+        r->sqes_len = p.sq_entries * sizeof(io_uring_sqe);
+        r->sqes = static_cast<io_uring_sqe*>(
+            mmap(nullptr, r->sqes_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES));
+        if (r->sqes == MAP_FAILED) return nullptr;
+
+        auto* sq = static_cast<char*>(r->sq_map);
+        r->sq_head = reinterpret_cast<unsigned*>(sq + p.sq_off.head);
+        r->sq_tail = reinterpret_cast<unsigned*>(sq + p.sq_off.tail);
+        r->sq_mask = reinterpret_cast<unsigned*>(sq + p.sq_off.ring_mask);
+        r->sq_array = reinterpret_cast<unsigned*>(sq + p.sq_off.array);
+        auto* cq = static_cast<char*>(r->cq_map);
+        r->cq_head = reinterpret_cast<unsigned*>(cq + p.cq_off.head);
+        r->cq_tail = reinterpret_cast<unsigned*>(cq + p.cq_off.tail);
+        r->cq_mask = reinterpret_cast<unsigned*>(cq + p.cq_off.ring_mask);
+        r->cqes = reinterpret_cast<io_uring_cqe*>(cq + p.cq_off.cqes);
+
+        // SQE slot i is always published through array slot i
+        for (unsigned i = 0; i < r->entries; ++i) r->sq_array[i] = i;
+        return r;
+    }
+
+    bool supports(unsigned op) const {
+        constexpr unsigned kProbeOps = 256;
+        std::vector<unsigned char> buf(sizeof(io_uring_probe) + kProbeOps * sizeof(io_uring_probe_op));
+        auto* probe = reinterpret_cast<io_uring_probe*>(buf.data());
+        if (syscall(SYS_io_uring_register, fd, IORING_REGISTER_PROBE, probe, kProbeOps) < 0) return false;
+        if (op > probe->last_op) return false;
+        return (probe->ops[op].flags & IO_URING_OP_SUPPORTED) != 0;
+    }
+
+    // Pushes ops through the ring keeping at most `entries` in flight, which
+    // also guarantees the CQ (2x entries) can never overflow. Returns false on
+    // an unrecoverable ring error; by then every op the kernel had taken has
+    // completed and been reaped, and only ops it never saw are left at kPending.
+    template <typename Op, typename Prep>
+    bool run(std::vector<Op>& ops, Prep prep) {
+        const size_t n = ops.size();
+        size_t next = 0, inflight = 0, done = 0;
+        const unsigned mask = *sq_mask;
+        const unsigned cmask = *cq_mask;
+        for (auto& op : ops) op.result = kPending;
+
+        auto reap = [&] {
+            unsigned head = *cq_head;
+            unsigned ctail = __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE);
+            while (head != ctail) {
+                const io_uring_cqe& cqe = cqes[head & cmask];
+                ops[static_cast<size_t>(cqe.user_data)].result = cqe.res;
+                ++head;
+                --inflight;
+                ++done;
+            }
+            __atomic_store_n(cq_head, head, __ATOMIC_RELEASE);
+        };
+
+        while (done < n) {
+            unsigned tail = *sq_tail; // only we write the SQ tail
+            while (next < n && inflight < entries) {
+                io_uring_sqe* sqe = &sqes[tail & mask];
+                std::memset(sqe, 0, sizeof(*sqe));
+                prep(*sqe, ops[next]);
+                sqe->user_data = next;
+                ++tail;
+                ++next;
+                ++inflight;
+            }
+            __atomic_store_n(sq_tail, tail, __ATOMIC_RELEASE);
+
+            unsigned to_submit = tail - __atomic_load_n(sq_head, __ATOMIC_ACQUIRE);
+            long ret = syscall(SYS_io_uring_enter, fd, to_submit, 1u, IORING_ENTER_GETEVENTS, nullptr, 0);
+            if (ret < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+                drain(tail, inflight, reap);
+                return false;
+            }
+            reap();
+        }
+        return true;
+    }
+
+    // Withdraws the SQEs the kernel has not consumed and waits for the ones
+    // it has: closing the ring does not wait for them, so a late STATX would
+    // write into a freed buffer and a late OPENAT would leak its fd.
+    template <typename Reap>
+    void drain(unsigned tail, const size_t& inflight, Reap& reap) {
+        const unsigned head = __atomic_load_n(sq_head, __ATOMIC_ACQUIRE);
+        const size_t unsubmitted = tail - head;
+        __atomic_store_n(sq_tail, head, __ATOMIC_RELEASE);
+        for (reap(); inflight > unsubmitted; reap()) {
+            long ret = syscall(SYS_io_uring_enter, fd, 0u, 1u, IORING_ENTER_GETEVENTS, nullptr, 0);
+            // The kernel posts completions whether or not we can wait for
+            // them; if waiting fails, poll the CQ instead
+            if (ret < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY) sched_yield();
+        }
+    }
+};
+
+UringStatBatch::UringStatBatch(unsigned queue_depth, bool force_sync) {
+    if (!force_sync) ring_ = Ring::create(std::max(1u, queue_depth));
+}
+
+UringStatBatch::~UringStatBatch() = default;
+
+void UringStatBatch::open_all(std::vector<OpenOp>& ops) {
+    if (ring_) {
+        bool ok = ring_->run(ops, [](io_uring_sqe& sqe, const OpenOp& op) {
+            sqe.opcode = IORING_OP_OPENAT;
+            sqe.fd = op.dirfd;
+            sqe.addr = reinterpret_cast<std::uintptr_t>(op.path);
+            sqe.len = 0; // mode, unused without O_CREAT
+            sqe.open_flags = static_cast<__u32>(op.flags);
+        });
+        if (ok) return;
+        // Ring is broken and drained: drop it for good and finish the batch synchronously
+        ring_.reset();
+        for (auto& op : ops) {
+            if (op.result == kPending) op.result = sync_open(op);
+        }
+        return;
+    }
+    for (auto& op : ops) op.result = sync_open(op);
+}
+
+void UringStatBatch::stat_all(std::vector<StatOp>& ops) {
+    if (ring_) {
+        bool ok = ring_->run(ops, [](io_uring_sqe& sqe, const StatOp& op) {
+            sqe.opcode = IORING_OP_STATX;
+            sqe.fd = op.dirfd;
+            sqe.addr = reinterpret_cast<std::uintptr_t>(op.path);
+            sqe.len = op.mask;
+            sqe.off = reinterpret_cast<std::uintptr_t>(op.out);
+            sqe.statx_flags = static_cast<__u32>(op.flags);
+        });
+        if (ok) return;
+        ring_.reset();
+        for (auto& op : ops) {
+            if (op.result == kPending) op.result = sync_stat(op);
+        }
+        return;
+    }
+    for (auto& op : ops) op.result = sync_stat(op);
+}
+
+} // namespace fo::core
+
+#endif // __linux__
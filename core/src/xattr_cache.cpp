@@ -0,0 +1,177 @@
+#include "fo/core/xattr_cache.hpp"
+#include "fo/core/hash_digest.hpp"
+#include "fo/core/registry.hpp"
+
+#ifdef __linux__
+#include <sys/stat.h>
+#include <sys/xattr.h>
+#endif
+
+namespace fo::core {
+
+namespace {
+
+constexpr std::uint8_t kVersion = 1;
+constexpr std::uint8_t kDigest = 0;
+constexpr std::uint8_t kText = 1;
+
+struct Record {
+    int64_t mtime_ns = 0;
+    std::string_view algo;
+    std::uint8_t kind = kText;
+    std::string_view value;
+    std::string_view raw;   // the whole encoded record
+};
+
+// Calls fn for each complete record; stops at the first truncated one.
+template <typename Fn>
+void for_each_record(std::string_view attr, Fn&& fn) {
+    if (attr.empty() || static_cast<std::uint8_t>(attr[0]) != kVersion) return;
+    std::size_t pos = 1;
+    auto byte = [&](std::size_t at) { return static_cast<std::uint8_t>(attr[at]); };
+    while (pos + 9 <= attr.size()) {
+        const std::size_t start = pos;
+        Record r;
+        std::uint64_t t = 0;
+        for (int i = 7; i >= 0; --i) t = (t << 8) | byte(pos + static_cast<std::size_t>(i));
+        r.mtime_ns = static_cast<int64_t>(t);
+        pos += 8;
+        const std::size_t algo_len = byte(pos++);
+        if (pos + algo_len + 2 > attr.size()) return;
+        r.algo = attr.substr(pos, algo_len);
+        pos += algo_len;
+        r.kind = byte(pos++);
+        const std::size_t value_len = byte(pos++);
+        if (pos + value_len > attr.size()) return;
+        r.value = attr.substr(pos, value_len);
+        pos += value_len;
+        r.raw = attr.substr(start, pos - start);
+        fn(r);
+    }
+}
+
+#ifdef __linux__
+std::optional<int64_t> mtime_ns_of(const std::filesystem::path& path) {
+    struct stat st;
+    if (::stat(path.c_str(), &st) != 0) return std::nullopt;
+    return static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+}
+
+// Empty if the file has no attribute or xattrs are unavailable
+std::string read_attr(const std::filesystem::path& path) {
+    char buffer[4096];
+    const ssize_t n = ::getxattr(path.c_str(), XattrCache::ATTR_NAME, buffer, sizeof(buffer));
+    if (n <= 0) return {};
+    return std::string(buffer, static_cast<std::size_t>(n));
+}
+#endif
+
+} // namespace
+
+std::optional<std::string> XattrCache::decode(std::string_view attr, int64_t mtime_ns, const std::string& hash_type) {
+    std::optional<std::string> out;
+    for_each_record(attr, [&](const Record& r) {
+        if (out || r.mtime_ns != mtime_ns || r.algo != hash_type) return;
+        if (r.kind == kDigest) {
+            if (auto digest = HashDigest::from_bytes(r.value.data(), r.value.size())) out = digest->to_hex();
+        } else {
+            out = std::string(r.value);
+        }
+    });
+    return out;
+}
+
+std::string XattrCache::encode(std::string_view attr, int64_t mtime_ns,
+                               const std::string& hash_type, const std::string& hash_value) {
+    std::string out(1, static_cast<char>(kVersion));
+    for_each_record(attr, [&](const Record& r) {
+        if (r.mtime_ns == mtime_ns && r.algo != hash_type) out.append(r.raw);
+    });
+    if (hash_type.size() > 255) return out;
+
+    const auto digest = HashDigest::from_hex(hash_value);
+    std::string_view value = hash_value;
+    std::uint8_t kind = kText;
+    if (digest) {
+        value = std::string_view(reinterpret_cast<const char*>(digest->data()), digest->size());
+        kind = kDigest;
+    }
+    if (value.size() > 255) return out;
+
+    auto t = static_cast<std::uint64_t>(mtime_ns);
+    for (int i = 0; i < 8; ++i, t >>= 8) out.push_back(static_cast<char>(t & 0xff));
+    out.push_back(static_cast<char>(hash_type.size()));
+    out.append(hash_type);
+    out.push_back(static_cast<char>(kind));
+    out.push_back(static_cast<char>(value.size()));
+    out.append(value);
+    return out;
+}
+
+std::optional<std::string> XattrCache::get_hash(
+    const std::filesystem::path& path,
+    const std::string& hash_type) {
+#ifdef __linux__
+    const std::string attr = read_attr(path);
+    if (attr.empty()) return std::nullopt;
+    const auto mtime_ns = mtime_ns_of(path);
+    if (!mtime_ns) return std::nullopt;
+    return decode(attr, *mtime_ns, hash_type);
+#else
+    (void)path; (void)hash_type;
+    return std::nullopt;
+#endif
+}
+
+bool XattrCache::set_hash(
+    const std::filesystem::path& path,
+    const std::string& hash_type,
+    const std::string& hash_value) {
+#ifdef __linux__
+    const auto mtime_ns = mtime_ns_of(path);
+    if (!mtime_ns) return false;
+    const std::string attr = encode(read_attr(path), *mtime_ns, hash_type, hash_value);
+    if (!decode(attr, *mtime_ns, hash_type)) return false;   // too long to encode
+    // ENOTSUP, EROFS, EACCES, ENOSPC: leave the file as it is
+    return ::setxattr(path.c_str(), ATTR_NAME, attr.data(), attr.size(), 0) == 0;
+#else
+    (void)path; (void)hash_type; (void)hash_value;
+    return false;
+#endif
+}
+
+bool XattrCache::clear(const std::filesystem::path& path) {
+#ifdef __linux__
+    return ::removexattr(path.c_str(), ATTR_NAME) == 0;
+#else
+    (void)path;
+    return false;
+#endif
+}
+
+#ifdef __linux__
+namespace {
+
+class XattrSidecarCache : public ISidecarHashCache {
+public:
+    std::string name() const override { return "xattr"; }
+    std::optional<std::string> get_hash(const std::filesystem::path& p, const std::string& algo) override {
+        return XattrCache::get_hash(p, algo);
+    }
+    bool set_hash(const std::filesystem::path& p, const std::string& algo, const std::string& value) override {
+        return XattrCache::set_hash(p, algo, value);
+    }
+};
+
+} // namespace
+
+// Static registration
+static bool reg_sidecar_xattr = [](){
+    Registry<ISidecarHashCache>::instance().add("xattr", [](){ return std::make_unique<XattrSidecarCache>(); });
+    return true;
+}();
+
+void register_sidecar_xattr() { (void)reg_sidecar_xattr; }
+#endif // __linux__
+
+} // namespace fo::core
@@ -13,6 +13,7 @@
 #include <QDir>
 #include <chrono>
 #include <ctime>
+#include <iterator>
 
 MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent) {
     fo::core::register_all_providers();
@@ -45,7 +46,7 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent) {
     QHBoxLayout *optionsLayout = new QHBoxLayout();
     optionsLayout->addWidget(new QLabel("Scanner:", this));
     scannerCombo = new QComboBox(this);
-    scannerCombo->addItems({"std", "win32", "dirent"});
+    scannerCombo->addItems({"std", "win32", "dirent", "parallel", "linux", "uring"});
     optionsLayout->addWidget(scannerCombo);
 
     optionsLayout->addWidget(new QLabel("Hasher:", this));
@@ -169,6 +170,9 @@ void MainWindow::startScan() {
     log("Starting scan: " + dir);
     statusLabel->setText("Scanning...");
     scanBtn->setEnabled(false);
+    // Results stream in while events are pumped; block actions on a partial list
+    dupBtn->setEnabled(false);
+    exportBtn->setEnabled(false);
     progressBar->setVisible(true);
     progressBar->setRange(0, 0); // Indeterminate
 
@@ -176,25 +180,32 @@ void MainWindow::startScan() {
 
     try {
         std::vector<std::filesystem::path> roots = { dir.toStdString() };
-        scannedFiles = engine->scan(roots, {}, followSymlinks->isChecked(), false);
-
-        // Populate file table
-        fileTable->setRowCount(static_cast<int>(scannedFiles.size()));
-        for (size_t i = 0; i < scannedFiles.size(); ++i) {
-            const auto& f = scannedFiles[i];
-            fileTable->setItem(static_cast<int>(i), 0, new QTableWidgetItem(QString::fromStdString(f.path.string())));
-            fileTable->setItem(static_cast<int>(i), 1, new QTableWidgetItem(QString::fromStdString(fo::core::Exporter::format_size(f.size))));
-
-            auto sys_tp = std::chrono::clock_cast<std::chrono::system_clock>(f.mtime);
-            auto t = std::chrono::system_clock::to_time_t(sys_tp);
-            fileTable->setItem(static_cast<int>(i), 2, new QTableWidgetItem(QString::fromStdString(std::ctime(&t)).trimmed()));
-        }
+        scannedFiles.clear();
+        fileTable->setRowCount(0);
+        tabWidget->setCurrentIndex(0); // Switch to Files tab
+
+        // Populate file table batch by batch so results show up while the scan runs
+        engine->scan(roots, {}, followSymlinks->isChecked(), false, [&](std::vector<fo::core::FileInfo>& batch) {
+            int row = fileTable->rowCount();
+            fileTable->setRowCount(row + static_cast<int>(batch.size()));
+            for (const auto& f : batch) {
+                fileTable->setItem(row, 0, new QTableWidgetItem(QString::fromStdString(f.path.string())));
+                fileTable->setItem(row, 1, new QTableWidgetItem(QString::fromStdString(fo::core::Exporter::format_size(f.size))));
+
+                auto sys_tp = std::chrono::clock_cast<std::chrono::system_clock>(f.mtime);
+                auto t = std::chrono::system_clock::to_time_t(sys_tp);
+                fileTable->setItem(row, 2, new QTableWidgetItem(QString::fromStdString(std::ctime(&t)).trimmed()));
+                ++row;
+            }
+            std::move(batch.begin(), batch.end(), std::back_inserter(scannedFiles));
+            statusLabel->setText(QString("Scanning... %1 files").arg(scannedFiles.size()));
+            QApplication::processEvents();
+        });
 
         log(QString("Scan complete. Found %1 files.").arg(scannedFiles.size()));
         statusLabel->setText(QString("Found %1 files").arg(scannedFiles.size()));
         dupBtn->setEnabled(true);
         exportBtn->setEnabled(true);
-        tabWidget->setCurrentIndex(0); // Switch to Files tab
 
     } catch (const std::exception& e) {
         log(QString("Error: %1").arg(e.what()));
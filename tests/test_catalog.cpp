@@ -0,0 +1,188 @@
+#include <gtest/gtest.h>
+#include "fo/core/file_catalog.hpp"
+#include "fo/core/path_index.hpp"
+#include "fo/core/duplicate_finders.hpp"
+#include "fo/core/export.hpp"
+#include "fo/core/registry.hpp"
+#include "fo/core/provider_registration.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+using namespace fo::core;
+
+class CatalogTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        register_all_providers();
+        auto unique_id = std::to_string(std::chrono::steady_clock::now().time_since_epoch().count());
+        test_dir = std::filesystem::temp_directory_path() / ("fo_catalog_" + unique_id);
+        std::filesystem::create_directories(test_dir / "a" / "deep");
+        std::filesystem::create_directories(test_dir / "b");
+        std::ofstream(test_dir / "a" / "dup1.txt") << "same content";
+        std::ofstream(test_dir / "b" / "dup1.txt") << "same content";
+        std::ofstream(test_dir / "a" / "deep" / "dup2.txt") << "same content";
+        std::ofstream(test_dir / "b" / "other.txt") << "diff content";
+        std::ofstream(test_dir / "unique.bin") << "x";
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(test_dir);
+    }
+
+    std::filesystem::path test_dir;
+};
+
+TEST_F(CatalogTest, ScannerSinkRoundTripsPaths) {
+    auto scanner = Registry<IFileScanner>::instance().create("std");
+    auto files = scanner->scan({test_dir}, {}, false);
+
+    FileCatalog catalog;
+    scanner->scan_batches({test_dir}, {}, false, catalog.sink());
+    ASSERT_EQ(catalog.size(), files.size());
+
+    std::vector<std::string> expected, actual;
+    for (const auto& f : files) expected.push_back(f.path.string());
+    for (FileCatalog::Handle h = 0; h < catalog.size(); ++h) {
+        actual.push_back(catalog.path(h).string());
+        auto fi = catalog.to_file_info(h);
+        auto it = std::find_if(files.begin(), files.end(), [&](const FileInfo& f) { return f.path == fi.path; });
+        ASSERT_NE(it, files.end());
+        EXPECT_EQ(fi.size, it->size);
+        EXPECT_EQ(fi.mtime, it->mtime);
+    }
+    std::sort(expected.begin(), expected.end());
+    std::sort(actual.begin(), actual.end());
+    EXPECT_EQ(actual, expected);
+
+    // "dup1.txt" appears in two folders but is interned once
+    std::vector<const char*> dup1;
+    for (FileCatalog::Handle h = 0; h < catalog.size(); ++h) {
+        if (catalog.name(h) == "dup1.txt") dup1.push_back(catalog.name(h).data());
+    }
+    ASSERT_EQ(dup1.size(), 2u);
+    EXPECT_EQ(dup1[0], dup1[1]);
+}
+
+TEST_F(CatalogTest, MemoryPerFileIsCompact) {
+    FileCatalog catalog;
+    const size_t dirs = 2000, per_dir = 100;
+    for (size_t d = 0; d < dirs; ++d) {
+        std::filesystem::path dir = std::filesystem::path("/photos") / ("2024-" + std::to_string(d)) / "camera";
+        for (size_t i = 0; i < per_dir; ++i) {
+            FileInfo fi;
+            fi.path = dir / ("IMG_" + std::to_string(i) + ".JPG");
+            fi.size = d * per_dir + i;
+            catalog.add(fi);
+        }
+    }
+    ASSERT_EQ(catalog.size(), dirs * per_dir);
+    catalog.shrink_to_fit();
+    EXPECT_EQ(catalog.path_string(123), "/photos/2024-1/camera/IMG_23.JPG");
+    EXPECT_LE(catalog.memory_usage() / catalog.size(), 40u);
+}
+
+TEST_F(CatalogTest, GroupCatalogMatchesVectorGrouping) {
+    // A hardlinked pair: one physical file, reported once plus a link
+    std::filesystem::create_hard_link(test_dir / "a" / "dup1.txt", test_dir / "b" / "link.txt");
+    auto scanner = Registry<IFileScanner>::instance().create("std");
+    auto hasher = Registry<IHasher>::instance().create("fast64");
+    auto files = scanner->scan({test_dir}, {}, false);
+    FileCatalog catalog;
+    catalog.append(files);
+
+    SizeHashDuplicateFinder finder;
+    auto by_vector = finder.group(files, *hasher);
+    auto by_catalog = finder.group_catalog(catalog, *hasher);
+
+    ASSERT_EQ(by_catalog.size(), by_vector.size());
+    ASSERT_EQ(by_catalog.size(), 1u);
+    EXPECT_EQ(by_catalog[0].size, by_vector[0].size);
+    EXPECT_EQ(by_catalog[0].fast64, by_vector[0].fast64);
+    ASSERT_EQ(by_catalog[0].files.size(), 3u);
+    for (auto h : by_catalog[0].files) {
+        EXPECT_EQ(catalog.file_size(h), std::string("same content").size());
+    }
+    auto paths = [&](const std::vector<FileCatalog::Handle>& handles) {
+        std::vector<std::string> out;
+        for (auto h : handles) out.push_back(catalog.path_string(h));
+        std::sort(out.begin(), out.end());
+        return out;
+    };
+    auto vector_paths = [](const std::vector<FileInfo>& in) {
+        std::vector<std::string> out;
+        for (const auto& f : in) out.push_back(f.path.string());
+        std::sort(out.begin(), out.end());
+        return out;
+    };
+    EXPECT_EQ(paths(by_catalog[0].files), vector_paths(by_vector[0].files));
+    ASSERT_EQ(by_catalog[0].links.size(), 1u);
+    EXPECT_EQ(paths(by_catalog[0].links), vector_paths(by_vector[0].links));
+
+    std::ostringstream csv;
+    Exporter::duplicates_to_csv(csv, catalog, by_catalog);
+    EXPECT_NE(csv.str().find("dup2.txt"), std::string::npos);
+    auto stats = Exporter::compute_stats(catalog, by_catalog);
+    EXPECT_EQ(stats.total_files, files.size());
+    EXPECT_EQ(stats.duplicate_files, 3u);
+}
+
+TEST(PathIndexTest, ClassifiesScannedFiles) {
+    auto mtime = std::chrono::clock_cast<std::chrono::file_clock>(
+        std::chrono::system_clock::from_time_t(1700000000));
+    PathIndex index;
+    index.add("/data/a.txt", 1, 100, 1700000000000000000, 7, 0, 0, 0);
+    index.add("/data/b.txt", 2, 200, 1700000000000000000, 7, 2049, 55, 1);
+    // The same path twice stands in for two paths sharing a hash
+    index.add("/data/c.txt", 3, 300, 1700000000000000000, 7, 0, 0, 0);
+    index.add("/data/c.txt", 4, 300, 1700000000000000000, 7, 0, 0, 0);
+    EXPECT_EQ(index.size(), 3u);
+
+    FileInfo f;
+    f.path = "/data/a.txt";
+    f.size = 100;
+    f.mtime = mtime;
+    auto m = index.find(f, 7);
+    EXPECT_EQ(m.state, PathIndex::State::Unchanged);
+    EXPECT_EQ(m.id, 1);
+    EXPECT_EQ(index.find(f, 8).state, PathIndex::State::Changed);   // moved to another directory row
+    f.size = 101;
+    EXPECT_EQ(index.find(f, 7).state, PathIndex::State::Changed);
+    // A scanner that reads identity must write it where none is recorded
+    f.size = 100;
+    f.ino = 9;
+    EXPECT_EQ(index.find(f, 7).state, PathIndex::State::Changed);
+    // mtime is compared to the nanosecond
+    f.ino = 0;
+    f.mtime = mtime + std::chrono::milliseconds(500);
+    EXPECT_EQ(index.find(f, 7).state, PathIndex::State::Changed);
+
+    FileInfo b;
+    b.path = "/data/b.txt";
+    b.size = 200;
+    b.mtime = mtime;
+    EXPECT_EQ(index.find(b, 7).state, PathIndex::State::Unchanged);   // identity unknown to this scanner
+    b.dev = 2049;
+    b.ino = 55;
+    b.nlink = 1;
+    EXPECT_EQ(index.find(b, 7).state, PathIndex::State::Unchanged);
+    b.ino = 56;   // replaced under the same name
+    EXPECT_EQ(index.find(b, 7).state, PathIndex::State::Changed);
+
+    FileInfo c;
+    c.path = "/data/c.txt";
+    EXPECT_EQ(index.find(c, 7).state, PathIndex::State::Ambiguous);
+    c.path = "/data/d.txt";
+    EXPECT_EQ(index.find(c, 7).state, PathIndex::State::Absent);
+}
+
+TEST(PathIndexTest, MemoryPerFileIsCompact) {
+    PathIndex index;
+    const int n = 200000;
+    for (int i = 0; i < n; ++i) {
+        index.add("/photos/2024/IMG_" + std::to_string(i) + ".JPG", i + 1, 4096, 1700000000, 3, 0, 0, 0);
+    }
+    EXPECT_EQ(index.size(), static_cast<std::size_t>(n));
+    EXPECT_LE(index.memory_usage() / n, 64u);   // 24-byte slots, at most 80% full after the last doubling
+}
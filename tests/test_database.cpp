@@ -1,9 +1,17 @@
 #include <gtest/gtest.h>
+#include "fo/core/catalog_writer.hpp"
 #include "fo/core/database.hpp"
+#include "fo/core/duplicate_repository.hpp"
 #include "fo/core/file_repository.hpp"
+#include "fo/core/hash_digest.hpp"
 #include "fo/core/types.hpp"
+#include <sqlite3.h>
+#include <algorithm>
+#include <bit>
 #include <filesystem>
 #include <fstream>
+#include <random>
+#include <thread>
 
 using namespace fo::core;
 
@@ -77,6 +85,45 @@ TEST_F(DatabaseTest, QueryIntReturnsValue) {
     db.close();
 }
 
+TEST_F(DatabaseTest, PreparedStatementsAreReused) {
+    DatabaseManager db;
+    db.open(":memory:");
+    db.execute("CREATE TABLE t (v INTEGER);");
+
+    sqlite3_stmt* first = nullptr;
+    {
+        auto stmt = db.prepare("INSERT INTO t (v) VALUES (?);");
+        ASSERT_NE(stmt.get(), nullptr);
+        first = stmt.get();
+        sqlite3_bind_int(stmt, 1, 7);
+        EXPECT_EQ(sqlite3_step(stmt), SQLITE_DONE);
+    }
+    {
+        // Same text: the cached statement comes back reset, with bindings cleared
+        auto stmt = db.prepare("INSERT INTO t (v) VALUES (?);");
+        EXPECT_EQ(stmt.get(), first);
+        EXPECT_EQ(sqlite3_step(stmt), SQLITE_DONE);
+    }
+    EXPECT_EQ(db.query_int("SELECT COUNT(*) FROM t WHERE v IS NULL;"), 1);
+
+    // A nested borrower of the same text gets its own statement
+    auto outer = db.prepare("SELECT v FROM t;");
+    ASSERT_EQ(sqlite3_step(outer), SQLITE_ROW);
+    {
+        auto inner = db.prepare("SELECT v FROM t;");
+        ASSERT_NE(inner.get(), nullptr);
+        EXPECT_NE(inner.get(), outer.get());
+        EXPECT_EQ(sqlite3_step(inner), SQLITE_ROW);
+    }
+    EXPECT_EQ(sqlite3_column_int(outer, 0), 7);
+
+    EXPECT_EQ(db.prepare("NOT SQL").get(), nullptr);
+    EXPECT_EQ(db.cached_statement_count(), 3u);  // INSERT, SELECT v, query_int's COUNT
+
+    outer = Statement();
+    db.close();
+}
+
 class FileRepositoryTest : public ::testing::Test {
 protected:
     void SetUp() override {
@@ -149,6 +196,59 @@ TEST_F(FileRepositoryTest, UpsertExistingFileModified) {
     EXPECT_EQ(file.id, original_id);
 }
 
+TEST_F(FileRepositoryTest, UpsertBatchMatchesUpsert) {
+    FileInfo kept = create_test_file("kept.txt", 100);
+    FileInfo changed = create_test_file("changed.txt", 100);
+    repo->upsert(kept);
+    repo->upsert(changed);
+
+    std::vector<FileInfo> batch = {kept, changed, create_test_file("new.txt", 300)};
+    for (auto& f : batch) f.id = 0;
+    batch[1].size = 200;
+
+    // Without insert_new, files that are not catalogued yet are left out
+    auto results = repo->upsert_batch(batch, {}, false);
+    ASSERT_EQ(results.size(), 3u);
+    EXPECT_EQ(batch[0].id, kept.id);
+    EXPECT_FALSE(results[0].is_new);
+    EXPECT_FALSE(results[0].is_modified);
+    EXPECT_EQ(batch[1].id, changed.id);
+    EXPECT_TRUE(results[1].is_modified);
+    EXPECT_EQ(batch[2].id, 0);
+    EXPECT_FALSE(repo->get_by_path(test_dir / "new.txt").has_value());
+    EXPECT_EQ(repo->get_by_id(changed.id)->size, 200u);
+
+    results = repo->upsert_batch(batch, {0, 0, 0});
+    EXPECT_FALSE(results[1].is_modified);
+    EXPECT_TRUE(results[2].is_new);
+    ASSERT_NE(batch[2].id, 0);
+    auto stored = repo->get_by_path(test_dir / "new.txt");
+    ASSERT_TRUE(stored.has_value());
+    EXPECT_EQ(stored->id, batch[2].id);
+    EXPECT_EQ(stored->size, 300u);
+}
+
+TEST_F(FileRepositoryTest, SubtreeQueriesMatchWholeDirectories) {
+    FileInfo inside = create_test_file("photos/a.jpg");
+    FileInfo nested = create_test_file("photos/2024/b.jpg");
+    FileInfo sibling = create_test_file("photos-old/c.jpg");   // shares the prefix "photos"
+    FileInfo wildcard = create_test_file("p_otos/d.jpg");      // '_' was a LIKE wildcard
+    for (auto* f : {&inside, &nested, &sibling, &wildcard}) repo->upsert(*f);
+
+    const std::vector<std::filesystem::path> roots = {test_dir / "photos", test_dir / "photos" / "2024"};
+    auto missing = repo->get_missing_files(roots, {inside.id});
+    ASSERT_EQ(missing.size(), 1u);
+    EXPECT_EQ(missing[0].id, nested.id);
+    EXPECT_TRUE(repo->has_files_under({test_dir / "photos-old"}));
+    EXPECT_FALSE(repo->has_files_under({test_dir / "photo"}));
+
+    repo->prune_missing({inside.id}, roots);
+    EXPECT_TRUE(repo->get_by_id(inside.id).has_value());
+    EXPECT_FALSE(repo->get_by_id(nested.id).has_value());
+    EXPECT_TRUE(repo->get_by_id(sibling.id).has_value());
+    EXPECT_TRUE(repo->get_by_id(wildcard.id).has_value());
+}
+
 TEST_F(FileRepositoryTest, GetByPath) {
     FileInfo file = create_test_file("find_me.txt", 500);
     repo->upsert(file);
@@ -226,6 +326,145 @@ TEST_F(FileRepositoryTest, AddAndGetHash) {
     EXPECT_TRUE(found_fast);
 }
 
+TEST_F(FileRepositoryTest, HashesAreStoredInBinary) {
+    FileInfo a = create_test_file("a.bin");
+    FileInfo b = create_test_file("b.bin");
+    repo->upsert(a);
+    repo->upsert(b);
+
+    const std::string fast = "8000000000000001";   // top bit set: stored as a negative INTEGER
+    const std::string strong(64, 'e');
+    repo->add_hash(a.id, "fast64", fast);
+    repo->add_hash(b.id, "fast64", fast);
+    repo->add_hash(a.id, "blake3", strong);
+    repo->add_hash(a.id, "dhash", HashDigest::from_u64(0xF0F0));
+
+    EXPECT_EQ(db->query_int("SELECT COUNT(*) FROM file_hashes WHERE algo = 'fast64' AND typeof(value) = 'integer';"), 2);
+    EXPECT_EQ(db->query_int("SELECT length(value) FROM file_hashes WHERE algo = 'blake3' AND typeof(value) = 'blob';"), 32);
+
+    auto stored = repo->get_hash(a.id, "fast64");
+    ASSERT_TRUE(stored.has_value());
+    EXPECT_EQ(stored->to_hex(), fast);
+    EXPECT_EQ(repo->get_hash(a.id, "blake3")->to_hex(), strong);
+
+    auto ids = repo->find_by_hash("fast64", *HashDigest::from_hex(fast));
+    std::sort(ids.begin(), ids.end());
+    EXPECT_EQ(ids, (std::vector<int64_t>{a.id, b.id}));
+    EXPECT_TRUE(repo->find_by_hash("blake3", *HashDigest::from_hex(fast)).empty());
+    EXPECT_EQ(repo->find_similar_images(0xF0F1, 1), std::vector<int64_t>{a.id});
+}
+
+TEST_F(FileRepositoryTest, CachedHashNeedsMatchingToken) {
+    FileInfo file = create_test_file("cached.bin");
+    file.dev = 2049;
+    file.ino = 77;
+    file.nlink = 1;
+    repo->upsert(file);
+
+    // The catalog keeps the mtime to the nanosecond
+    auto stored = repo->get_by_id(file.id);
+    ASSERT_TRUE(stored.has_value());
+    const auto token = ChangeToken::of(file);
+    EXPECT_EQ(ChangeToken::of(*stored), token);
+
+    const std::string fast = "00000000deadbeef";
+    EXPECT_FALSE(repo->get_cached_hash(file.id, "fast64", token).has_value());
+    repo->add_hash(file.id, "fast64", fast, token);
+    EXPECT_EQ(repo->get_cached_hash(file.id, "fast64", token), fast);
+    EXPECT_FALSE(repo->get_cached_hash(file.id, "blake3", token).has_value());
+
+    // Any part of the token changing is a miss
+    auto hit = [&](ChangeToken changed) { return repo->get_cached_hash(file.id, "fast64", changed).has_value(); };
+    ChangeToken changed = token;
+    changed.dev += 1;
+    EXPECT_FALSE(hit(changed));
+    changed = token;
+    changed.ino += 1;
+    EXPECT_FALSE(hit(changed));
+    changed = token;
+    changed.size += 1;
+    EXPECT_FALSE(hit(changed));
+    changed = token;
+    changed.mtime_ns += 1;
+    EXPECT_FALSE(hit(changed));
+
+    // Hashes stored without a token are never served from the cache
+    repo->add_hash(file.id, "fast64", fast);
+    EXPECT_FALSE(repo->get_cached_hash(file.id, "fast64", token).has_value());
+    auto all = repo->get_hashes_by_algo("fast64");
+    ASSERT_EQ(all.size(), 1u);
+    EXPECT_FALSE(all[0].token.has_value());
+}
+
+TEST_F(FileRepositoryTest, MigrationConvertsTextHashes) {
+    FileInfo file = create_test_file("legacy.jpg");
+    repo->upsert(file);
+
+    // Recreate the version 7 table with values written as text
+    db->execute("DROP TABLE file_hashes;"
+                "CREATE TABLE file_hashes (file_id INTEGER NOT NULL, algo TEXT NOT NULL, value TEXT NOT NULL,"
+                " PRIMARY KEY (file_id, algo));"
+                "CREATE INDEX idx_hashes_value ON file_hashes(value);"
+                "ALTER TABLE files DROP COLUMN mtime_ns;"
+                "DELETE FROM schema_version WHERE version >= 8;");
+    const std::string id = std::to_string(file.id);
+    db->execute("INSERT INTO file_hashes VALUES (" + id + ", 'fast64', '00ff00ff00ff00ff'),"
+                " (" + id + ", 'sha256', 'abcdef0123456789abcdef0123456789'),"
+                " (" + id + ", 'dhash', '61680'),"
+                " (" + id + ", 'custom', 'not hex');");
+    db->migrate();
+
+    EXPECT_EQ(repo->get_hash(file.id, "fast64")->to_hex(), "00ff00ff00ff00ff");
+    EXPECT_EQ(repo->get_hash(file.id, "sha256")->to_hex(), "abcdef0123456789abcdef0123456789");
+    EXPECT_EQ(repo->get_hash(file.id, "dhash")->as_u64(), 61680u);
+    EXPECT_FALSE(repo->get_hash(file.id, "custom").has_value());
+    EXPECT_EQ(repo->get_hashes(file.id).size(), 4u);
+    EXPECT_EQ(db->query_int("SELECT COUNT(*) FROM sqlite_master WHERE name = 'idx_hashes_value';"), 0);
+}
+
+TEST_F(FileRepositoryTest, SimilarSearchMatchesBruteForce) {
+    // Hashes clustered around a few centres, so every radius has matches
+    std::mt19937_64 rng(42);
+    const uint64_t centres[] = {rng(), rng(), rng()};
+    std::vector<std::pair<int64_t, uint64_t>> stored;
+    for (int i = 0; i < 600; ++i) {
+        FileInfo f = create_test_file("img" + std::to_string(i) + ".jpg");
+        repo->upsert(f);
+        uint64_t h = centres[i % 3];
+        for (int flips = static_cast<int>(rng() % 24); flips > 0; --flips) h ^= 1ULL << (rng() % 64);
+        repo->add_hash(f.id, "dhash", HashDigest::from_u64(h));
+        stored.emplace_back(f.id, h);
+    }
+    EXPECT_EQ(db->query_int("SELECT COUNT(*) FROM phash_bands;"), 4 * 600);
+
+    for (int threshold : {0, 3, 7, 10, 15, 20}) {
+        std::vector<int64_t> expected;
+        for (const auto& [id, h] : stored) {
+            if (std::popcount(h ^ centres[1]) <= threshold) expected.push_back(id);
+        }
+        auto found = repo->find_similar(centres[1], threshold);
+        std::vector<int64_t> ids;
+        for (size_t i = 0; i < found.size(); ++i) {
+            ids.push_back(found[i].file.id);
+            EXPECT_FALSE(found[i].file.path.empty());
+            if (i > 0) { EXPECT_LE(found[i - 1].distance, found[i].distance); }
+        }
+        std::sort(ids.begin(), ids.end());
+        EXPECT_EQ(ids, expected) << "threshold " << threshold;
+    }
+
+    // The band index follows updates and deletes
+    const auto [first_id, first_hash] = stored[0];
+    repo->add_hash(first_id, "dhash", HashDigest::from_u64(~first_hash));
+    EXPECT_EQ(db->query_int("SELECT COUNT(*) FROM phash_bands;"), 4 * 600);
+    auto moved = repo->find_similar(~first_hash, 0);
+    ASSERT_FALSE(moved.empty());
+    EXPECT_EQ(moved[0].file.id, first_id);
+    repo->delete_files({first_id});
+    EXPECT_EQ(db->query_int("SELECT COUNT(*) FROM phash_bands;"), 4 * 599);
+    EXPECT_TRUE(repo->find_similar(~first_hash, 0).empty());
+}
+
 TEST_F(FileRepositoryTest, AddAndGetTags) {
     FileInfo file = create_test_file("tagged.txt");
     repo->upsert(file);
@@ -277,3 +516,115 @@ TEST_F(FileRepositoryTest, DirectoryFlag) {
     ASSERT_TRUE(found.has_value());
     EXPECT_TRUE(found->is_dir);
 }
+
+TEST_F(FileRepositoryTest, CatalogWriterAppliesConcurrentWrites) {
+    std::vector<int64_t> ids;
+    for (int i = 0; i < 50; ++i) {
+        FileInfo f = create_test_file("w" + std::to_string(i) + ".txt");
+        repo->upsert(f);
+        ids.push_back(f.id);
+    }
+
+    CatalogWriterOptions options;
+    options.batch_rows = 300;
+    options.queue_capacity = 64;   // small, so producers hit back-pressure
+    CatalogWriter writer(*db, options);
+
+    const int kProducers = 4;
+    std::vector<std::thread> producers;
+    for (int p = 0; p < kProducers; ++p) {
+        producers.emplace_back([&, p] {
+            for (std::size_t i = 0; i < ids.size(); ++i) {
+                writer.add_hash(ids[i], "algo" + std::to_string(p), to_hex64(i));
+                writer.add_tag(ids[i], "tag" + std::to_string(p), 0.5, "ai");
+            }
+        });
+    }
+    for (auto& t : producers) t.join();
+
+    OperationRecord op;
+    op.timestamp = std::chrono::system_clock::now();
+    op.type = OperationType::Move;
+    op.source_path = "/a";
+    op.dest_path = "/b";
+    writer.log_operation(op);
+    writer.add_hash(999999, "fast64", "00");   // no such file: rejected by the foreign key
+    writer.flush();
+
+    const int writes = kProducers * 50 * 2 + 1;
+    EXPECT_EQ(writer.committed(), static_cast<std::uint64_t>(writes));
+    EXPECT_EQ(writer.failed(), 1u);
+    EXPECT_FALSE(writer.last_error().empty());
+    EXPECT_EQ(db->query_int("SELECT COUNT(*) FROM file_hashes;"), kProducers * 50);
+    EXPECT_EQ(db->query_int("SELECT COUNT(*) FROM file_tags;"), kProducers * 50);
+    EXPECT_EQ(db->query_int("SELECT COUNT(*) FROM operation_log;"), 1);
+    EXPECT_EQ(repo->get_hash(ids[7], "algo2")->to_hex(), to_hex64(7));
+}
+
+TEST_F(FileRepositoryTest, CatalogWriterCommitsOnIntervalAndClose) {
+    FileInfo f = create_test_file("late.txt");
+    repo->upsert(f);
+    {
+        CatalogWriterOptions options;
+        options.commit_interval = std::chrono::milliseconds(20);
+        CatalogWriter writer(*db, options);
+        writer.add_hash(f.id, "fast64", "0123456789abcdef");
+        // No flush: the interval alone closes the transaction
+        for (int i = 0; i < 200 && writer.committed() == 0; ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        EXPECT_EQ(writer.committed(), 1u);
+        writer.add_hash(f.id, "sha256", std::string(64, 'a'));
+    }
+    // The destructor applied the last write
+    EXPECT_EQ(repo->get_hashes(f.id).size(), 2u);
+}
+
+TEST_F(FileRepositoryTest, DuplicateGroupsStreamWithFileRows) {
+    std::vector<int64_t> ids;
+    for (int i = 0; i < 7; ++i) {
+        FileInfo f = create_test_file("dup" + std::to_string(i) + ".bin", 10 + i);
+        repo->upsert(f);
+        ids.push_back(f.id);
+    }
+
+    DuplicateRepository dups(*db);
+    db->execute("BEGIN TRANSACTION;");
+    // Primaries need not have the lowest id
+    auto gids = dups.create_groups({{ids[2], ids[0], ids[1]}, {ids[3], ids[4]}, {ids[6], ids[5]}});
+    db->execute("COMMIT;");
+    ASSERT_EQ(gids.size(), 3u);
+
+    std::vector<DuplicateGroupFiles> seen;
+    auto count = dups.for_each_group([&](DuplicateGroupFiles& g) {
+        seen.push_back(g);
+        return true;
+    });
+    ASSERT_EQ(count, 3u);
+    ASSERT_EQ(seen.size(), 3u);
+    EXPECT_EQ(seen[0].id, gids[0]);
+    ASSERT_EQ(seen[0].files.size(), 3u);
+    EXPECT_EQ(seen[0].files[0].id, ids[2]);
+    EXPECT_EQ(seen[0].files[1].id, ids[0]);
+    EXPECT_EQ(seen[0].files[2].id, ids[1]);
+    EXPECT_EQ(seen[0].files[0].path, test_dir / "dup2.bin");
+    EXPECT_EQ(seen[0].files[0].size, 12u);
+    EXPECT_EQ(seen[2].files[0].id, ids[6]);
+    EXPECT_EQ(seen[2].files[1].id, ids[5]);
+
+    // The sink can stop the walk
+    count = dups.for_each_group([](DuplicateGroupFiles&) { return false; });
+    EXPECT_EQ(count, 1u);
+
+    auto groups = dups.get_all_groups();
+    ASSERT_EQ(groups.size(), 3u);
+    EXPECT_EQ(groups[1].primary_file_id, ids[3]);
+    EXPECT_EQ(groups[1].member_ids, (std::vector<int64_t>{ids[3], ids[4]}));
+
+    // Members that disappear from the catalog disappear from their group
+    repo->delete_files({ids[4]});
+    dups.remove_files({ids[4]});
+    count = dups.for_each_group([](DuplicateGroupFiles& g) { return g.files.size() >= 2; });
+    EXPECT_EQ(count, 2u);
+    EXPECT_EQ(dups.get_all_groups().size(), 2u);
+}
@@ -1,9 +1,16 @@
 #include <gtest/gtest.h>
 #include "fo/core/registry.hpp"
 #include "fo/core/interfaces.hpp"
+#include "fo/core/file_reader.hpp"
+#include "fo/core/hash_executor.hpp"
 #include "fo/core/provider_registration.hpp"
+#include "fo/core/xattr_cache.hpp"
+#include <atomic>
 #include <fstream>
 #include <filesystem>
+#include <mutex>
+#include <set>
+#include <thread>
 
 using namespace fo::core;
 
@@ -105,3 +112,120 @@ TEST_F(HasherTest, ListAvailableHashers) {
     EXPECT_TRUE(has_fast64);
 }
 
+
+TEST(FileReaderTest, MappedAndReadPathsAgree) {
+    const auto path = std::filesystem::temp_directory_path() / "fo_reader_test.bin";
+    std::string data(3 * 1024 * 1024 + 17, '\0');
+    for (std::size_t i = 0; i < data.size(); ++i) data[i] = static_cast<char>(i * 2654435761u >> 24);
+    std::ofstream(path, std::ios::binary).write(data.data(), static_cast<std::streamsize>(data.size()));
+
+    auto collect = [&](FileReader& reader, FileReader::Access access) {
+        std::string out;
+        EXPECT_TRUE(reader.open(path, access));
+        EXPECT_EQ(reader.size(), data.size());
+        EXPECT_TRUE(reader.for_each_block([&](std::span<const std::uint8_t> block) {
+            out.append(reinterpret_cast<const char*>(block.data()), block.size());
+        }));
+        return out;
+    };
+    FileReader mapping(1);
+    FileReader reading;
+    EXPECT_EQ(collect(mapping, FileReader::Access::Sequential), data);
+#ifndef _WIN32
+    EXPECT_TRUE(mapping.mapped());
+#endif
+    EXPECT_EQ(collect(reading, FileReader::Access::Sequential), data);
+    EXPECT_FALSE(reading.mapped());
+    EXPECT_EQ(collect(mapping, FileReader::Access::Sampled), data);
+
+    // Windows are clipped to the end of the file
+    auto tail = reading.read(data.size() - 10, 64);
+    EXPECT_EQ(std::string(reinterpret_cast<const char*>(tail.data()), tail.size()), data.substr(data.size() - 10));
+    EXPECT_TRUE(reading.read(data.size(), 64).empty());
+
+    EXPECT_FALSE(reading.open(path.parent_path() / "fo_reader_missing.bin", FileReader::Access::Sequential));
+    std::filesystem::remove(path);
+}
+
+TEST_F(HasherTest, HashExecutorUsesOneHasherPerWorker) {
+    auto hasher = Registry<IHasher>::instance().create("fast64");
+    ASSERT_NE(hasher, nullptr);
+    std::vector<FileInfo> files(300);
+    std::vector<HashBucket> buckets(3);
+    for (size_t i = 0; i < files.size(); ++i) {
+        files[i].path = test_file;
+        files[i].size = i;
+        buckets[i < 200 ? 0 : 1 + i % 2].files.push_back(&files[i]);
+    }
+
+    HashExecutor executor(4, 2);
+    std::mutex mtx;
+    std::set<IHasher*> used;
+    std::atomic<int> reading{0}, most_reading{0};
+    executor.run(buckets, *hasher, [&](IHasher& h, const FileInfo& f) {
+        {
+            std::lock_guard lk(mtx);
+            used.insert(&h);
+        }
+        return executor.read([&] {
+            const int now = ++reading;
+            for (int seen = most_reading; now > seen && !most_reading.compare_exchange_weak(seen, now);) {}
+            std::this_thread::yield();
+            --reading;
+            return std::to_string(f.size);
+        });
+    });
+
+    for (const auto& b : buckets) {
+        ASSERT_EQ(b.hashes.size(), b.files.size());
+        for (size_t i = 0; i < b.files.size(); ++i) EXPECT_EQ(b.hashes[i], std::to_string(b.files[i]->size));
+    }
+    EXPECT_EQ(used.count(hasher.get()), 0u);   // workers never share the caller's instance
+    EXPECT_LE(used.size(), 4u);
+    EXPECT_LE(most_reading.load(), 2);
+
+    // The first failure stops the run and reaches the caller
+    EXPECT_THROW(executor.run(buckets, *hasher, [](IHasher&, const FileInfo& f) -> std::string {
+        if (f.size == 150) throw std::runtime_error("unreadable");
+        return "x";
+    }), std::runtime_error);
+}
+
+TEST(XattrCacheTest, EncodesOneRecordPerAlgorithm) {
+    const std::string fast = "00000000deadbeef";
+    std::string attr = XattrCache::encode("", 100, "fast64", fast);
+    EXPECT_EQ(attr.size(), 1u + 8 + 1 + 6 + 1 + 1 + 8);   // the digest is stored in binary
+    attr = XattrCache::encode(attr, 100, "label", "not hex");
+    EXPECT_EQ(XattrCache::decode(attr, 100, "fast64"), fast);
+    EXPECT_EQ(XattrCache::decode(attr, 100, "label"), "not hex");
+    EXPECT_FALSE(XattrCache::decode(attr, 101, "fast64").has_value());
+
+    // Replacing a hash keeps the others; a new mtime drops all of them
+    attr = XattrCache::encode(attr, 100, "fast64", "1111111111111111");
+    EXPECT_EQ(XattrCache::decode(attr, 100, "fast64"), "1111111111111111");
+    EXPECT_EQ(XattrCache::decode(attr, 100, "label"), "not hex");
+    attr = XattrCache::encode(attr, 200, "fast64", fast);
+    EXPECT_FALSE(XattrCache::decode(attr, 200, "label").has_value());
+    EXPECT_EQ(XattrCache::decode(attr, 200, "fast64"), fast);
+
+    // Truncated or foreign data is ignored
+    EXPECT_FALSE(XattrCache::decode(attr.substr(0, attr.size() - 1), 200, "fast64").has_value());
+    EXPECT_FALSE(XattrCache::decode("fast64|x", 200, "fast64").has_value());
+}
+
+TEST_F(HasherTest, XattrSidecarCacheFollowsMtime) {
+#ifdef __linux__
+    auto cache = Registry<ISidecarHashCache>::instance().create("xattr");
+    ASSERT_NE(cache, nullptr);
+    if (!cache->set_hash(test_file, "fast64", "00000000deadbeef")) {
+        GTEST_SKIP() << "no user xattrs on " << test_file.parent_path();
+    }
+    EXPECT_EQ(cache->get_hash(test_file, "fast64"), "00000000deadbeef");
+    EXPECT_FALSE(cache->get_hash(test_file, "sha256").has_value());
+
+    std::filesystem::last_write_time(test_file, std::filesystem::last_write_time(test_file) + std::chrono::nanoseconds(1000));
+    EXPECT_FALSE(cache->get_hash(test_file, "fast64").has_value());
+#else
+    GTEST_SKIP() << "xattr cache is Linux-only";
+#endif
+}
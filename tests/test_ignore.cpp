@@ -0,0 +1,97 @@
+#include <gtest/gtest.h>
+#include "fo/core/engine.hpp"
+#include "fo/core/ignore_matcher.hpp"
+#include "fo/core/provider_registration.hpp"
+#include <filesystem>
+#include <fstream>
+
+using namespace fo::core;
+
+static IgnoreMatcher make_matcher(std::initializer_list<const char*> patterns) {
+    std::vector<IgnoreRule> rules;
+    for (auto* p : patterns) {
+        IgnoreRule r;
+        r.pattern = p;
+        rules.push_back(r);
+    }
+    return IgnoreMatcher(rules);
+}
+
+TEST(IgnoreMatcherTest, GlobsFollowGitignoreRules) {
+    auto m = make_matcher({"glob:node_modules/", "glob:*.tmp", "glob:/srv/cache/**", "glob:build/*.o", "glob:**/logs/*.[0-9]"});
+
+    EXPECT_TRUE(m.matches("/home/u/app/node_modules/react/index.js"));
+    EXPECT_FALSE(m.matches("/home/u/app/node_modules"));            // trailing slash: directories only
+    EXPECT_TRUE(m.prunes_directory("/home/u/app/node_modules"));
+    EXPECT_FALSE(m.matches("/home/u/app/node_modules_backup/a.js"));
+
+    EXPECT_TRUE(m.matches("/data/report.tmp"));
+    EXPECT_FALSE(m.matches("/data/report.tmp.txt"));
+    EXPECT_FALSE(m.matches("/data/tmp"));
+
+    EXPECT_TRUE(m.matches("/srv/cache/a/b.bin"));
+    EXPECT_FALSE(m.matches("/home/srv/cache/a.bin"));                // leading slash anchors
+    EXPECT_TRUE(m.prunes_directory("/srv/cache"));
+
+    EXPECT_TRUE(m.matches("/p/build/main.o"));
+    EXPECT_FALSE(m.matches("/p/build/sub/main.o"));                  // '*' stays in one component
+    EXPECT_FALSE(m.prunes_directory("/p/build"));
+
+    EXPECT_TRUE(m.matches("/var/app/logs/server.1"));
+    EXPECT_FALSE(m.matches("/var/app/logs/server.x"));
+}
+
+TEST(IgnoreMatcherTest, RegexAndLiteralPatternsKeepSearchSemantics) {
+    auto m = make_matcher({".git", "Thumbs.db", "\\.bak$", "[unclosed", "dir:/mnt/backup"});
+
+    // Regular expressions are searched anywhere, as before
+    EXPECT_TRUE(m.matches("/repo/.git/config"));
+    EXPECT_TRUE(m.matches("/pics/Thumbs.db"));
+    EXPECT_TRUE(m.matches("/docs/old.bak"));
+    EXPECT_FALSE(m.matches("/docs/old.bak/readme.txt"));
+    // Invalid expressions fall back to substrings
+    EXPECT_TRUE(m.matches("/odd/[unclosed/file"));
+
+    EXPECT_TRUE(m.matches("/mnt/backup"));
+    EXPECT_TRUE(m.matches("/mnt/backup/2024/a.jpg"));
+    EXPECT_FALSE(m.matches("/mnt/backup2/a.jpg"));
+
+    EXPECT_TRUE(m.prunes_directory("/repo/.git"));
+    EXPECT_TRUE(m.prunes_directory("/mnt/backup/2024"));
+    // "$" looks at the end of the path, so it must not prune a folder named like a file
+    EXPECT_FALSE(m.prunes_directory("/docs/old.bak"));
+    EXPECT_FALSE(m.prunes_directory("/docs"));
+
+    EXPECT_TRUE(make_matcher({}).empty());
+    EXPECT_FALSE(make_matcher({}).matches("/anything"));
+}
+
+TEST(IgnoreMatcherTest, EngineScanDoesNotDescendIntoIgnoredTrees) {
+    register_all_providers();
+    auto unique_id = std::to_string(std::chrono::steady_clock::now().time_since_epoch().count());
+    auto base = std::filesystem::temp_directory_path() / ("fo_ignore_" + unique_id);
+    auto root = base / "files";
+    std::filesystem::create_directories(root / "node_modules" / "pkg");
+    std::filesystem::create_directories(root / "src");
+    std::ofstream(root / "node_modules" / "pkg" / "index.js") << "x";
+    std::ofstream(root / "src" / "main.cpp") << "y";
+    std::ofstream(root / "src" / "main.cpp.tmp") << "z";
+
+    for (const char* scanner : {"std", "parallel"}) {
+        EngineConfig cfg;
+        cfg.scanner = scanner;
+        cfg.db_path = (base / (std::string(scanner) + ".db")).string();
+        Engine engine(cfg);
+        engine.ignore_repository().add("glob:node_modules/");
+        engine.ignore_repository().add("glob:*.tmp");
+
+        auto files = engine.scan({root}, {}, false);
+        ASSERT_EQ(files.size(), 1u) << scanner;
+        EXPECT_EQ(files[0].path.filename(), "main.cpp");
+        // Pruned before the scanner opened it, so it was never recorded
+        EXPECT_FALSE(engine.directory_repository().get_by_path(root / "node_modules").has_value()) << scanner;
+        EXPECT_TRUE(engine.directory_repository().get_by_path(root / "src").has_value()) << scanner;
+        EXPECT_TRUE(engine.ignore_repository().is_ignored((root / "src" / "main.cpp.tmp").string()));
+    }
+    std::filesystem::remove_all(base);
+}
@@ -1,8 +1,15 @@
 #include <gtest/gtest.h>
 #include "fo/core/engine.hpp"
 #include "fo/core/export.hpp"
+#include "fo/core/file_identity.hpp"
+#include "fo/core/provider_registration.hpp"
+#ifdef __linux__
+#include "fo/core/file_watcher.hpp"
+#endif
+#include <algorithm>
 #include <filesystem>
 #include <fstream>
+#include <future>
 #include <sstream>
 
 using namespace fo::core;
@@ -71,6 +78,171 @@ TEST_F(IntegrationTest, FindDuplicatesWithIdenticalContent) {
     EXPECT_EQ(duplicates[0].files.size(), 3);
 }
 
+TEST_F(IntegrationTest, FindDuplicatesReusesStoredHashes) {
+    create_file(test_dir / "a.txt", "first pair");
+    create_file(test_dir / "b.txt", "first pair");
+    create_file(test_dir / "c.txt", "second pair, longer");
+    create_file(test_dir / "d.txt", "second pair, longer");
+    create_file(test_dir / "e.txt", "alone in its size class");
+
+    EngineConfig cfg;
+    cfg.db_path = db_path.string();
+    Engine engine(cfg);
+    auto& repo = engine.file_repository();
+    auto& dups = engine.duplicate_repository();
+    auto id_of = [&](const char* name) { return repo.get_by_path(test_dir / name)->id; };
+
+    ASSERT_EQ(engine.find_duplicates(engine.scan({test_dir}, {}, false)).size(), 2u);
+    auto groups = dups.get_all_groups();
+    ASSERT_EQ(groups.size(), 2u);
+    auto second = std::find_if(groups.begin(), groups.end(), [&](const DuplicateGroupDB& g) {
+        return g.primary_file_id == id_of("c.txt") || g.primary_file_id == id_of("d.txt");
+    });
+    ASSERT_NE(second, groups.end());
+    const int64_t second_id = second->id;
+    // Only files that share their size were hashed
+    EXPECT_TRUE(repo.get_hash(id_of("a.txt"), "fast64").has_value());
+    EXPECT_FALSE(repo.get_hash(id_of("e.txt"), "fast64").has_value());
+
+    // Stored hashes are trusted while the token matches: a.txt is not read
+    // again, so a wrong stored value splits the first pair. A new copy joins
+    // the second group in place.
+    const auto a = *repo.get_by_path(test_dir / "a.txt");
+    repo.add_hash(a.id, "fast64", "0123456789abcdef", ChangeToken::of(a));
+    create_file(test_dir / "f.txt", "second pair, longer");
+    auto found = engine.find_duplicates(engine.scan({test_dir}, {}, false));
+    ASSERT_EQ(found.size(), 1u);
+    EXPECT_EQ(found[0].files.size(), 3u);
+    groups = dups.get_all_groups();
+    ASSERT_EQ(groups.size(), 1u);
+    EXPECT_EQ(groups[0].id, second_id);
+    EXPECT_EQ(groups[0].member_ids.size(), 3u);
+
+    // A changed file loses its hash on rescan and is read again, together
+    // with the files it now shares a size with
+    create_file(test_dir / "a.txt", "alone in its size class");
+    found = engine.find_duplicates(engine.scan({test_dir}, {}, false));
+    ASSERT_EQ(found.size(), 2u);
+    EXPECT_TRUE(repo.get_hash(id_of("e.txt"), "fast64").has_value());
+    EXPECT_EQ(*repo.get_hash(id_of("a.txt"), "fast64"), *repo.get_hash(id_of("e.txt"), "fast64"));
+    groups = dups.get_all_groups();
+    ASSERT_EQ(groups.size(), 2u);
+    EXPECT_TRUE(std::any_of(groups.begin(), groups.end(), [&](const DuplicateGroupDB& g) { return g.id == second_id; }));
+}
+
+TEST_F(IntegrationTest, ReplacedFileWithSameSizeAndMtimeIsHashedAgain) {
+    create_file(test_dir / "a.txt", "same length 1");
+    create_file(test_dir / "b.txt", "same length 1");
+
+    EngineConfig cfg;
+    cfg.db_path = db_path.string();
+    Engine engine(cfg);   // the std scanner records no dev/ino
+    auto& repo = engine.file_repository();
+    ASSERT_EQ(engine.find_duplicates(engine.scan({test_dir}, {}, false)).size(), 1u);
+    const auto a = *repo.get_by_path(test_dir / "a.txt");
+    const auto stored = repo.get_hashes_by_algo("fast64");
+    ASSERT_FALSE(stored.empty());
+    for (const auto& h : stored) {
+        ASSERT_TRUE(h.token.has_value());
+        EXPECT_NE(h.token->ino, 0u);
+    }
+
+    // A different inode with the same size and mtime takes a.txt's place, as
+    // cp -p or rsync -t followed by a rename would leave it
+    create_file(test_dir / "new.tmp", "same length 2");
+    std::filesystem::last_write_time(test_dir / "new.tmp", std::filesystem::last_write_time(test_dir / "a.txt"));
+    std::filesystem::rename(test_dir / "new.tmp", test_dir / "a.txt");
+
+    EXPECT_TRUE(engine.find_duplicates(engine.scan({test_dir}, {}, false)).empty());
+    auto token = ChangeToken::of(*repo.get_by_path(test_dir / "a.txt"));
+    EXPECT_TRUE(repo.get_cached_hash(a.id, "fast64", token).has_value());
+}
+
+TEST_F(IntegrationTest, ParallelHashingFindsTheSameGroups) {
+    // 150 files of one size, more than one executor chunk, plus a few pairs
+    for (int i = 0; i < 150; ++i) create_file(test_dir / ("same" + std::to_string(i) + ".txt"), "content " + std::to_string(i % 5 + 100));
+    for (int i = 0; i < 20; ++i) create_file(test_dir / ("pair" + std::to_string(i) + ".txt"), std::string(static_cast<size_t>(i / 2 + 1), 'p'));
+
+    auto groups_with = [&](unsigned jobs, unsigned io_jobs, const char* db) {
+        EngineConfig cfg;
+        cfg.db_path = (base_dir / db).string();
+        cfg.hash_jobs = jobs;
+        cfg.hash_io_jobs = io_jobs;
+        Engine engine(cfg);
+        std::vector<std::vector<std::string>> groups;
+        for (const auto& g : engine.find_duplicates(engine.scan({test_dir}, {}, false))) {
+            auto& names = groups.emplace_back();
+            for (const auto& f : g.files) names.push_back(f.path.filename().string());
+            std::sort(names.begin(), names.end());
+        }
+        std::sort(groups.begin(), groups.end());
+        // Every hashed file was stored
+        EXPECT_EQ(engine.database().query_int("SELECT COUNT(*) FROM file_hashes;"), 170);
+        return groups;
+    };
+    const auto sequential = groups_with(1, 0, "sequential.db");
+    ASSERT_EQ(sequential.size(), 15u);
+    EXPECT_EQ(groups_with(8, 0, "parallel.db"), sequential);
+    EXPECT_EQ(groups_with(8, 1, "one_reader.db"), sequential);
+}
+
+TEST_F(IntegrationTest, MultiStageFinderEliminatesByStage) {
+    register_all_providers();
+    create_file(test_dir / "alone.txt", "abc");
+    const std::string small(100, 's');
+    create_file(test_dir / "s1.txt", small);
+    create_file(test_dir / "s2.txt", small);
+    create_file(test_dir / "s3.txt", std::string(99, 's') + "t");
+    std::string large(20000, ' ');
+    for (size_t i = 0; i < large.size(); ++i) large[i] = static_cast<char>('a' + i % 26);
+    auto changed_at = [&](size_t pos) { auto s = large; s[pos] = '#'; return s; };
+    create_file(test_dir / "a1.txt", large);
+    create_file(test_dir / "a2.txt", large);
+    create_file(test_dir / "a3.txt", changed_at(0));       // differs in the head
+    create_file(test_dir / "a4.txt", changed_at(19999));   // ...in the last window
+    create_file(test_dir / "a5.txt", changed_at(6000));    // ...where no window looks
+    std::filesystem::create_hard_link(test_dir / "a1.txt", test_dir / "a1_link.txt");
+
+    EngineConfig cfg;
+    cfg.db_path = db_path.string();
+    cfg.finder = "multistage";
+    cfg.hash_jobs = 2;
+    Engine engine(cfg);
+    auto groups = engine.find_duplicates(engine.scan({test_dir}, {}, false));
+
+    std::vector<std::string> names;
+    for (const auto& g : groups) {
+        for (const auto& f : g.files) names.push_back(f.path.filename().string());
+        for (const auto& f : g.links) names.push_back(f.path.filename().string() + " (link)");
+    }
+    std::sort(names.begin(), names.end());
+    ASSERT_EQ(groups.size(), 2u);
+    EXPECT_EQ(names.size(), 5u);
+    EXPECT_EQ(std::count(names.begin(), names.end(), "s1.txt") + std::count(names.begin(), names.end(), "s2.txt"), 2);
+    EXPECT_EQ(std::count(names.begin(), names.end(), "a2.txt"), 1);
+    EXPECT_EQ(engine.duplicate_repository().get_all_groups().size(), 2u);
+
+    ASSERT_NE(engine.finder(), nullptr);
+    const auto stats = engine.finder()->stage_stats();
+    ASSERT_EQ(stats.size(), 4u);
+    EXPECT_EQ(stats[0].stage, "size");
+    EXPECT_EQ(stats[0].candidates, 10u);
+    EXPECT_EQ(stats[0].remaining, 8u);      // alone.txt gone, the hardlink folded
+    EXPECT_EQ(stats[1].stage, "head");
+    EXPECT_EQ(stats[1].remaining, 6u);      // s3, a3
+    EXPECT_EQ(stats[1].bytes_read, 3u * 100 + 5u * 4096);
+    EXPECT_EQ(stats[2].candidates, 4u);     // the 100-byte files were read whole
+    EXPECT_EQ(stats[2].remaining, 3u);      // a4
+    EXPECT_EQ(stats[3].candidates, 3u);
+    EXPECT_EQ(stats[3].remaining, 2u);      // a5
+    EXPECT_EQ(stats[3].bytes_read, 3u * 20000);
+
+    cfg.finder = "no-such-finder";
+    cfg.db_path = (base_dir / "other.db").string();
+    Engine unknown(cfg);
+    EXPECT_THROW(unknown.find_duplicates({}), std::runtime_error);
+}
+
 TEST_F(IntegrationTest, ExportToJsonAndVerifyStructure) {
     create_file(test_dir / "doc1.txt", "document one");
     create_file(test_dir / "doc2.txt", "document two");
@@ -192,3 +364,412 @@ TEST_F(IntegrationTest, ExportToFileCreatesValidJson) {
     std::string content((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
     EXPECT_TRUE(content.find("\"stats\"") != std::string::npos);
 }
+
+TEST_F(IntegrationTest, StreamingScanDeliversBoundedBatches) {
+    const size_t total_files = IFileScanner::kScanBatchSize + 17;
+    for (size_t i = 0; i < total_files; ++i) {
+        create_file(test_dir / ("d" + std::to_string(i % 8)) / ("f" + std::to_string(i) + ".txt"), "x");
+    }
+
+    for (const char* scanner : {"std", "parallel"}) {
+        EngineConfig cfg;
+        cfg.scanner = scanner;
+        cfg.db_path = (base_dir / (std::string(scanner) + ".db")).string();
+        Engine engine(cfg);
+
+        size_t batches = 0;
+        size_t seen = 0;
+        size_t returned = engine.scan({test_dir}, {}, false, false, [&](std::vector<FileInfo>& batch) {
+            ++batches;
+            seen += batch.size();
+            EXPECT_LE(batch.size(), IFileScanner::kScanBatchSize);
+            for (const auto& f : batch) EXPECT_NE(f.id, 0);
+        });
+
+        EXPECT_EQ(returned, total_files) << scanner;
+        EXPECT_EQ(seen, total_files) << scanner;
+        EXPECT_GE(batches, 2u) << scanner;
+    }
+}
+
+TEST_F(IntegrationTest, StreamingRescanKeepsIdOfMovedFile) {
+    create_file(test_dir / "a" / "photo.jpg", "moved content");
+    create_file(test_dir / "keep.txt", "stays");
+    // The catalog keeps whole-second mtimes; move matching compares against them
+    auto whole_second = std::chrono::clock_cast<std::chrono::file_clock>(
+        std::chrono::floor<std::chrono::seconds>(std::chrono::system_clock::now()));
+    std::filesystem::last_write_time(test_dir / "a" / "photo.jpg", whole_second);
+
+    EngineConfig cfg;
+    cfg.db_path = db_path.string();
+    Engine engine(cfg);
+
+    engine.scan({test_dir}, {}, false);
+    auto before = engine.file_repository().get_by_path(test_dir / "a" / "photo.jpg");
+    ASSERT_TRUE(before.has_value());
+
+    std::filesystem::create_directories(test_dir / "b");
+    std::filesystem::rename(test_dir / "a" / "photo.jpg", test_dir / "b" / "photo.jpg");
+
+    size_t seen = 0;
+    engine.scan({test_dir}, {}, false, true, [&](std::vector<FileInfo>& batch) { seen += batch.size(); });
+    EXPECT_EQ(seen, 2u);
+
+    auto after = engine.file_repository().get_by_path(test_dir / "b" / "photo.jpg");
+    ASSERT_TRUE(after.has_value());
+    EXPECT_EQ(after->id, before->id);
+    EXPECT_FALSE(engine.file_repository().get_by_path(test_dir / "a" / "photo.jpg").has_value());
+}
+
+TEST_F(IntegrationTest, IncrementalScanSkipsUnchangedDirectories) {
+    create_file(test_dir / "top.txt", "top");
+    create_file(test_dir / "a" / "x.txt", "x");
+    create_file(test_dir / "b" / "y.txt", "y");
+    // Directories modified in the last seconds are never trusted; age them
+    auto old = std::filesystem::file_time_type::clock::now() - std::chrono::hours(1);
+    for (auto dir : {test_dir, test_dir / "a", test_dir / "b"}) std::filesystem::last_write_time(dir, old);
+
+    std::vector<std::string> scanners = {"std", "dirent", "parallel"};
+#ifdef __linux__
+    scanners.insert(scanners.end(), {"linux", "uring"});
+#endif
+    for (const auto& scanner : scanners) {
+        EngineConfig cfg;
+        cfg.scanner = scanner;
+        cfg.incremental_dirs = true;
+        cfg.db_path = (base_dir / (scanner + ".db")).string();
+        Engine engine(cfg);
+
+        auto first = engine.scan({test_dir}, {}, false, true);
+        ASSERT_EQ(first.size(), 3u) << scanner;
+        auto x_before = engine.file_repository().get_by_path(test_dir / "a" / "x.txt");
+        ASSERT_TRUE(x_before.has_value());
+        auto a_state = engine.directory_repository().get_by_path(test_dir / "a");
+        ASSERT_TRUE(a_state.has_value());
+        EXPECT_NE(a_state->mtime_ns, 0);
+        EXPECT_EQ(a_state->child_count, 1);
+
+        // "a" gets a file behind the scan's back (its mtime is restored), "b" really changes
+        create_file(test_dir / "a" / "hidden.txt", "hidden");
+        std::filesystem::last_write_time(test_dir / "a", old);
+        create_file(test_dir / "b" / "new.txt", "new");
+
+        std::vector<std::string> names;
+        engine.scan({test_dir}, {}, false, true, [&](std::vector<FileInfo>& batch) {
+            for (const auto& f : batch) {
+                EXPECT_NE(f.id, 0);
+                names.push_back(f.path.filename().string());
+                if (f.path.filename() == "x.txt") { EXPECT_EQ(f.id, x_before->id); }
+            }
+        });
+        std::sort(names.begin(), names.end());
+        EXPECT_EQ(names, (std::vector<std::string>{"new.txt", "top.txt", "x.txt", "y.txt"})) << scanner;
+        EXPECT_TRUE(engine.file_repository().get_by_path(test_dir / "a" / "x.txt").has_value());
+
+        // Without reuse every directory is read again
+        EngineConfig full = cfg;
+        full.incremental_dirs = false;
+        Engine full_engine(full);
+        EXPECT_EQ(full_engine.scan({test_dir}, {}, false, true).size(), 5u) << scanner;
+
+        std::filesystem::remove(test_dir / "a" / "hidden.txt");
+        std::filesystem::remove(test_dir / "b" / "new.txt");
+        for (auto dir : {test_dir / "a", test_dir / "b"}) std::filesystem::last_write_time(dir, old);
+    }
+}
+
+TEST_F(IntegrationTest, ApplyChangesKeepsCatalogInSync) {
+    const std::string same = "same content for both files";
+    create_file(test_dir / "a.txt", same);
+    create_file(test_dir / "b.txt", same);
+    create_file(test_dir / "sub" / "c.txt", "c");
+
+    EngineConfig cfg;
+    cfg.db_path = db_path.string();
+    Engine engine(cfg);
+    auto& repo = engine.file_repository();
+
+    auto files = engine.scan({test_dir}, {}, false);
+    ASSERT_EQ(engine.find_duplicates(files).size(), 1u);
+    auto a = repo.get_by_path(test_dir / "a.txt");
+    ASSERT_TRUE(a.has_value());
+    repo.add_hash(a->id, "fast64", "abc");
+
+    // Modify a.txt, add d.txt, rename sub/ and remove b.txt
+    create_file(test_dir / "a.txt", "now different and longer");
+    create_file(test_dir / "d.txt", "d");
+    std::filesystem::rename(test_dir / "sub", test_dir / "moved");
+    std::filesystem::remove(test_dir / "b.txt");
+
+    std::vector<FileChange> changes(4);
+    changes[0].kind = FileChange::Kind::Modified;
+    changes[0].path = test_dir / "a.txt";
+    changes[1].kind = FileChange::Kind::Created;
+    changes[1].path = test_dir / "d.txt";
+    changes[2].kind = FileChange::Kind::Renamed;
+    changes[2].old_path = test_dir / "sub";
+    changes[2].path = test_dir / "moved";
+    changes[2].is_dir = true;
+    changes[3].kind = FileChange::Kind::Removed;
+    changes[3].path = test_dir / "b.txt";
+
+    auto st = engine.apply_changes(changes, {});
+    EXPECT_EQ(st.updated, 2u);
+    EXPECT_EQ(st.renamed, 1u);
+    EXPECT_EQ(st.removed, 1u);
+
+    auto a2 = repo.get_by_path(test_dir / "a.txt");
+    ASSERT_TRUE(a2.has_value());
+    EXPECT_EQ(a2->id, a->id);
+    EXPECT_TRUE(repo.get_hashes(a->id).empty());
+    EXPECT_TRUE(engine.duplicate_repository().get_all_groups().empty());
+    EXPECT_TRUE(repo.get_by_path(test_dir / "d.txt").has_value());
+    EXPECT_FALSE(repo.get_by_path(test_dir / "b.txt").has_value());
+    EXPECT_FALSE(repo.get_by_path(test_dir / "sub" / "c.txt").has_value());
+    EXPECT_TRUE(repo.get_by_path(test_dir / "moved" / "c.txt").has_value());
+
+    // A directory moved in from elsewhere is walked; one removed takes its files along
+    create_file(base_dir / "outside" / "e.txt", "e");
+    std::filesystem::rename(base_dir / "outside", test_dir / "incoming");
+    std::filesystem::remove_all(test_dir / "moved");
+    std::vector<FileChange> more(2);
+    more[0].kind = FileChange::Kind::Renamed;
+    more[0].old_path = base_dir / "outside";
+    more[0].path = test_dir / "incoming";
+    more[1].kind = FileChange::Kind::Removed;
+    more[1].path = test_dir / "moved";
+    st = engine.apply_changes(more, {});
+    EXPECT_EQ(st.updated, 1u);
+    EXPECT_EQ(st.removed, 1u);
+    EXPECT_TRUE(repo.get_by_path(test_dir / "incoming" / "e.txt").has_value());
+    EXPECT_FALSE(repo.get_by_path(test_dir / "moved" / "c.txt").has_value());
+}
+
+TEST_F(IntegrationTest, ApplyChangesRenamesNonAsciiDirectory) {
+    const std::filesystem::path old_dir = test_dir / std::filesystem::path(u8"Café");
+    const std::filesystem::path new_dir = test_dir / std::filesystem::path(u8"Ünïcode");
+    create_file(old_dir / "x.txt", "x");
+    create_file(old_dir / "deep" / "y.txt", "y");
+
+    EngineConfig cfg;
+    cfg.db_path = db_path.string();
+    Engine engine(cfg);
+    auto& repo = engine.file_repository();
+    engine.scan({test_dir}, {}, false);
+    auto x = repo.get_by_path(old_dir / "x.txt");
+    auto y = repo.get_by_path(old_dir / "deep" / "y.txt");
+    ASSERT_TRUE(x.has_value());
+    ASSERT_TRUE(y.has_value());
+
+    std::filesystem::rename(old_dir, new_dir);
+    std::vector<FileChange> changes(1);
+    changes[0].kind = FileChange::Kind::Renamed;
+    changes[0].old_path = old_dir;
+    changes[0].path = new_dir;
+    changes[0].is_dir = true;
+    EXPECT_EQ(engine.apply_changes(changes, {}).renamed, 1u);
+
+    auto x2 = repo.get_by_path(new_dir / "x.txt");
+    auto y2 = repo.get_by_path(new_dir / "deep" / "y.txt");
+    ASSERT_TRUE(x2.has_value());
+    ASSERT_TRUE(y2.has_value());
+    EXPECT_EQ(x2->id, x->id);
+    EXPECT_EQ(y2->id, y->id);
+    EXPECT_FALSE(repo.get_by_path(old_dir / "x.txt").has_value());
+}
+
+#ifdef __linux__
+TEST_F(IntegrationTest, InotifyWatcherReportsChanges) {
+    create_file(test_dir / "old.txt", "x");
+    std::filesystem::create_directories(test_dir / "dir");
+    FileWatcher watcher({test_dir}, FileWatcher::Backend::Inotify);
+    EXPECT_EQ(watcher.backend_name(), "inotify");
+
+    create_file(test_dir / "dir" / "new.txt", "y");
+    std::filesystem::rename(test_dir / "old.txt", test_dir / "renamed.txt");
+    std::filesystem::rename(test_dir / "dir", test_dir / "dir2");
+    create_file(test_dir / "dir2" / "later.txt", "z");   // seen through the moved watch
+
+    std::vector<FileChange> changes;
+    for (int i = 0; i < 10 && watcher.poll(changes, 100) > 0;) ++i;
+
+    auto has = [&](FileChange::Kind kind, const std::filesystem::path& p) {
+        return std::any_of(changes.begin(), changes.end(), [&](const FileChange& c) {
+            return c.kind == kind && c.path == p;
+        });
+    };
+    EXPECT_TRUE(has(FileChange::Kind::Modified, test_dir / "dir" / "new.txt"));
+    EXPECT_TRUE(has(FileChange::Kind::Renamed, test_dir / "renamed.txt"));
+    EXPECT_TRUE(has(FileChange::Kind::Renamed, test_dir / "dir2"));
+    EXPECT_TRUE(has(FileChange::Kind::Modified, test_dir / "dir2" / "later.txt"));
+}
+#endif
+
+TEST_F(IntegrationTest, InterruptedScanResumesFromCheckpoint) {
+    // More than one scanner batch, so a checkpoint lands before the failure
+    for (int d = 0; d < 50; ++d) {
+        auto dir = test_dir / ("d" + std::to_string(d));
+        std::filesystem::create_directories(dir);
+        for (int f = 0; f < 100; ++f) std::ofstream(dir / ("f" + std::to_string(f) + ".txt")) << "x";
+    }
+
+    EngineConfig cfg;
+    cfg.db_path = db_path.string();
+    cfg.checkpoint_files = 1;
+    {
+        Engine engine(cfg);
+        int batches = 0;
+        EXPECT_THROW(engine.scan({test_dir}, {}, false, true, [&](std::vector<FileInfo>&) {
+            if (++batches == 2) throw std::runtime_error("interrupted");
+        }), std::runtime_error);
+    }
+
+    cfg.resume_scans = true;
+    Engine engine(cfg);
+    auto& db = engine.database();
+    const int session = db.query_int("SELECT MAX(id) FROM scan_sessions;");
+    auto progress = engine.session_repository().get_progress(session);
+    ASSERT_LT(progress.size(), 51u);
+    auto done = std::find_if(progress.begin(), progress.end(), [&](const auto& p) { return p.first != test_dir; });
+    ASSERT_NE(done, progress.end());
+
+    // Rewriting a file leaves its directory's mtime alone, so a resumed scan
+    // takes the completed directory from the catalog without reading it
+    auto done_dir = done->first;
+    std::ofstream(done_dir / "f0.txt") << "rewritten";
+    std::ofstream(test_dir / "d_new.txt") << "new";
+
+    auto files = engine.scan({test_dir}, {}, false, true);
+    EXPECT_EQ(files.size(), 5001u);
+    auto it = std::find_if(files.begin(), files.end(), [&](const FileInfo& f) { return f.path == done_dir / "f0.txt"; });
+    ASSERT_NE(it, files.end());
+    EXPECT_EQ(it->size, 1u);
+
+    EXPECT_EQ(db.query_int("SELECT MAX(id) FROM scan_sessions;"), session);
+    EXPECT_EQ(db.query_int("SELECT COUNT(*) FROM scan_progress;"), 0);
+
+    // Nothing left to resume: the next scan starts over and reads everything
+    files = engine.scan({test_dir}, {}, false, true);
+    it = std::find_if(files.begin(), files.end(), [&](const FileInfo& f) { return f.path == done_dir / "f0.txt"; });
+    ASSERT_NE(it, files.end());
+    EXPECT_EQ(it->size, 9u);
+    EXPECT_GT(db.query_int("SELECT MAX(id) FROM scan_sessions;"), session);
+}
+
+TEST_F(IntegrationTest, HardlinksAreNotReportedAsDuplicates) {
+    std::string content = "shared content for hardlink testing";
+    create_file(test_dir / "a" / "original.txt", content);
+    std::filesystem::create_directories(test_dir / "b");
+    std::filesystem::create_hard_link(test_dir / "a" / "original.txt", test_dir / "b" / "link.txt");
+    create_file(test_dir / "c" / "linked_only.txt", "only linked, never copied");
+    std::filesystem::create_hard_link(test_dir / "c" / "linked_only.txt", test_dir / "c" / "link2.txt");
+
+    std::vector<std::string> scanners = {"std"};
+#ifdef __linux__
+    scanners.push_back("linux");
+#endif
+    for (const auto& scanner : scanners) {
+        EngineConfig cfg;
+        cfg.scanner = scanner;
+        cfg.db_path = (base_dir / (scanner + ".db")).string();
+        Engine engine(cfg);
+
+        // Two names of one inode are one physical file: nothing is duplicated yet
+        auto files = engine.scan({test_dir}, {}, false);
+        EXPECT_TRUE(engine.find_duplicates(files).empty()) << scanner;
+
+        create_file(test_dir / "copy.txt", content);
+        files = engine.scan({test_dir}, {}, false);
+        auto groups = engine.find_duplicates(files);
+        ASSERT_EQ(groups.size(), 1u) << scanner;
+        ASSERT_EQ(groups[0].files.size(), 2u) << scanner;
+        ASSERT_EQ(groups[0].links.size(), 1u) << scanner;
+        FileInfo original;
+        original.path = test_dir / "a" / "original.txt";
+        EXPECT_EQ(file_identity(groups[0].links[0]).ino, file_identity(original).ino) << scanner;
+        std::filesystem::remove(test_dir / "copy.txt");
+    }
+
+#ifdef __linux__
+    // Scanners that read the inode record it in the catalog
+    EngineConfig cfg;
+    cfg.db_path = (base_dir / "linux.db").string();
+    Engine reopened(cfg);
+    auto stored = reopened.file_repository().get_by_path(test_dir / "b" / "link.txt");
+    ASSERT_TRUE(stored.has_value());
+    EXPECT_NE(stored->ino, 0u);
+    EXPECT_EQ(stored->nlink, 2u);
+#endif
+}
+
+TEST_F(IntegrationTest, SnapshotRescanWritesOnlyChanges) {
+    for (int i = 0; i < 20; ++i) create_file(test_dir / "d" / ("f" + std::to_string(i) + ".txt"), "content " + std::to_string(i));
+
+    EngineConfig cfg;
+    cfg.db_path = db_path.string();
+    cfg.snapshot_index = true;
+    Engine engine(cfg);
+    auto first = engine.scan({test_dir}, {}, false, true);
+    ASSERT_EQ(first.size(), 20u);
+    auto kept_id = engine.file_repository().get_by_path(test_dir / "d" / "f1.txt")->id;
+    auto changed_id = engine.file_repository().get_by_path(test_dir / "d" / "f2.txt")->id;
+
+    create_file(test_dir / "d" / "f2.txt", "longer content than before");
+    std::filesystem::remove(test_dir / "d" / "f3.txt");
+    create_file(test_dir / "d" / "new.txt", "brand new file");
+
+    auto second = engine.scan({test_dir}, {}, false, true);
+    EXPECT_EQ(second.size(), 20u);
+    for (const auto& f : second) EXPECT_NE(f.id, 0) << f.path;
+
+    auto kept = engine.file_repository().get_by_path(test_dir / "d" / "f1.txt");
+    ASSERT_TRUE(kept.has_value());
+    EXPECT_EQ(kept->id, kept_id);
+    auto changed = engine.file_repository().get_by_path(test_dir / "d" / "f2.txt");
+    ASSERT_TRUE(changed.has_value());
+    EXPECT_EQ(changed->id, changed_id);
+    EXPECT_EQ(changed->size, std::string("longer content than before").size());
+    EXPECT_FALSE(engine.file_repository().get_by_path(test_dir / "d" / "f3.txt").has_value());
+    EXPECT_TRUE(engine.file_repository().get_by_path(test_dir / "d" / "new.txt").has_value());
+    EXPECT_EQ(engine.file_repository().load_snapshot({test_dir}).size(), 20u);
+}
+
+TEST_F(IntegrationTest, ReadersSeeCommittedCatalogDuringWrites) {
+    for (int i = 0; i < 5; ++i) create_file(test_dir / ("f" + std::to_string(i) + ".txt"), "x" + std::to_string(i));
+
+    EngineConfig cfg;
+    cfg.db_path = db_path.string();
+    cfg.reader_connections = 2;
+    Engine engine(cfg);
+    engine.scan({test_dir}, {}, false);
+
+    // A write transaction stays open on this thread while another one reads
+    auto write_lock = engine.database().lock_writes();
+    engine.database().execute("BEGIN TRANSACTION;");
+    FileInfo pending;
+    pending.path = test_dir / "uncommitted.txt";
+    engine.file_repository().upsert(pending);
+
+    auto read = std::async(std::launch::async, [&] {
+        auto lease = engine.reader();
+        FileRepository files(lease.db());
+        EXPECT_TRUE(files.get_by_path(test_dir / "f0.txt").has_value());
+        EXPECT_FALSE(files.get_by_path(test_dir / "uncommitted.txt").has_value());
+        EXPECT_THROW(lease->execute("DELETE FROM files;"), std::runtime_error);
+        return lease->query_int("SELECT COUNT(*) FROM files;");
+    });
+    ASSERT_EQ(read.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+    EXPECT_EQ(read.get(), 5);
+
+    engine.database().execute("COMMIT;");
+    write_lock.unlock();
+
+    {
+        auto a = engine.reader();
+        auto b = engine.reader();
+        EXPECT_NE(&a.db(), &b.db());
+        EXPECT_EQ(a->query_int("SELECT COUNT(*) FROM files;"), 6);
+    }
+    auto again = engine.reader();   // returned connections are reused
+    EXPECT_EQ(again->query_int("SELECT COUNT(*) FROM files;"), 6);
+}
@@ -2,8 +2,14 @@
 #include "fo/core/registry.hpp"
 #include "fo/core/interfaces.hpp"
 #include "fo/core/provider_registration.hpp"
+#include "fo/core/uring_stat.hpp"
 #include <fstream>
 #include <filesystem>
+#include <algorithm>
+#ifdef __linux__
+#include <unistd.h>
+#include <cerrno>
+#endif
 
 using namespace fo::core;
 
@@ -97,6 +103,129 @@ TEST_F(ScannerTest, DirentScannerExists) {
     ASSERT_NE(scanner, nullptr);
 }
 
+TEST_F(ScannerTest, ParallelScannerExists) {
+    auto scanner = Registry<IFileScanner>::instance().create("parallel");
+    ASSERT_NE(scanner, nullptr);
+}
+
+TEST_F(ScannerTest, ParallelScannerMatchesStd) {
+    // Widen the tree so several workers have directories to steal
+    for (int d = 0; d < 8; ++d) {
+        auto sub = test_dir / ("deep" + std::to_string(d)) / "nested";
+        std::filesystem::create_directories(sub);
+        std::ofstream(sub / "leaf.txt") << "leaf" << d;
+    }
+
+    auto std_scanner = Registry<IFileScanner>::instance().create("std");
+    auto par_scanner = Registry<IFileScanner>::instance().create("parallel");
+    ASSERT_NE(par_scanner, nullptr);
+    par_scanner->set_threads(4);
+
+    auto expected = std_scanner->scan({test_dir}, {".txt"}, false);
+    auto actual = par_scanner->scan({test_dir}, {".txt"}, false);
+
+    auto by_path = [](const FileInfo& a, const FileInfo& b) { return a.path < b.path; };
+    std::sort(expected.begin(), expected.end(), by_path);
+    std::sort(actual.begin(), actual.end(), by_path);
+
+    ASSERT_EQ(actual.size(), expected.size());
+    for (size_t i = 0; i < actual.size(); ++i) {
+        EXPECT_EQ(actual[i].path, expected[i].path);
+        EXPECT_EQ(actual[i].size, expected[i].size);
+        EXPECT_EQ(actual[i].mtime, expected[i].mtime);
+    }
+}
+
+#ifdef __linux__
+TEST_F(ScannerTest, LinuxScannerMatchesStd) {
+    std::filesystem::create_symlink(test_dir / "file1.txt", test_dir / "link.txt");
+    std::filesystem::create_directory_symlink(test_dir / "subdir", test_dir / "subdir_link");
+
+    auto std_scanner = Registry<IFileScanner>::instance().create("std");
+    auto linux_scanner = Registry<IFileScanner>::instance().create("linux");
+    ASSERT_NE(linux_scanner, nullptr);
+
+    for (bool follow : {false, true}) {
+        auto expected = std_scanner->scan({test_dir}, {".TXT"}, follow);
+        auto actual = linux_scanner->scan({test_dir}, {".TXT"}, follow);
+
+        auto by_path = [](const FileInfo& a, const FileInfo& b) { return a.path < b.path; };
+        std::sort(expected.begin(), expected.end(), by_path);
+        std::sort(actual.begin(), actual.end(), by_path);
+
+        ASSERT_EQ(actual.size(), expected.size()) << "follow_symlinks=" << follow;
+        for (size_t i = 0; i < actual.size(); ++i) {
+            EXPECT_EQ(actual[i].path, expected[i].path);
+            EXPECT_EQ(actual[i].size, expected[i].size);
+            EXPECT_EQ(actual[i].mtime, expected[i].mtime);
+        }
+    }
+}
+
+TEST_F(ScannerTest, UringScannerMatchesStd) {
+    std::filesystem::create_symlink(test_dir / "file1.txt", test_dir / "link.txt");
+    std::filesystem::create_directory_symlink(test_dir / "subdir", test_dir / "subdir_link");
+
+    auto std_scanner = Registry<IFileScanner>::instance().create("std");
+    auto uring_scanner = Registry<IFileScanner>::instance().create("uring");
+    ASSERT_NE(uring_scanner, nullptr);
+
+    for (bool follow : {false, true}) {
+        auto expected = std_scanner->scan({test_dir}, {".TXT"}, follow);
+        auto actual = uring_scanner->scan({test_dir}, {".TXT"}, follow);
+
+        auto by_path = [](const FileInfo& a, const FileInfo& b) { return a.path < b.path; };
+        std::sort(expected.begin(), expected.end(), by_path);
+        std::sort(actual.begin(), actual.end(), by_path);
+
+        ASSERT_EQ(actual.size(), expected.size()) << "follow_symlinks=" << follow;
+        for (size_t i = 0; i < actual.size(); ++i) {
+            EXPECT_EQ(actual[i].path, expected[i].path);
+            EXPECT_EQ(actual[i].size, expected[i].size);
+            EXPECT_EQ(actual[i].mtime, expected[i].mtime);
+        }
+    }
+}
+
+TEST_F(ScannerTest, UringStatBatchMatchesSyncFallback) {
+    // Queue depth 2 forces several submit/reap rounds for the 4 ops
+    UringStatBatch ring(2);
+    UringStatBatch sync(2, true);
+    EXPECT_FALSE(sync.uses_uring());
+
+    const std::string dir = test_dir.string();
+    const char* names[] = {"file1.txt", "file2.jpg", "subdir", "missing"};
+
+    auto run = [&](UringStatBatch& b) {
+        std::vector<UringStatBatch::OpenOp> opens(1);
+        opens[0].path = dir.c_str();
+        b.open_all(opens);
+        EXPECT_GE(opens[0].result, 0);
+
+        std::vector<struct statx> out(4);
+        std::vector<UringStatBatch::StatOp> ops(4);
+        for (size_t i = 0; i < ops.size(); ++i) {
+            ops[i].dirfd = opens[0].result;
+            ops[i].path = names[i];
+            ops[i].mask = STATX_TYPE | STATX_SIZE;
+            ops[i].out = &out[i];
+        }
+        b.stat_all(ops);
+        close(opens[0].result);
+
+        std::vector<std::pair<int, uint64_t>> res;
+        for (size_t i = 0; i < ops.size(); ++i) res.emplace_back(ops[i].result, ops[i].result == 0 ? out[i].stx_size : 0);
+        return res;
+    };
+
+    auto a = run(ring);
+    auto b = run(sync);
+    EXPECT_EQ(a, b);
+    EXPECT_EQ(b[0], std::make_pair(0, uint64_t{8}));
+    EXPECT_EQ(b[3].first, -ENOENT);
+}
+#endif
+
 TEST_F(ScannerTest, ListAvailableScanners) {
     auto names = Registry<IFileScanner>::instance().names();
     